@@ -2,16 +2,32 @@
 
 #include "vm_6502.h"
 #include "compiler_6502.h"
+#include "benchmark_6502.h"
+#include "verify_6502.h"
+#include "fusion_6502.h"
+#include "recompiler_6502.h"
+#include "tools_6502.h"
+#include "hypercall_6502.h"
 
 #define REND_ADDR 0x8F00
 #define AMOUNT 12
 
-int main()
+int main(int argc, char* argv[])
 {
+	if (argc > 1)
+	{
+		return run_tool(argc, argv);
+	}
+
 	ram ram_0;
+#ifdef CMOS_6502
+	cpu cpu_0(ram_0, cpu_variant::cmos);
+#else
 	cpu cpu_0(ram_0);
+#endif // CMOS_6502
 	compiler cmplr;
 
+	register_standard_hypercalls(cpu_0);
 	if (cmplr.compile_and_build("input.txt", cpu_0))
 	{
 		timer tm;
@@ -20,6 +36,10 @@ int main()
 		cpu_0.start();
 		tm.stop();
 		std::cout << "\nCPU running time: " << tm.elapsed_milliseconds() << "ms.\n";
+		if (cpu_0.trap == trap_code::unknown_op)
+		{
+			std::cout << std::hex << "Stopped on unknown operator " << u16(ram_0[cpu_0.trap_pc]) << " at " << cpu_0.trap_pc << ".\n" << std::dec;
+		}
 		ram_0.write_to("memory_shapshot.bin");
 	}
 
@@ -27,6 +47,9 @@ int main()
 	std::cout << "a: " << (int)cpu_0.a << '\n';
 	std::cout << "x: " << (int)cpu_0.x << '\n';
 	std::cout << "y: " << (int)cpu_0.y << '\n';
+#ifdef CYCLES_6502
+	std::cout << "cycles: " << cpu_0.cycles << '\n';
+#endif // CYCLES_6502
 
 	std::cout << "\nZero page:\n";
 	for (u64 i = 0; i < AMOUNT; i++)
@@ -34,6 +57,44 @@ int main()
 		std::cout << i << ":\t" << (int)ram_0[i] << '\n';
 	}
 
+#ifdef VERIFY_6502
+	verify_generated_ops();
+	verify_decimal();
+	verify_cycles();
+	verify_fused_pairs();
+	verify_jit_blocks();
+	verify_run_until();
+	verify_disassembler();
+	verify_banks("bank.txt");
+	verify_shared_image("input.txt");
+	verify_dirty_pages("idiom.txt");
+	verify_file_hypercalls();
+#endif // VERIFY_6502
+
+#ifdef RECOMPILED_6502
+	verify_recompiled("input.txt", recompiled_program);
+#endif // RECOMPILED_6502
+
+#ifdef PAIR_STATS_6502
+	report_pair_stats("input.txt");
+#endif // PAIR_STATS_6502
+
+#ifdef BENCHMARK_6502
+	benchmark_dispatch("input.txt");
+	benchmark_run_until("input.txt");
+	benchmark_alu("alu.txt");
+	benchmark_idle("idle.txt");
+	benchmark_events("idle.txt");
+	benchmark_idioms("idiom.txt");
+	benchmark_memo("memo.txt");
+	benchmark_hypercalls("hypercall.txt");
+	benchmark_bus("alu.txt");
+	benchmark_disassembler("input.txt");
+	benchmark_banks("bank.txt");
+	benchmark_shared_image("input.txt");
+	benchmark_reset("input.txt");
+#endif // BENCHMARK_6502
+
 	system("pause");
 	return 0;
 }
@@ -0,0 +1,34 @@
+#include <algorithm>
+
+#include "bank_6502.h"
+
+static u8 bank_register_read(void* context, u16)
+{
+	return u8(static_cast<bank_window*>(context)->selected);
+}
+
+static void bank_register_write(void* context, u16, u8 value)
+{
+	static_cast<bank_window*>(context)->select(value);
+}
+
+bank_window::bank_window(ram& mem, u8 first, u8 last, u32 banks, u8 register_page)
+	: mem(mem), first(first), last(last), register_page(register_page), banks(std::clamp<u32>(banks, 1, BANK_MAX_COUNT))
+{
+	store.resize(u64(this->banks) * bank_bytes());
+	bank_select = { &bank_register_read, &bank_register_write, this };
+	mem.map_device(register_page, register_page, &bank_select);
+	select(0);
+}
+
+bank_window::~bank_window()
+{
+	mem.unmap(first, last);
+	mem.unmap(register_page, register_page);
+}
+
+void bank_window::select(u32 index)
+{
+	selected = index % banks;
+	mem.map_memory(first, last, bank(selected));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+
+#include "vm_6502.h"
+
+// Banked memory: a backing store of several banks, each the size of a window - whole pages of the address space.
+// The window shows one bank at a time, a program selects it by writing the bank number to the bank-select register
+// and reads the register for the selected bank. The register answers on its whole page, as boards decode it partially,
+// bank numbers wrap at bank count.
+// Selecting points the window pages of the page table at the bank in the store (ram::map_memory), nothing is copied:
+// a switch costs one pointer pair per window page however big the store is, reads and writes go straight to the store.
+// Window and register page are mapped pages, so code and pointers stay out of them and jit steps aside (see ram).
+// Windows with their own register pages may share one ram, a window must not outlive it.
+
+constexpr u32 BANK_MAX_COUNT = 256;	// selected by one byte
+
+struct bank_window
+{
+	ram& mem;
+	u8 first = 0;					// window pages
+	u8 last = 0;
+	u8 register_page = 0;			// bank-select register
+	u32 banks = 1;
+	u32 selected = 0;
+	std::vector<u8> store = {};		// bank after bank, zeros at start
+	bus_device bank_select = {};	// context is this window
+
+	// 'banks' is clamped to 1..BANK_MAX_COUNT, bank 0 is selected
+	bank_window(ram& mem, u8 first, u8 last, u32 banks, u8 register_page);
+
+	// window and register page go back to their own bytes in 'data'
+	~bank_window();
+
+	bank_window(const bank_window&) = delete;
+	bank_window& operator = (const bank_window&) = delete;
+
+	u32 bank_bytes() const { return (last - first + 1) * RAM_PAGE_SIZE; }
+
+	// bytes of bank 'index' in the store, for the host to fill or inspect
+	u8* bank(u32 index) { return store.data() + u64(index) * bank_bytes(); }
+
+	// window shows bank 'index' modulo bank count, as a register write does
+	void select(u32 index);
+};
@@ -0,0 +1,677 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "benchmark_6502.h"
+#include "recompiler_6502.h"
+#include "idiom_6502.h"
+#include "memo_6502.h"
+#include "hypercall_6502.h"
+#include "events_6502.h"
+#include "disasm_6502.h"
+#include "bank_6502.h"
+
+// dispatch as it was before op_table: two hash lookups and a std::function call per operator
+using legacy_op_map = std::unordered_map<u8, std::function<void(cpu& cpu_ref)>>;
+
+static u64 start_legacy(cpu& c, const legacy_op_map& legacy_map)
+{
+	u64 executed = 0;
+	for (u8 op = c.mem[c.pc]; !c.k; op = c.next_byte(), executed++)
+	{
+		if (legacy_map.find(op) == legacy_map.end())
+		{
+			std::cerr << std::hex << "Unknown operator \'" << u16(op) << "\' at \'" << c.pc << "\'\n" << std::dec;
+			return executed;
+		}
+		legacy_map.at(op)(c);
+	}
+	return executed;
+}
+
+static void print_result(const std::string& name, double ms, u64 executed)
+{
+	std::cout << name << ":\t" << ms << "ms, " << executed << " operators";
+	if (ms > 0.0)
+	{
+		std::cout << ", " << u64(executed / ms / 1000.0) << "M op/s";
+	}
+	std::cout << '\n';
+}
+
+// runs through cpu::start, so 'executed' is taken from the legacy run of the same program
+static void time_engine(const std::string& name, run_engine engine, cpu& c, const ram& image, const ram& expected, u32 runs, u64 executed)
+{
+	timer tm;
+
+	c.engine = engine;
+	memcpy(c.mem.data, image.data, MAX_RAM_BYTES);
+	c.flush_decoded();
+	tm.start();
+	for (u32 run = 0; run < runs; run++)
+	{
+		c.reset();
+		c.start();
+	}
+	tm.stop();
+	print_result(name, tm.elapsed_milliseconds(), executed);
+
+	if (memcmp(expected.data, c.mem.data, MAX_RAM_BYTES) != 0)
+	{
+		std::cerr << "Engine \"" << name << "\" disagrees with unordered_map on final memory.\n";
+	}
+}
+
+// recompiled_program only runs when 'image' is the one it was recompiled from, otherwise it's the interpreter again
+static void time_recompiled(cpu& c, const ram& image, const ram& expected, u32 runs, u64 executed)
+{
+	timer tm;
+
+	c.engine = run_engine::loop;
+	memcpy(c.mem.data, image.data, MAX_RAM_BYTES);
+	c.flush_decoded();
+	tm.start();
+	for (u32 run = 0; run < runs; run++)
+	{
+		c.reset();
+		run_recompiled(c, recompiled_program);
+	}
+	tm.stop();
+	print_result("recompiled", tm.elapsed_milliseconds(), executed);
+
+	if (memcmp(expected.data, c.mem.data, MAX_RAM_BYTES) != 0)
+	{
+		std::cerr << "Recompiled program disagrees with unordered_map on final memory.\n";
+	}
+}
+
+void benchmark_dispatch(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	legacy_op_map legacy_map = {};
+	for (const auto& [code, handler] : cpu::op_map)
+	{
+		legacy_map[code] = handler;
+	}
+
+	std::cout << "\nDispatch benchmark, " << runs << " runs of \"" << path << "\":\n";
+
+	u64 executed = 0;
+	memcpy(work.data, image.data, MAX_RAM_BYTES);
+	tm.start();
+	for (u32 run = 0; run < runs; run++)
+	{
+		cpu_0.reset();
+		executed += start_legacy(cpu_0, legacy_map);
+	}
+	tm.stop();
+	print_result("unordered_map", tm.elapsed_milliseconds(), executed);
+
+	ram legacy_result;
+	memcpy(legacy_result.data, work.data, MAX_RAM_BYTES);
+
+	time_engine("op_table", run_engine::loop, cpu_0, image, legacy_result, runs, executed);
+	time_engine("threaded", run_engine::threaded, cpu_0, image, legacy_result, runs, executed);
+	time_engine("predecoded", run_engine::predecoded, cpu_0, image, legacy_result, runs, executed);
+	time_engine("fused", run_engine::fused, cpu_0, image, legacy_result, runs, executed);
+	time_engine("jit", run_engine::jit, cpu_0, image, legacy_result, runs, executed);
+	time_engine("cached", run_engine::cached, cpu_0, image, legacy_result, runs, executed);
+	time_recompiled(cpu_0, image, legacy_result, runs, executed);
+}
+
+// the same as time_engine, but every run is cut into run_until calls of 'limits' until the program stops
+static void time_sliced(const std::string& name, run_engine engine, cpu& c, const ram& image, const ram& expected, u32 runs, u64 executed, const run_limits& limits)
+{
+	timer tm;
+	u64 calls = 0;
+
+	c.engine = engine;
+	memcpy(c.mem.data, image.data, MAX_RAM_BYTES);
+	c.flush_decoded();
+	tm.start();
+	for (u32 run = 0; run < runs; run++)
+	{
+		c.reset();
+		for (run_exit exit = run_exit::budget; exit == run_exit::budget; calls++)
+		{
+			exit = c.run_until(limits);
+		}
+	}
+	tm.stop();
+	print_result(name, tm.elapsed_milliseconds(), executed);
+	std::cout << "\t" << calls / runs << " run_until calls per run\n";
+
+	if (memcmp(expected.data, c.mem.data, MAX_RAM_BYTES) != 0)
+	{
+		std::cerr << "Engine \"" << name << "\" disagrees with op_table on final memory.\n";
+	}
+}
+
+void benchmark_run_until(const std::string& path, u64 slice, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+
+	// a scheduler's time slice, in cycles when they are counted
+	run_limits limits;
+	if constexpr (COUNT_CYCLES)
+	{
+		limits.cycles = slice;
+	}
+	else
+	{
+		limits.operators = slice;
+	}
+
+	std::cout << "\nrun_until benchmark, " << runs << " runs of \"" << path << "\" in slices of " << slice << (COUNT_CYCLES ? " cycles" : " operators") << ":\n";
+	for (const auto& [name, engine] : { std::pair{ "predecoded", run_engine::predecoded }, std::pair{ "jit", run_engine::jit } })
+	{
+		time_engine(name, engine, cpu_0, image, expected, runs, per_run * runs);
+		time_sliced(std::string(name) + " sliced", engine, cpu_0, image, expected, runs, per_run * runs, limits);
+	}
+}
+
+void benchmark_alu(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	// one run through op_table gives operator count and expected memory
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+
+	std::cout << "\nALU benchmark, " << runs << " runs of \"" << path << "\":\n";
+	time_engine("op_table", run_engine::loop, cpu_0, image, expected, runs, per_run * runs);
+	time_engine("threaded", run_engine::threaded, cpu_0, image, expected, runs, per_run * runs);
+	time_engine("predecoded", run_engine::predecoded, cpu_0, image, expected, runs, per_run * runs);
+	time_engine("cached", run_engine::cached, cpu_0, image, expected, runs, per_run * runs);
+}
+
+void benchmark_idle(const std::string& path, i32 operators)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	std::cout << "\nIdle loop benchmark, " << operators << " operators of \"" << path << "\":\n";
+	cpu_0.engine = run_engine::predecoded;
+	for (bool skip : { false, true })
+	{
+		memcpy(work.data, image.data, MAX_RAM_BYTES);
+		cpu_0.skip_idle = skip;
+		cpu_0.flush_decoded();
+		cpu_0.reset();
+		tm.start();
+		cpu_0.start(operators);
+		tm.stop();
+		print_result(skip ? "skipped" : "run", tm.elapsed_milliseconds(), operators);
+	}
+}
+
+void benchmark_idioms(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+
+	std::cout << "\nIdiom benchmark, " << runs << " runs of \"" << path << "\":\n";
+	time_engine("op_table", run_engine::loop, cpu_0, image, expected, runs, per_run * runs);
+	cpu_0.run_idioms = false;
+	time_engine("interpreted", run_engine::predecoded, cpu_0, image, expected, runs, per_run * runs);
+	cpu_0.run_idioms = true;
+	cpu_0.idiom_runs = {};
+	time_engine("native", run_engine::predecoded, cpu_0, image, expected, runs, per_run * runs);
+	report_idioms(cpu_0);
+}
+
+void benchmark_memo(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+
+	std::cout << "\nMemoization benchmark, " << runs << " runs of \"" << path << "\":\n";
+	time_engine("op_table", run_engine::loop, cpu_0, image, expected, runs, per_run * runs);
+	time_engine("predecoded", run_engine::predecoded, cpu_0, image, expected, runs, per_run * runs);
+	cpu_0.memoize = true;
+	time_engine("memoized", run_engine::predecoded, cpu_0, image, expected, runs, per_run * runs);
+	report_memo(cpu_0);
+}
+
+void benchmark_hypercalls(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	// one run through op_table per setup, the program computes the same either way
+	u64 per_run[2] = {};
+	ram expected[2];
+	for (u32 native = 0; native < 2; native++)
+	{
+		cpu_0.hypercalls = {};
+		if (native)
+		{
+			register_standard_hypercalls(cpu_0);
+		}
+		memcpy(work.data, image.data, MAX_RAM_BYTES);
+		cpu_0.reset();
+		for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run[native]++)
+		{
+			cpu_0.exe_op(op);
+		}
+		memcpy(expected[native].data, work.data, MAX_RAM_BYTES);
+	}
+	// stack page keeps return addresses of the fallback's JSR
+	if (memcmp(expected[0].data, expected[1].data, RAM_PAGE_SIZE) != 0
+		|| memcmp(expected[0].data + 2 * RAM_PAGE_SIZE, expected[1].data + 2 * RAM_PAGE_SIZE, MAX_RAM_BYTES - 2 * RAM_PAGE_SIZE) != 0)
+	{
+		std::cerr << "Hypercalls and their 6502 fallback leave different memory.\n";
+	}
+
+	std::cout << "\nHypercall benchmark, " << runs << " runs of \"" << path << "\":\n";
+	cpu_0.hypercalls = {};
+	time_engine("6502", run_engine::predecoded, cpu_0, image, expected[0], runs, per_run[0] * runs);
+	register_standard_hypercalls(cpu_0);
+	time_engine("hypercall", run_engine::predecoded, cpu_0, image, expected[1], runs, per_run[1] * runs);
+}
+
+// device of benchmark_events, ticks every 'period' cycles
+struct bench_timer
+{
+	u64 period = 0;
+	u64 next = 0;
+	u64 ticks = 0;
+};
+
+static void bench_tick(cpu& c, void* device)
+{
+	bench_timer& timer = *static_cast<bench_timer*>(device);
+	timer.ticks++;
+	timer.next += timer.period;
+	schedule_event(c, timer.next, &bench_tick, device);
+}
+
+void benchmark_events(const std::string& path, u64 cycles, u64 period)
+{
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+
+	if constexpr (!COUNT_CYCLES)
+	{
+		std::cout << "\nEvent benchmark needs CYCLES_6502.\n";
+		return;
+	}
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	u16 entry = cpu_0.pc;
+
+	std::cout << "\nEvent benchmark, " << cycles << " cycles of \"" << path << "\" with a timer every " << period << " cycles:\n";
+	cpu_0.engine = run_engine::predecoded;
+	for (bool scheduled : { false, true })
+	{
+		bench_timer device{ period, period, 0 };
+		cpu_0.reset();
+		cpu_0.pc = entry;
+		cpu_0.flush_decoded();
+		tm.start();
+		if (scheduled)
+		{
+			schedule_event(cpu_0, device.next, &bench_tick, &device);
+			run_limits limits;
+			limits.cycles = cycles;
+			cpu_0.run_until(limits);
+		}
+		else
+		{
+			// the device is polled before every operator, and once more at the end as run_until does
+			for (;;)
+			{
+				if (cpu_0.cycles >= device.next)
+				{
+					device.ticks++;
+					device.next += device.period;
+				}
+				if (cpu_0.cycles >= cycles || cpu_0.k)
+				{
+					break;
+				}
+				cpu_0.start(1);
+			}
+		}
+		tm.stop();
+		std::cout << (scheduled ? "scheduled" : "polled") << ":\t" << tm.elapsed_milliseconds() << "ms, " << device.ticks << " ticks\n";
+	}
+}
+
+// device of benchmark_bus, never accessed
+static u8 idle_device_read(void*, u16)
+{
+	return 0;
+}
+
+void benchmark_bus(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	bus_device device = { &idle_device_read, nullptr, nullptr };
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+
+	std::cout << "\nBus benchmark, " << runs << " runs of \"" << path << "\", plain memory and a device on pages C0..C7:\n";
+	for (bool mapped : { false, true })
+	{
+		if (mapped)
+		{
+			work.map_device(0xC0, 0xC7, &device);
+		}
+		std::string suffix = mapped ? " mapped" : "";
+		time_engine("op_table" + suffix, run_engine::loop, cpu_0, image, expected, runs, per_run * runs);
+		time_engine("cached" + suffix, run_engine::cached, cpu_0, image, expected, runs, per_run * runs);
+	}
+	work.unmap(0x00, 0xFF);
+}
+
+void benchmark_banks(const std::string& path, u32 runs, u32 switches)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+
+	bank_window window(work, 0x80, 0xBF, BANK_MAX_COUNT, 0xDF);
+	std::cout << "\nBank benchmark, " << BANK_MAX_COUNT << " banks of " << window.bank_bytes() << " bytes (" << window.store.size() / (1024 * 1024) << " MiB store):\n";
+
+	// a switch remaps the window pages, copying a bank into the window is what it replaces
+	tm.start();
+	for (u32 i = 0; i < switches; i++)
+	{
+		window.select(i);
+	}
+	tm.stop();
+	std::cout << "select:\t" << tm.elapsed_milliseconds() << "ms for " << switches << " switches\n";
+
+	tm.start();
+	for (u32 i = 0; i < switches; i++)
+	{
+		memcpy(work.data + 0x8000, window.bank(i % BANK_MAX_COUNT), window.bank_bytes());
+	}
+	tm.stop();
+	std::cout << "copy:\t" << tm.elapsed_milliseconds() << "ms for " << switches << " bank copies\n";
+
+	// the program switches 512 times per run and fills the whole store
+	u64 per_run = 0;
+	for (u8 op = work[cpu_0.pc]; !cpu_0.k; op = cpu_0.next_byte(), per_run++)
+	{
+		cpu_0.exe_op(op);
+	}
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+	time_engine("op_table", run_engine::loop, cpu_0, image, expected, runs, per_run * runs);
+	time_engine("cached", run_engine::cached, cpu_0, image, expected, runs, per_run * runs);
+}
+
+void benchmark_shared_image(const std::string& path, u32 instances)
+{
+	ram image_source;
+	cpu cpu_0(image_source);
+	compiler cmplr;
+	timer tm;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	ram_image image(image_source);
+
+	std::cout << "\nShared image benchmark, " << instances << " instances of \"" << path << "\" alive at once, each run once:\n";
+	if (!image.available())
+	{
+		std::cout << "Shared ram image is not available, instances get private copies.\n";
+	}
+	for (bool shared : { false, true })
+	{
+		std::vector<std::unique_ptr<ram>> alive;
+		alive.reserve(instances);
+		tm.start();
+		for (u32 i = 0; i < instances; i++)
+		{
+			if (shared)
+			{
+				alive.push_back(std::make_unique<ram>(image));
+			}
+			else
+			{
+				alive.push_back(std::make_unique<ram>());
+				memcpy(alive.back()->data, image_source.data, MAX_RAM_BYTES);
+			}
+			cpu cpu_1(*alive.back());
+			cpu_1.start();
+		}
+		tm.stop();
+
+		// 4K pages an instance holds on its own, at least those that differ from the image
+		u32 written = 0;
+		for (u32 page = 0; page < MAX_RAM_BYTES; page += BENCHMARK_OS_PAGE_BYTES)
+		{
+			written += memcmp(alive.front()->data + page, image_source.data + page, BENCHMARK_OS_PAGE_BYTES) != 0;
+		}
+		u32 private_bytes = alive.front()->shared ? written * BENCHMARK_OS_PAGE_BYTES : MAX_RAM_BYTES;
+		std::cout << (shared ? "shared:\t" : "private:\t") << tm.elapsed_milliseconds() << "ms, "
+			<< u64(private_bytes) * instances / 1024 << "K of memory for instances\n";
+	}
+}
+
+void benchmark_reset(const std::string& path, u32 runs)
+{
+	ram image;
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+	memcpy(image.data, work.data, MAX_RAM_BYTES);
+	cpu_0.engine = run_engine::predecoded;
+	cpu_0.start();
+	u32 dirty = work.dirty_count();
+
+	std::cout << "\nReset benchmark, " << runs << " runs of \"" << path << "\" back to the built image, " << dirty << " dirty pages per run:\n";
+	ram expected;
+	memcpy(expected.data, work.data, MAX_RAM_BYTES);
+	for (bool restore : { false, true })
+	{
+		memcpy(work.data, image.data, MAX_RAM_BYTES);
+		work.clean();
+		tm.start();
+		for (u32 run = 0; run < runs; run++)
+		{
+			if (restore)
+			{
+				work.restore(image);
+			}
+			else
+			{
+				memcpy(work.data, image.data, MAX_RAM_BYTES);
+			}
+			cpu_0.reset();
+			cpu_0.start();
+		}
+		tm.stop();
+		std::cout << (restore ? "dirty pages:\t" : "whole image:\t") << tm.elapsed_milliseconds() << "ms\n";
+
+		if (memcmp(expected.data, work.data, MAX_RAM_BYTES) != 0)
+		{
+			std::cerr << "Reset by " << (restore ? "dirty pages" : "whole image") << " leaves different memory.\n";
+		}
+	}
+}
+
+void benchmark_disassembler(const std::string& path, u32 runs)
+{
+	ram work;
+	cpu cpu_0(work);
+	compiler cmplr;
+	timer tm;
+	static char buffer[DISASM_BUFFER_BYTES];
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+
+	std::cout << "\nDisassembler benchmark, " << runs << " runs over " << MAX_RAM_BYTES << " bytes:\n";
+	for (bool random : { false, true })
+	{
+		if (random)
+		{
+			std::mt19937 rng(1);
+			for (u32 i = 0; i < MAX_RAM_BYTES; i++)
+			{
+				work[i] = u8(rng());
+			}
+		}
+
+		// one run counted aside, the timed ones only write
+		u64 chars = 0;
+		u64 lines = 0;
+		for (u64 done = 0; done < MAX_RAM_BYTES;)
+		{
+			u64 consumed = 0;
+			u64 written = disassemble(work.data + done, MAX_RAM_BYTES - done, u16(done), buffer, sizeof(buffer), consumed);
+			lines += std::count(buffer, buffer + written, '\n');
+			chars += written;
+			done += consumed;
+		}
+
+		tm.start();
+		for (u32 run = 0; run < runs; run++)
+		{
+			for (u64 done = 0; done < MAX_RAM_BYTES;)
+			{
+				u64 consumed = 0;
+				disassemble(work.data + done, MAX_RAM_BYTES - done, u16(done), buffer, sizeof(buffer), consumed);
+				done += consumed;
+			}
+		}
+		tm.stop();
+
+		double seconds = tm.elapsed_milliseconds() / 1000.0;
+		std::cout << (random ? "random bytes" : "\"" + path + "\"") << ":\t" << tm.elapsed_milliseconds() << "ms, "
+			<< u64(runs * double(MAX_RAM_BYTES) / seconds / 1'000'000) << "M bytes/s, " << u64(runs * double(lines) / seconds / 1'000'000) << "M lines/s, "
+			<< lines << " lines and " << chars << " chars per run\n";
+	}
+}
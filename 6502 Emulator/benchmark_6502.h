@@ -0,0 +1,99 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include "vm_6502.h"
+#include "compiler_6502.h"
+#include "timer.h"
+
+//#define BENCHMARK_6502
+
+constexpr u32 BENCHMARK_RUNS = 200'000;
+constexpr u32 BENCHMARK_ALU_RUNS = 20'000;
+constexpr i32 BENCHMARK_IDLE_OPERATORS = 30'000'000;
+constexpr u32 BENCHMARK_IDIOM_RUNS = 2'000;
+constexpr u32 BENCHMARK_MEMO_RUNS = 200;
+constexpr u32 BENCHMARK_HYPERCALL_RUNS = 100;
+constexpr u64 BENCHMARK_RUN_SLICE = 100;
+constexpr u64 BENCHMARK_EVENT_CYCLES = 100'000'000;
+constexpr u64 BENCHMARK_EVENT_PERIOD = 1'000;
+constexpr u32 BENCHMARK_DISASM_RUNS = 200;
+constexpr u32 BENCHMARK_BANK_RUNS = 2'000;
+constexpr u32 BENCHMARK_BANK_SWITCHES = 10'000'000;
+constexpr u32 BENCHMARK_INSTANCES = 4'096;
+constexpr u32 BENCHMARK_OS_PAGE_BYTES = 4'096;	// copy-on-write granularity of ram_image on x86 and x64
+
+/// <summary>
+/// Compiles 'path' once, then runs the program 'runs' times with every dispatch engine.
+/// Memory is restored from the built image before each engine, program must be restartable (as input.txt is).
+/// </summary>
+void benchmark_dispatch(const std::string& path, u32 runs = BENCHMARK_RUNS);
+
+/// <summary>
+/// Runs 'path' as a time-sliced vm would: cpu::run_until with a budget of 'slice' cycles (operators without CYCLES_6502)
+/// called until the program stops, against one cpu::start, on predecoded and jit engines.
+/// </summary>
+void benchmark_run_until(const std::string& path, u64 slice = BENCHMARK_RUN_SLICE, u32 runs = BENCHMARK_RUNS);
+
+/// <summary>
+/// Per operator cost of ALU-heavy code ('path' is alu.txt) on engines running handlers,
+/// mostly cost of flag updates, see lazy flags in vm_6502.h.
+/// </summary>
+void benchmark_alu(const std::string& path, u32 runs = BENCHMARK_ALU_RUNS);
+
+/// <summary>
+/// Runs 'operators' of idle loops ('path' is idle.txt) on predecoded engine with and without cpu::skip_idle.
+/// </summary>
+void benchmark_idle(const std::string& path, i32 operators = BENCHMARK_IDLE_OPERATORS);
+
+/// <summary>
+/// Copy, fill, multiply and divide loops ('path' is idiom.txt) on predecoded engine with and without cpu::run_idioms.
+/// </summary>
+void benchmark_idioms(const std::string& path, u32 runs = BENCHMARK_IDIOM_RUNS);
+
+/// <summary>
+/// Calls of a pure subroutine ('path' is memo.txt) on predecoded engine with and without cpu::memoize.
+/// </summary>
+void benchmark_memo(const std::string& path, u32 runs = BENCHMARK_MEMO_RUNS);
+
+/// <summary>
+/// Multiplies ('path' is hypercall.txt) by HYP and by the 6502 fallback, on predecoded engine.
+/// </summary>
+void benchmark_hypercalls(const std::string& path, u32 runs = BENCHMARK_HYPERCALL_RUNS);
+
+/// <summary>
+/// Runs 'cycles' of 'path' (idle.txt, it ends spinning on memory) on predecoded engine with a timer device ticking every 'period' cycles,
+/// polled before every operator and scheduled as an event of cpu::run_until. Needs CYCLES_6502.
+/// </summary>
+void benchmark_events(const std::string& path, u64 cycles = BENCHMARK_EVENT_CYCLES, u64 period = BENCHMARK_EVENT_PERIOD);
+
+/// <summary>
+/// Runs 'path' (alu.txt) on engines running handlers with plain memory, then with a device mapped over pages the program doesn't touch:
+/// memory pages cost the same either way, only a device page pays for its callback. Jit would step aside while a page is mapped.
+/// </summary>
+void benchmark_bus(const std::string& path, u32 runs = BENCHMARK_ALU_RUNS);
+
+/// <summary>
+/// Times 'switches' bank switches of a 16K window over a BANK_MAX_COUNT bank store against copying a bank per switch,
+/// then runs 'path' (bank.txt, it fills and reads back every bank) 'runs' times on engines running handlers.
+/// </summary>
+void benchmark_banks(const std::string& path, u32 runs = BENCHMARK_BANK_RUNS, u32 switches = BENCHMARK_BANK_SWITCHES);
+
+/// <summary>
+/// Builds 'path' (input.txt) once and makes 'instances' rams of it, all alive at once and each run once,
+/// from a ram_image and as private copies. Reports time and memory the instances take: 64K each when private,
+/// the 4K pages an instance wrote when shared (counted where it differs from the image, a lower bound).
+/// </summary>
+void benchmark_shared_image(const std::string& path, u32 instances = BENCHMARK_INSTANCES);
+
+/// <summary>
+/// Runs 'path' (input.txt, a short job touching few pages) 'runs' times on predecoded engine, putting memory back
+/// to the built image before each run by copying all of it and by ram::restore of the dirty pages.
+/// </summary>
+void benchmark_reset(const std::string& path, u32 runs = BENCHMARK_RUNS);
+
+/// <summary>
+/// Disassembles the whole memory 'runs' times into a DISASM_BUFFER_BYTES buffer, once with 'path' built in it (mostly zeros, one byte BRK lines)
+/// and once filled with random bytes (dense, mixed lengths). Reports bytes and lines per second.
+/// </summary>
+void benchmark_disassembler(const std::string& path, u32 runs = BENCHMARK_DISASM_RUNS);
@@ -225,15 +225,13 @@ finish_compilation:;
 
 bool compiler::compile_and_build(const std::string& path, cpu& cpu_ref)
 {
+	variant = cpu_ref.variant;
 	if (compile(path))
 	{
 		u16 addr = 0x0200;
 
+		// after a build and a run only the pages they wrote are cleared
 		cpu_ref.mem.clear();
-		cpu_ref.mem[0xFFFF] = op::KIL;
-		cpu_ref.mem[0xFFFC] = op::JSR_ABS;
-		cpu_ref.mem[0xFFFD] = 0x00;
-		cpu_ref.mem[0xFFFE] = 0x02;
 		for (const source_line& line : source_lines)
 		{
 			for (u8 i = 0; i < line.byte_size; i++)
@@ -241,12 +239,27 @@ bool compiler::compile_and_build(const std::string& path, cpu& cpu_ref)
 				cpu_ref.mem[addr++] = line.bytes[i];
 			}
 		}
-		cpu_ref.mem[addr++] = op::RTS;
+		cpu_ref.mem.mark_dirty(0x02, u8(addr >> BIT_SIZE));
+		write_start_up(cpu_ref.mem, addr);
+		cpu_ref.flush_decoded();
 		return true;
 	}
 	return false;
 }
 
+void compiler::write_start_up(ram& mem, u16 program_end)
+{
+	mem[START_UP_ADDR] = op::JSR_ABS;
+	mem[START_UP_ADDR + 1] = 0x00;
+	mem[START_UP_ADDR + 2] = 0x02;
+	mem[START_UP_ADDR + 3] = op::KIL;
+	mem[RESET_VECTOR] = u8(START_UP_ADDR);
+	mem[RESET_VECTOR + 1] = u8(START_UP_ADDR >> BIT_SIZE);
+	mem[program_end] = op::RTS;
+	mem.mark_dirty(u8(program_end >> BIT_SIZE), u8(program_end >> BIT_SIZE));
+	mem.mark_dirty(0xFF, 0xFF);
+}
+
 void compiler::resolve_defines()
 {
 	std::smatch define_match = {};
@@ -315,7 +328,7 @@ void compiler::read_labels()
 		if (std::regex_match(line.text, label_match, mask::LABEL_DECL))
 		{
 			name = label_match.str(1);
-			if (op_map.find(name) == op_map.end())
+			if (find_op(name) == nullptr)
 			{
 				labels[name] = ABSENT_LABEL;
 #ifdef DEBUG_6502_COMP
@@ -326,7 +339,7 @@ void compiler::read_labels()
 		else if (std::regex_match(line.text, label_match, mask::CORRECT_OP))
 		{
 			name = label_match.str(2);
-			if (name != "" && op_map.find(name) == op_map.end())
+			if (name != "" && find_op(name) == nullptr)
 			{
 				labels[name] = ABSENT_LABEL;
 #ifdef DEBUG_6502_COMP
@@ -353,7 +366,7 @@ bool compiler::parse_active_line()
 	{
 		label = line_match.str(1);
 
-		if (op_map.find(label) == op_map.end())
+		if (find_op(label) == nullptr)
 		{
 			if (label != "")
 			{
@@ -415,13 +428,16 @@ bool compiler::parse_active_line()
 
 bool compiler::parse_op(const std::string& op)
 {
-	// handle JMP and BRK here
-
-	if (op_map.find(op) != op_map.end())
+	if (const op_modes* modes = find_op(op, variant))
 	{
-		active_line->parsed_op = op_map.at(op);
+		active_line->parsed_op = *modes;
 		return true;
 	}
+	else if (find_op(op) != nullptr)
+	{
+		errors.push_back(msg::err(*active_line, "Operator of 65C02 only", "\"" + op + "\" is not an NMOS 6502 operator, the program is built for it"));
+		return false;
+	}
 	else
 	{
 		errors.push_back(msg::err(*active_line, "Unknown operator", "Could not parse \"" + op + "\" as valid operator"));
@@ -475,14 +491,15 @@ bool compiler::resolve_addr_for_op(std::string addr, const std::string& op)
 
 		if (labels.find(label) != labels.end())
 		{
-			if (ops_that_can_use_labels.find(op) == ops_that_can_use_labels.end())
+			u8 size = label_size(op);
+			if (size == 0)
 			{
 				errors.push_back(msg::err(*active_line, "Label misuse", "Opeator \"" + op + "\" can not be used with labels"));
 				return false;
 			}
 
 			// ops that use relative addressing
-			if (ops_that_can_use_labels.at(op) == 2)
+			if (size == 2)
 			{
 				if (labels.at(label) == ABSENT_LABEL)
 				{
@@ -512,7 +529,7 @@ bool compiler::resolve_addr_for_op(std::string addr, const std::string& op)
 				active_line->parsed = true;
 				active_line->unresolved_label = false;
 				active_line->byte_size = 2;
-				active_line->bytes[0] = active_line->parsed_op.imp;
+				active_line->bytes[0] = active_line->parsed_op.zp;
 				active_line->bytes[1] = i8(relative_addr);
 				return true;
 			}
@@ -678,20 +695,58 @@ bool compiler::resolve_addr_for_op(std::string addr, const std::string& op)
 		return false;
 	}
 
-	// indirect, x
-	if (std::regex_match(addr, addr_match, mask::IN_X))
+	// indirect (only JMP) or indirect zero page
+	if (std::regex_match(addr, addr_match, mask::IN))
 	{
-		if (active_line->parsed_op.in_x == ABSENT_OP)
+		parsed_addr = parse_number(addr_match.str(1));
+
+		if (active_line->parsed_op.in != ABSENT_OP)
 		{
-			errors.push_back(msg::err(*active_line, "Missing addressing mode", "Operator \"" + op + "\" does not have (indirect, x) addressing mode"));
-			return false;
+			active_line->byte_size = 3;
+			active_line->bytes[0] = active_line->parsed_op.in;
+			active_line->bytes[1] = parsed_addr & 0xFF;
+			active_line->bytes[2] = parsed_addr >> BIT_SIZE;
+			active_line->parsed = true;
+			return true;
+		}
+		if (active_line->parsed_op.in_zp != ABSENT_OP)
+		{
+			active_line->byte_size = 2;
+			active_line->bytes[0] = active_line->parsed_op.in_zp;
+			active_line->bytes[1] = convert_to_byte(parsed_addr);
+			active_line->parsed = true;
+			return true;
 		}
+
+		errors.push_back(msg::err(*active_line, "Missing addressing mode", "Operator \"" + op + "\" does not have indirect or (zero page) addressing modes"));
+		return false;
+	}
+
+	// indirect, x or indirect absolute, x (only JMP)
+	if (std::regex_match(addr, addr_match, mask::IN_X))
+	{
 		parsed_addr = parse_number(addr_match.str(1));
-		active_line->byte_size = 2;
-		active_line->bytes[0] = active_line->parsed_op.in_x;
-		active_line->bytes[1] = convert_to_byte(parsed_addr);
-		active_line->parsed = true;
-		return true;
+
+		if (active_line->parsed_op.in_x != ABSENT_OP)
+		{
+			active_line->byte_size = 2;
+			active_line->bytes[0] = active_line->parsed_op.in_x;
+			active_line->bytes[1] = convert_to_byte(parsed_addr);
+			active_line->parsed = true;
+			return true;
+		}
+		if (active_line->parsed_op.in_abs_x != ABSENT_OP)
+		{
+			active_line->byte_size = 3;
+			active_line->bytes[0] = active_line->parsed_op.in_abs_x;
+			active_line->bytes[1] = parsed_addr & 0xFF;
+			active_line->bytes[2] = parsed_addr >> BIT_SIZE;
+			active_line->parsed = true;
+			return true;
+		}
+
+		errors.push_back(msg::err(*active_line, "Missing addressing mode", "Operator \"" + op + "\" does not have (indirect, x) addressing modes"));
+		return false;
 	}
 
 	// indirect, y
@@ -5,6 +5,7 @@
 #include <vector>
 #include <regex>
 #include <sstream>
+#include <string_view>
 
 #include "vm_6502.h"
 #include "timer.h"
@@ -14,9 +15,11 @@
 // NOTE: Labels only can be used by standard branch ops
 
 constexpr u8 ABSENT_OP = 0x00; // for indicating that addressing variant is absent
-// BRK abd JMP should be handled individually
+// BRK is opcode 0x00 as well, so it can't be assembled
 constexpr u16 ABSENT_LABEL = 0xFFFF; // for label that was declared, but its address was not yet calculated
 
+// opcodes of one mnemonic by addressing mode, generated from op_entries of each cpu_variant (see compiler_instructios.cpp),
+// NMOS opcodes are the same on 65C02, compiler::variant picks the set a program may use
 struct op_modes
 {
 	u8 imp		= ABSENT_OP;	// implied
@@ -29,11 +32,9 @@ struct op_modes
 	u8 abs_y	= ABSENT_OP;	// absolute, y
 	u8 in_x		= ABSENT_OP;	// indirect, x
 	u8 in_y		= ABSENT_OP;	// indirect, y
-};
-
-enum struct addr_mode : u8
-{
-	none, imp, im, zp, zp_x, zp_y, abs, abs_x, abs_y, in_x, in_y
+	u8 in		= ABSENT_OP;	// indirect, only JMP
+	u8 in_zp	= ABSENT_OP;	// indirect zero page, 65C02
+	u8 in_abs_x	= ABSENT_OP;	// indirect absolute, x, only JMP on 65C02
 };
 
 struct source_line
@@ -64,9 +65,12 @@ constexpr u64 MAX_PARSE_PASSES = 16;
 
 struct compiler
 {
-	static std::unordered_map<std::string, op_modes>		op_map;
-	//              op           byte size
-	static std::unordered_map<std::string, u8>			ops_that_can_use_labels;
+	// opcodes of a mnemonic in either instruction set, nullptr - unknown mnemonic
+	static const op_modes* find_op(std::string_view name);
+	// opcodes of a mnemonic 'variant' has, nullptr - unknown there
+	static const op_modes* find_op(std::string_view name, cpu_variant variant);
+	// bytes of operator with a label as operand: 2 - relative (branches), 3 - absolute (JMP, JSR), 0 - labels can't be used
+	static u8 label_size(std::string_view name);
 
 	//       name         addr
 	std::unordered_map<std::string, u16>	labels = {};
@@ -78,6 +82,8 @@ struct compiler
 	std::vector<msg>			warnings = {};
 	std::vector<msg>			errors = {};
 	timer						internal_timer = {};
+	// instruction set operators are taken from, compile_and_build sets the cpu's one
+	cpu_variant					variant = cpu_variant::cmos;
 
 	compiler();
 
@@ -93,6 +99,10 @@ struct compiler
 	bool compile(const std::string& path);
 	bool compile_and_build(const std::string& path, cpu& cpu_ref);
 
+	// start-up code around a program loaded at 0x0200: JSR $0200 at START_UP_ADDR, KIL after it and RTS at 'program_end',
+	// the reset vector points at it, NMI and IRQ vectors are left to the program
+	static void write_start_up(ram& mem, u16 program_end);
+
 	void resolve_defines();
 	void clean_up();
 	void read_labels();
@@ -147,7 +157,8 @@ namespace mask
 	static std::regex ABS("^([%$]?[\\da-fA-F]+)$"); // absolute, zero page or relative
 	static std::regex ABS_X("^([%$]?[\\da-fA-F]+)\\s*,\\s*[Xx]$"); // absolute, x or zero page, x
 	static std::regex ABS_Y("^([%$]?[\\da-fA-F]+)\\s*,\\s*[Yy]$"); // absolute, y or zero page, y
-	static std::regex IN_X("^\\s*\\(\\s*([%$]?[\\da-fA-F]+)\\s*,\\s*[Xx]\\s*\\)$"); // indirect, x
+	static std::regex IN_X("^\\s*\\(\\s*([%$]?[\\da-fA-F]+)\\s*,\\s*[Xx]\\s*\\)$"); // indirect, x or indirect absolute, x
 	static std::regex IN_Y("^\\s*\\(\\s*([%$]?[\\da-fA-F]+)\\s*\\)\\s*,\\s*[Yy]$"); // indirect, y
-	// BRK and JMP are edge cases
+	static std::regex IN("^\\s*\\(\\s*([%$]?[\\da-fA-F]+)\\s*\\)$"); // indirect (JMP) or indirect zero page
+	// BRK is an edge case
 }
\ No newline at end of file
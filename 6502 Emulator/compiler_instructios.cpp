@@ -1,830 +1,123 @@
+#include <algorithm>
+
 #include "compiler_6502.h"
+#include "op_policies_6502.h"
+
+// Assembler view of op_entries: every mnemonic with its opcodes by addressing mode, sorted by name, one table per cpu_variant.
+// Generated while compiling, so the assembler, VM and tools read one table and nothing is built at startup.
+// 65C02 entries hold every NMOS opcode as well, so the 65C02 table serves callers that don't know the cpu.
 
-std::unordered_map<std::string, op_modes> compiler::op_map =
+struct assembler_op
 {
+	std::string_view name = {};
+	op_modes modes = {};
+	u8 label_size = 0;	// see compiler::label_size
+};
+
+template <cpu_variant variant>
+constexpr u32 count_mnemonics()
+{
+	std::array<std::string_view, OP_TABLE_SIZE> seen = {};
+	u32 count = 0;
+	for (const op_entry& entry : variant_op_entries<variant>)
 	{
-		"LDA",				// name
-		{
-			ABSENT_OP,			// implied
-			op::LDA_IM,		// immediate
-			op::LDA_ZP,		// zero page or relative
-			op::LDA_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::LDA_ABS,	// absolute
-			op::LDA_ABS_X,	// absolute, x
-			op::LDA_ABS_Y,	// absolute, y
-			op::LDA_IN_X,	// indirect, x
-			op::LDA_IN_Y	// indirect, y
-		}
-	},
-	{
-		"STA",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::STA_ZP,		// zero page or relative
-			op::STA_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::STA_ABS,	// absolute
-			op::STA_ABS_X,	// absolute, x
-			op::STA_ABS_Y,	// absolute, y
-			op::STA_IN_X,	// indirect, x
-			op::STA_IN_Y	// indirect, y
-		}
-	},
-	{
-		"LDX",				// name
-		{
-			ABSENT_OP,			// implied
-			op::LDX_IM,		// immediate
-			op::LDX_ZP,		// zero page or relative
-			ABSENT_OP,			// zero page, x
-			op::LDX_ZP_Y,	// zero page, y
-			op::LDX_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			op::LDX_ABS_Y,	// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"STX",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::STX_ZP,		// zero page or relative
-			ABSENT_OP,			// zero page, x
-			op::STX_ZP_Y,	// zero page, y
-			op::STX_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"LDY",				// name
-		{
-			ABSENT_OP,			// implied
-			op::LDY_IM,		// immediate
-			op::LDY_ZP,		// zero page or relative
-			op::LDY_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::LDY_ABS,	// absolute
-			op::LDY_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"STY",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::STY_ZP,		// zero page or relative
-			op::STY_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::STY_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"TAX",				// name
-		{
-			op::TAX,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP 			// indirect, y
-		}
-	},
-	{
-		"TAY",				// name
-		{
-			op::TAY,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"TXA",				// name
-		{
-			op::TXA,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"TYA",				// name
-		{
-			op::TYA,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"TSX",				// name
-		{
-			op::TSX,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"TXS",				// name
-		{
-			op::TXS,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"PHA",				// name
-		{
-			op::PHA,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"PHP",				// name
-		{
-			op::PHP,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"PLA",				// name
-		{
-			op::PLA,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"PLP",				// name
-		{
-			op::PLP,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"AND",				// name
-		{
-			ABSENT_OP,			// implied
-			op::AND_IM,		// immediate
-			op::AND_ZP,		// zero page or relative
-			op::AND_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::AND_ABS,	// absolute
-			op::AND_ABS_X,	// absolute, x
-			op::AND_ABS_Y,	// absolute, y
-			op::AND_IN_X,	// indirect, x
-			op::AND_IN_Y	// indirect, y
-		}
-	},
-	{
-		"EOR",				// name
-		{
-			ABSENT_OP,			// implied
-			op::EOR_IM,		// immediate
-			op::EOR_ZP,		// zero page or relative
-			op::EOR_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::EOR_ABS,	// absolute
-			op::EOR_ABS_X,	// absolute, x
-			op::EOR_ABS_Y,	// absolute, y
-			op::EOR_IN_X,	// indirect, x
-			op::EOR_IN_Y	// indirect, y
-		}
-	},
-	{
-		"ORA",				// name
-		{
-			ABSENT_OP,			// implied
-			op::ORA_IM,		// immediate
-			op::ORA_ZP,		// zero page or relative
-			op::ORA_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::ORA_ABS,	// absolute
-			op::ORA_ABS_X,	// absolute, x
-			op::ORA_ABS_Y,	// absolute, y
-			op::ORA_IN_X,	// indirect, x
-			op::ORA_IN_Y	// indirect, y
-		}
-	},
-	{
-		"BIT",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::BIT_ZP,		// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::BIT_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"ADC",				// name
-		{
-			ABSENT_OP,			// implied
-			op::ADC_IM,		// immediate
-			op::ADC_ZP,		// zero page or relative
-			op::ADC_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::ADC_ABS,	// absolute
-			op::ADC_ABS_X,	// absolute, x
-			op::ADC_ABS_Y,	// absolute, y
-			op::ADC_IN_X,	// indirect, x
-			op::ADC_IN_Y	// indirect, y
-		}
-	},
-	{
-		"SBC",				// name
-		{
-			ABSENT_OP,			// implied
-			op::SBC_IM,		// immediate
-			op::SBC_ZP,		// zero page or relative
-			op::SBC_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::SBC_ABS,	// absolute
-			op::SBC_ABS_X,	// absolute, x
-			op::SBC_ABS_Y,	// absolute, y
-			op::SBC_IN_X,	// indirect, x
-			op::SBC_IN_Y	// indirect, y
-		}
-	},
-	{
-		"CMP",				// name
-		{
-			ABSENT_OP,			// implied
-			op::CMP_IM,		// immediate
-			op::CMP_ZP,		// zero page or relative
-			op::CMP_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::CMP_ABS,	// absolute
-			op::CMP_ABS_X,	// absolute, x
-			op::CMP_ABS_Y,	// absolute, y
-			op::CMP_IN_X,	// indirect, x
-			op::CMP_IN_Y	// indirect, y
-		}
-	},
-	{
-		"CPX",				// name
-		{
-			ABSENT_OP,			// implied
-			op::CPX_IM,		// immediate
-			op::CPX_ZP,		// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::CPX_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"CPY",				// name
-		{
-			ABSENT_OP,			// implied
-			op::CPY_IM,		// immediate
-			op::CPY_ZP,		// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::CPY_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"INC",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::INC_ZP,		// zero page or relative
-			op::INC_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::INC_ABS,	// absolute
-			op::INC_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"INX",				// name
-		{
-			op::INX,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"INY",				// name
-		{
-			op::INY,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"DEC",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			op::DEC_ZP,		// zero page or relative
-			op::DEC_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::DEC_ABS,	// absolute
-			op::DEC_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"DEX",				// name
-		{
-			op::DEX,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"DEY",				// name
-		{
-			op::DEY,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"ASL",				// name
-		{
-			op::ASL_A,		// implied
-			ABSENT_OP,			// immediate
-			op::ASL_ZP,		// zero page or relative
-			op::ASL_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::ASL_ABS,	// absolute
-			op::ASL_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"LSR",				// name
-		{
-			op::LSR_A,		// implied
-			ABSENT_OP,			// immediate
-			op::LSR_ZP,		// zero page or relative
-			op::LSR_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::LSR_ABS,	// absolute
-			op::LSR_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"ROL",				// name
-		{
-			op::ROL_A,		// implied
-			ABSENT_OP,			// immediate
-			op::ROL_ZP,		// zero page or relative
-			op::ROL_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::ROL_ABS,	// absolute
-			op::ROL_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"ROR",				// name
-		{
-			op::ROR_A,		// implied
-			ABSENT_OP,			// immediate
-			op::ROR_ZP,		// zero page or relative
-			op::ROR_ZP_X,	// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::ROR_ABS,	// absolute
-			op::ROR_ABS_X,	// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"JMP",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::JMP_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			op::JMP_IN,		// indirect, x
-			op::JMP_IN		// indirect, y
-		}
-	},
-	{
-		"JSR",				// name
-		{
-			ABSENT_OP,			// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			op::JSR_ABS,	// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"RTS",				// name
-		{
-			op::RTS,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BCC",				// name
-		{
-			op::BCC,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BCS",				// name
-		{
-			op::BCS,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BEQ",				// name
-		{
-			op::BEQ,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BMI",				// name
-		{
-			op::BMI,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BNE",				// name
-		{
-			op::BNE,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BPL",				// name
-		{
-			op::BPL,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BVC",				// name
-		{
-			op::BVC,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"BVS",				// name
-		{
-			op::BVS,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"CLC",				// name
-		{
-			op::CLC,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"CLI",				// name
-		{
-			op::CLI,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"CLV",				// name
-		{
-			op::CLV,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"SEC",				// name
-		{
-			op::SEC,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
-		}
-	},
-	{
-		"SEI",				// name
+		if (entry.mnemonic != nullptr && std::find(seen.begin(), seen.begin() + count, entry.mnemonic) == seen.begin() + count)
 		{
-			op::SEI,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
+			seen[count++] = entry.mnemonic;
 		}
-	},
+	}
+	return count;
+}
+
+// where an opcode goes in op_modes, relative shares the slot with zero page and accumulator the one with implied
+constexpr u8& mode_slot(op_modes& modes, op_mode mode)
+{
+	switch (mode)
+	{
+	case op_mode::im:		return modes.im;
+	case op_mode::zp:
+	case op_mode::rel:		return modes.zp;
+	case op_mode::zp_x:		return modes.zp_x;
+	case op_mode::zp_y:		return modes.zp_y;
+	case op_mode::abs:		return modes.abs;
+	case op_mode::abs_x:	return modes.abs_x;
+	case op_mode::abs_y:	return modes.abs_y;
+	case op_mode::in:		return modes.in;
+	case op_mode::in_zp:	return modes.in_zp;
+	case op_mode::in_abs_x:	return modes.in_abs_x;
+	case op_mode::in_x:		return modes.in_x;
+	case op_mode::in_y:		return modes.in_y;
+	default:				return modes.imp;
+	}
+}
+
+template <cpu_variant variant>
+constexpr std::array<assembler_op, count_mnemonics<variant>()> make_assembler_ops()
+{
+	std::array<assembler_op, count_mnemonics<variant>()> t = {};
+	u32 count = 0;
+
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
 	{
-		"BRK",				// name
+		const op_entry& entry = variant_op_entries<variant>[code];
+		if (entry.mnemonic == nullptr)
 		{
-			op::BRK,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
+			continue;
 		}
-	},
-	{
-		"RTI",				// name
+
+		auto it = std::find_if(t.begin(), t.begin() + count, [&](const assembler_op& op) { return op.name == entry.mnemonic; });
+		if (it == t.begin() + count)
 		{
-			op::RTI,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
+			it->name = entry.mnemonic;
+			count++;
 		}
-	},
-	{
-		"NOP",				// name
+		mode_slot(it->modes, entry.mode) = u8(code);
+
+		// labels stand for jump targets only
+		if (entry.jumps && entry.mode == op_mode::rel)
 		{
-			op::NOP,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
+			it->label_size = 2;
 		}
-	},
-	{
-		"KIL",				// name
+		else if (entry.jumps && entry.mode == op_mode::abs)
 		{
-			op::KIL,		// implied
-			ABSENT_OP,			// immediate
-			ABSENT_OP,			// zero page or relative
-			ABSENT_OP,			// zero page, x
-			ABSENT_OP,			// zero page, y
-			ABSENT_OP,			// absolute
-			ABSENT_OP,			// absolute, x
-			ABSENT_OP,			// absolute, y
-			ABSENT_OP,			// indirect, x
-			ABSENT_OP			// indirect, y
+			it->label_size = 3;
 		}
 	}
-};
\ No newline at end of file
+
+	std::ranges::sort(t, {}, &assembler_op::name);
+	return t;
+}
+
+template <cpu_variant variant>
+static constexpr auto assembler_ops = make_assembler_ops<variant>();
+
+template <cpu_variant variant>
+static const assembler_op* find_assembler_op(std::string_view name)
+{
+	const auto& ops = assembler_ops<variant>;
+	auto it = std::ranges::lower_bound(ops, name, {}, &assembler_op::name);
+	return it != ops.end() && it->name == name ? &*it : nullptr;
+}
+
+static const assembler_op* find_assembler_op(std::string_view name, cpu_variant variant = cpu_variant::cmos)
+{
+	return variant == cpu_variant::cmos ? find_assembler_op<cpu_variant::cmos>(name) : find_assembler_op<cpu_variant::nmos>(name);
+}
+
+const op_modes* compiler::find_op(std::string_view name)
+{
+	const assembler_op* op = find_assembler_op(name);
+	return op != nullptr ? &op->modes : nullptr;
+}
+
+const op_modes* compiler::find_op(std::string_view name, cpu_variant variant)
+{
+	const assembler_op* op = find_assembler_op(name, variant);
+	return op != nullptr ? &op->modes : nullptr;
+}
+
+u8 compiler::label_size(std::string_view name)
+{
+	const assembler_op* op = find_assembler_op(name);
+	return op != nullptr ? op->label_size : 0;
+}
@@ -0,0 +1,5 @@
+#include "decimal_6502.h"
+
+// constant initialized, the tables are in the executable image, nothing runs at startup
+constinit const std::array<u16, DECIMAL_TABLE_SIZE> decimal_adc = make_decimal_table<false>();
+constinit const std::array<u16, DECIMAL_TABLE_SIZE> decimal_sbc = make_decimal_table<true>();
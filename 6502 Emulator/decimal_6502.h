@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+
+#include "vm_6502.h"
+
+// Decimal mode of ADC and SBC, as NMOS 6502 does it (http://www.6502.org/tutorials/decimal_mode.html, appendix A):
+//   ADC: result and carry are decimal, z is taken from the binary sum, n and v from the sum before the high digit is adjusted
+//   SBC: result is decimal, n, v and z are taken from the binary difference, carry is set if nothing was borrowed
+// Results for every (carry, a, operand) are generated at compile time into decimal_adc and decimal_sbc,
+// an entry holds the result and flags, so a decimal operator is one load whether its operands are valid BCD or not.
+// operation::adc and operation::sbc choose between a table and binary arithmetic by d, one predictable branch per operator.
+
+constexpr u32 DECIMAL_TABLE_SIZE = 2 * 256 * 256;
+
+constexpr u32 decimal_index(u8 carry, u8 a, u8 value)
+{
+	return (u32(carry) << (2 * BIT_SIZE)) | (u32(a) << BIT_SIZE) | value;
+}
+
+// result in low byte, n, v, z and c at their flag_bit in high byte
+constexpr u16 decimal_entry(u8 result, u8 flags)
+{
+	return u16(result | (flags << BIT_SIZE));
+}
+
+constexpr u16 make_decimal_adc(u8 a, u8 value, u8 carry)
+{
+	i32 low = (a & 0x0F) + (value & 0x0F) + carry;
+	if (low >= 0x0A)
+	{
+		low = ((low + 0x06) & 0x0F) + 0x10;
+	}
+	i32 sum = (a & 0xF0) + (value & 0xF0) + low;
+	i32 signed_sum = i32(i8(a & 0xF0)) + i32(i8(value & 0xF0)) + low;
+
+	u8 flags = 0;
+	flags |= (sum & 0x80) ? flag_bit::n : 0;
+	flags |= (signed_sum < -128 || signed_sum > 127) ? flag_bit::v : 0;
+	flags |= u8(a + value + carry) == 0 ? flag_bit::z : 0;
+	if (sum >= 0xA0)
+	{
+		sum += 0x60;
+	}
+	flags |= sum >= 0x100 ? flag_bit::c : 0;
+	return decimal_entry(u8(sum), flags);
+}
+
+constexpr u16 make_decimal_sbc(u8 a, u8 value, u8 carry)
+{
+	// flags of the binary difference
+	u8 binary = u8(a - value - !carry);
+	u8 flags = 0;
+	flags |= (binary & 0x80) ? flag_bit::n : 0;
+	flags |= ((a ^ value) & (a ^ binary) & 0x80) ? flag_bit::v : 0;
+	flags |= binary == 0 ? flag_bit::z : 0;
+	flags |= i32(a) >= i32(value) + !carry ? flag_bit::c : 0;
+
+	i32 low = (a & 0x0F) - (value & 0x0F) + carry - 1;
+	if (low < 0)
+	{
+		low = ((low - 0x06) & 0x0F) - 0x10;
+	}
+	i32 difference = (a & 0xF0) - (value & 0xF0) + low;
+	if (difference < 0)
+	{
+		difference -= 0x60;
+	}
+	return decimal_entry(u8(difference), flags);
+}
+
+template <bool subtract>
+constexpr std::array<u16, DECIMAL_TABLE_SIZE> make_decimal_table()
+{
+	std::array<u16, DECIMAL_TABLE_SIZE> t = {};
+	for (u32 i = 0; i < DECIMAL_TABLE_SIZE; i++)
+	{
+		u8 carry = u8(i >> (2 * BIT_SIZE));
+		u8 a = u8(i >> BIT_SIZE);
+		u8 value = u8(i);
+		t[i] = subtract ? make_decimal_sbc(a, value, carry) : make_decimal_adc(a, value, carry);
+	}
+	return t;
+}
+
+// generated in decimal_6502.cpp, once for the whole program
+extern const std::array<u16, DECIMAL_TABLE_SIZE> decimal_adc;
+extern const std::array<u16, DECIMAL_TABLE_SIZE> decimal_sbc;
+
+// a and flags from a table entry
+inline void apply_decimal(auto& c, u16 entry)
+{
+	u8 flags = u8(entry >> BIT_SIZE);
+	c.a = u8(entry);
+	c.c = (flags & flag_bit::c) != 0;
+	c.set_z((flags & flag_bit::z) != 0);
+	c.n_value = flags;
+	c.v_value = u8(flags << 1);
+}
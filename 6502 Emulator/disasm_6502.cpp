@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cstring>
+
+#include "disasm_6502.h"
+#include "op_policies_6502.h"
+
+// how operand of an opcode is printed
+enum struct disasm_operand : u8
+{
+	none,
+	byte,	// two hex digits
+	word,	// four hex digits, little-endian in memory
+	target	// relative offset, printed as the address a taken branch continues at
+};
+
+// descriptor of one opcode, text, operand and suffix are written whole and the write position moves by their size
+struct disasm_entry
+{
+	char text[8] = {};		// mnemonic and operand prefix, "LDA ($"
+	char suffix[4] = {};	// after operand, "),Y"
+	u8 text_size = 0;
+	u8 suffix_size = 0;
+	u64 columns = 0;		// ones over the digits of the second and third instruction byte, when it has them
+	u16 byte_mask = 0;		// all ones for the operand kind the entry has
+	u16 word_mask = 0;
+	u16 target_mask = 0;
+	u8 operand_size = 0;	// hex digits of operand
+	u8 length = 1;
+	disasm_operand operand = disasm_operand::none;
+};
+
+struct disasm_syntax
+{
+	const char* prefix;
+	const char* suffix;
+	disasm_operand operand;
+};
+
+// assembler syntax of every addressing mode, see mask in compiler_6502.h
+constexpr disasm_syntax syntax_of(op_mode mode)
+{
+	switch (mode)
+	{
+	case op_mode::im:		return { "#$", "", disasm_operand::byte };
+	case op_mode::zp:		return { "$", "", disasm_operand::byte };
+	case op_mode::zp_x:		return { "$", ",X", disasm_operand::byte };
+	case op_mode::zp_y:		return { "$", ",Y", disasm_operand::byte };
+	case op_mode::abs:		return { "$", "", disasm_operand::word };
+	case op_mode::abs_x:	return { "$", ",X", disasm_operand::word };
+	case op_mode::abs_y:	return { "$", ",Y", disasm_operand::word };
+	case op_mode::in:		return { "($", ")", disasm_operand::word };
+	case op_mode::in_x:		return { "($", ",X)", disasm_operand::byte };
+	case op_mode::in_y:		return { "($", "),Y", disasm_operand::byte };
+	case op_mode::in_zp:	return { "($", ")", disasm_operand::byte };
+	case op_mode::in_abs_x:	return { "($", ",X)", disasm_operand::word };
+	case op_mode::rel:		return { "$", "", disasm_operand::target };
+	default:				return { "", "", disasm_operand::none };	// implied, accumulator
+	}
+}
+
+constexpr disasm_entry make_disasm_entry(const char* mnemonic, disasm_syntax syntax, u8 length)
+{
+	disasm_entry entry = {};
+	for (const char* at = mnemonic; *at != 0; at++)
+	{
+		entry.text[entry.text_size++] = *at;
+	}
+	if (syntax.operand != disasm_operand::none)
+	{
+		entry.text[entry.text_size++] = ' ';
+	}
+	for (const char* at = syntax.prefix; *at != 0; at++)
+	{
+		entry.text[entry.text_size++] = *at;
+	}
+	for (const char* at = syntax.suffix; *at != 0; at++)
+	{
+		entry.suffix[entry.suffix_size++] = *at;
+	}
+	entry.columns = length > 1 ? (length > 2 ? 0x0000'FFFF'00FF'FF00 : 0x0000'0000'00FF'FF00) : 0;
+	entry.byte_mask = syntax.operand == disasm_operand::byte ? 0xFFFF : 0;
+	entry.word_mask = syntax.operand == disasm_operand::word ? 0xFFFF : 0;
+	entry.target_mask = syntax.operand == disasm_operand::target ? 0xFFFF : 0;
+	entry.operand_size = syntax.operand == disasm_operand::none ? 0 : syntax.operand == disasm_operand::byte ? 2 : 4;
+	entry.length = length;
+	entry.operand = syntax.operand;
+	return entry;
+}
+
+// unknown opcode, or instruction longer than the bytes left
+constexpr disasm_entry UNKNOWN_ENTRY = make_disasm_entry("???", { "", "", disasm_operand::none }, 1);
+
+template <cpu_variant variant>
+constexpr std::array<disasm_entry, OP_TABLE_SIZE> make_disasm_table()
+{
+	std::array<disasm_entry, OP_TABLE_SIZE> t = {};
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		const op_entry& entry = variant_op_entries<variant>[code];
+		t[code] = entry.mnemonic != nullptr ? make_disasm_entry(entry.mnemonic, syntax_of(entry.mode), entry.length) : UNKNOWN_ENTRY;
+	}
+	return t;
+}
+
+static constexpr std::array<disasm_entry, OP_TABLE_SIZE> disasm_tables[CPU_VARIANT_COUNT] =
+{
+	make_disasm_table<cpu_variant::nmos>(),
+	make_disasm_table<cpu_variant::cmos>()
+};
+
+// two hex digits of every byte as they lie in memory, first digit in low byte (words are little-endian on x86 and x64)
+constexpr std::array<u16, 256> make_hex_pairs()
+{
+	constexpr char DIGITS[] = "0123456789ABCDEF";
+	std::array<u16, 256> t = {};
+	for (u32 value = 0; value < 256; value++)
+	{
+		t[value] = u16(DIGITS[value >> 4] | (DIGITS[value & 0x0F] << BIT_SIZE));
+	}
+	return t;
+}
+
+static constexpr std::array<u16, 256> hex_pairs = make_hex_pairs();
+
+constexpr u64 SPACES = 0x2020'2020'2020'2020;
+
+// text, operand digits and suffix are written whole, every line still fits with them (newline lands inside the suffix copy)
+constexpr bool fits_line(const std::array<disasm_entry, OP_TABLE_SIZE>& table)
+{
+	for (const disasm_entry& entry : table)
+	{
+		if (DISASM_TEXT_COLUMN + std::max<u32>(sizeof(entry.text), entry.text_size + sizeof(u32) + sizeof(entry.suffix)) > DISASM_MAX_LINE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(fits_line(disasm_tables[u8(cpu_variant::nmos)]) && fits_line(disasm_tables[u8(cpu_variant::cmos)]));
+
+// writes one line without newline at 'at' and moves 'at' to its end, returns instruction length
+// nothing branches on the opcode: columns and operand are put together in registers, masked by the entry and stored whole
+static u32 format_line(const disasm_entry* table, const u8* bytes, u64 size, u16 addr, char*& at)
+{
+	const disasm_entry* entry = &table[bytes[0]];
+	u8 padded[3] = {};
+	if (size < sizeof(padded))
+	{
+		memcpy(padded, bytes, size);
+		bytes = padded;
+		if (entry->length > size)
+		{
+			entry = &UNKNOWN_ENTRY;
+		}
+	}
+	u8 low = bytes[1];
+	u8 high = bytes[2];
+
+	// "AAAA  B0" and " B1 B2  ", unused byte columns are spaces
+	u64 address = u64(hex_pairs[u8(addr >> BIT_SIZE)]) | (u64(hex_pairs[u8(addr)]) << 16);
+	u64 head = address | (SPACES & 0x0000'FFFF'0000'0000) | (u64(hex_pairs[bytes[0]]) << 48);
+	u64 tail = (u64(hex_pairs[low]) << 8) | (u64(hex_pairs[high]) << 32);
+	tail = (tail & entry->columns) | (SPACES & ~entry->columns);
+	memcpy(at, &head, sizeof(head));
+	memcpy(at + sizeof(head), &tail, sizeof(tail));
+	at += DISASM_TEXT_COLUMN;
+
+	// operand of every kind masked by the entry, one byte goes high so its two digits come first
+	u16 value = (u16(low << BIT_SIZE) & entry->byte_mask) | (u16(low | (high << BIT_SIZE)) & entry->word_mask)
+		| (branch_target(addr, low) & entry->target_mask);
+	u32 operand = u32(hex_pairs[u8(value >> BIT_SIZE)]) | (u32(hex_pairs[u8(value)]) << 16);
+	memcpy(at, entry->text, sizeof(entry->text));
+	at += entry->text_size;
+	memcpy(at, &operand, sizeof(operand));
+	at += entry->operand_size;
+	memcpy(at, entry->suffix, sizeof(entry->suffix));
+	at += entry->suffix_size;
+	return entry->length;
+}
+
+disasm_line disassemble_line(const u8* bytes, u64 size, u16 addr, char* out, cpu_variant variant)
+{
+	if (size == 0)
+	{
+		*out = 0;
+		return {};
+	}
+	// room for one line only, its newline becomes the terminating zero
+	u64 consumed = 0;
+	u64 chars = disassemble(bytes, size, addr, out, DISASM_MAX_LINE, consumed, variant);
+	out[chars - 1] = 0;
+	return { u32(consumed), u32(chars - 1) };
+}
+
+u64 disassemble(const u8* bytes, u64 size, u16 origin, char* out, u64 capacity, u64& consumed, cpu_variant variant)
+{
+	const disasm_entry* table = disasm_tables[u8(variant)].data();
+	char* at = out;
+	char* end = out + capacity;
+	u64 done = 0;
+	while (done < size && u64(end - at) >= DISASM_MAX_LINE)
+	{
+		done += format_line(table, bytes + done, size - done, u16(origin + done), at);
+		*at++ = '\n';
+	}
+	consumed = done;
+	return u64(at - out);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "vm_6502.h"
+
+// Disassembler: linear sweep over bytes, one line per instruction:
+//   "0200  A9 40     LDA #$40"	address, instruction bytes, mnemonic and operand in assembler syntax
+// Every opcode is decoded through a 256-entry descriptor table per cpu_variant, generated from op_entries at compile time,
+// it holds mnemonic and operand prefix, suffix, length and operand kind, so a line is a few copies and hex lookups.
+// Branches print their target address, accumulator operand is left out as the assembler writes it ("ASL"),
+// an unknown opcode, or an instruction cut by the end of the bytes, is one "???" byte.
+// Output goes into a caller buffer, nothing is allocated.
+
+constexpr u32 DISASM_MAX_LINE = 32;			// chars one line may take, newline included
+constexpr u32 DISASM_TEXT_COLUMN = 16;		// where mnemonic starts
+constexpr u32 DISASM_BUFFER_BYTES = 65'536;	// output chunk of the disasm tool and benchmark
+
+// what disassemble_line decoded and wrote
+struct disasm_line
+{
+	u32 bytes = 0;	// instruction length, 1 for unknown opcode
+	u32 chars = 0;	// line length, without terminating zero
+};
+
+/// <summary>
+/// Formats instruction at 'bytes' (at most 'size' bytes, first one at address 'addr') into 'out',
+/// which must have room for DISASM_MAX_LINE chars. The line has no newline and ends with zero.
+/// </summary>
+disasm_line disassemble_line(const u8* bytes, u64 size, u16 addr, char* out, cpu_variant variant = cpu_variant::nmos);
+
+/// <summary>
+/// Disassembles 'size' bytes (first one at address 'origin') into 'out' as lines ending with newline,
+/// until bytes end or there is no room for another line in 'capacity' chars.
+/// 'consumed' gets bytes decoded, continue from there with an emptied buffer. Returns chars written, nothing is zero-terminated.
+/// </summary>
+u64 disassemble(const u8* bytes, u64 size, u16 origin, char* out, u64 capacity, u64& consumed, cpu_variant variant = cpu_variant::nmos);
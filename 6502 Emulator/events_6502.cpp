@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include "events_6502.h"
+#include "op_policies_6502.h"
+
+// std heap functions keep the largest element on top
+static bool fires_later(const scheduled_event& a, const scheduled_event& b)
+{
+	return a.cycle != b.cycle ? a.cycle > b.cycle : a.order > b.order;
+}
+
+static void update_next_event(cpu& cpu_ref)
+{
+	const std::vector<scheduled_event>& heap = cpu_ref.events->heap;
+	cpu_ref.next_event = heap.empty() ? NO_EVENT : heap.front().cycle;
+}
+
+void schedule_event(cpu& cpu_ref, u64 cycle, event_handler handler, void* device)
+{
+	if (!cpu_ref.events)
+	{
+		cpu_ref.events = std::make_unique<event_scheduler>();
+	}
+	event_scheduler& events = *cpu_ref.events;
+
+	events.heap.push_back({ cycle, events.scheduled++, handler, device });
+	std::push_heap(events.heap.begin(), events.heap.end(), &fires_later);
+	update_next_event(cpu_ref);
+}
+
+void cancel_events(cpu& cpu_ref, void* device)
+{
+	if (!cpu_ref.events)
+	{
+		return;
+	}
+	std::vector<scheduled_event>& heap = cpu_ref.events->heap;
+
+	std::erase_if(heap, [device](const scheduled_event& e) { return e.device == device; });
+	std::make_heap(heap.begin(), heap.end(), &fires_later);
+	update_next_event(cpu_ref);
+}
+
+void run_due_events(cpu& cpu_ref)
+{
+	if (!cpu_ref.events)
+	{
+		return;
+	}
+	event_scheduler& events = *cpu_ref.events;
+
+	while (!events.heap.empty() && events.heap.front().cycle <= cpu_ref.cycles)
+	{
+		std::pop_heap(events.heap.begin(), events.heap.end(), &fires_later);
+		scheduled_event e = events.heap.back();
+		events.heap.pop_back();
+		update_next_event(cpu_ref);
+
+		events.fired++;
+		e.handler(cpu_ref, e.device);
+	}
+}
+
+bool take_interrupt(cpu& c)
+{
+	u16 vector = 0;
+	if (c.nmi)
+	{
+		c.nmi = false;
+		vector = NMI_VECTOR;
+	}
+	else if (c.irq != 0 && !c.i)
+	{
+		vector = IRQ_VECTOR;
+	}
+	else
+	{
+		return false;
+	}
+
+	// pc is at the next opcode, RTI sets it to the pulled address and the run loop steps past it
+	u16 back = u16(c.pc - 1);
+	c.push(back & 0xFF);
+	c.push(back >> BIT_SIZE);
+	c.push(process_status(c) & ~(1 << 4));
+	c.i = true;
+	if (c.variant == cpu_variant::cmos)
+	{
+		c.d = false;
+	}
+	c.pc = c.mem[vector] | (c.mem[u16(vector + 1)] << BIT_SIZE);
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += INTERRUPT_CYCLES;
+	}
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+
+#include "vm_6502.h"
+
+// Interrupts and timed events, cpu::run_until handles both between its slices, engines never look at them.
+//   IRQ: cpu::irq is the line, a bit per device holding it, taken while it isn't 0 and i is clear.
+//        While it waits on i, run_until runs its slices on cpu::start_masked instead of the selected engine (no idle or
+//        idiom skipping), which ends the slice right after the CLI, PLP or RTI clearing i, so the IRQ follows it at once.
+//   NMI: a device sets cpu::nmi (edge), it is taken at the next boundary whatever i is, before IRQ.
+//        Devices raise lines from event handlers, and slices end at the next event, so that boundary is the one they run at.
+// Taking one pushes pc and status like BRK (b clear), sets i (and clears d on 65C02) and jumps through NMI_VECTOR or IRQ_VECTOR,
+// the handler starts at the vector address, RTI returns to the interrupted opcode, INTERRUPT_CYCLES are counted.
+// Events: devices schedule a handler at a cpu::cycles value, the scheduler keeps them in a min-heap
+// and cpu::next_event holds the earliest one, so run_until compares one number between slices instead of polling devices.
+// Slices are cut like a cycle budget, an event fires at the first operator boundary at or past its cycle,
+// events due at the same boundary fire in the order they were scheduled, before interrupts are taken.
+// Events are keyed by clock cycles, so they need CYCLES_6502: without it cycles stay 0 and only events at cycle 0 fire.
+// cpu::reset drops every event and releases both lines, devices schedule again after it.
+
+// called when cpu::cycles reaches the cycle it was scheduled at, may raise interrupts and schedule further events
+using event_handler = void(*)(cpu& cpu_ref, void* device);
+
+struct scheduled_event
+{
+	u64 cycle = 0;
+	u64 order = 0;						// ties fire in the order they were scheduled
+	event_handler handler = nullptr;
+	void* device = nullptr;				// passed to handler
+};
+
+struct event_scheduler
+{
+	std::vector<scheduled_event> heap = {};	// min-heap by cycle, then order
+	u64 scheduled = 0;
+	u64 fired = 0;
+};
+
+/// <summary>
+/// Schedules 'handler' to be called with 'device' once cpu::cycles reaches 'cycle'.
+/// </summary>
+void schedule_event(cpu& cpu_ref, u64 cycle, event_handler handler, void* device = nullptr);
+
+/// <summary>
+/// Drops every pending event of 'device'.
+/// </summary>
+void cancel_events(cpu& cpu_ref, void* device);
+
+/// <summary>
+/// Fires events due at cpu::cycles, including ones they schedule for a cycle already reached.
+/// </summary>
+void run_due_events(cpu& cpu_ref);
+
+/// <summary>
+/// Takes pending NMI, or IRQ if i is clear. Returns true if one was taken.
+/// </summary>
+bool take_interrupt(cpu& cpu_ref);
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "fusion_6502.h"
+#include "compiler_6502.h"
+
+void report_pair_stats(const std::string& path, u32 top)
+{
+	ram ram_0;
+	cpu cpu_0(ram_0);
+	compiler cmplr;
+
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return;
+	}
+
+	// indexed by (first << 8) | second, same stop conditions as cpu::start_loop
+	std::vector<u64> counts(OP_TABLE_SIZE * OP_TABLE_SIZE, 0);
+	u64 executed = 0;
+	u8 prev = 0;
+	for (u8 op = cpu_0.mem[cpu_0.pc]; !cpu_0.k; prev = op, op = cpu_0.next_byte())
+	{
+		if (executed++ > 0)
+		{
+			counts[(prev << BIT_SIZE) | op]++;
+		}
+		cpu_0.exe_op(op);
+	}
+
+	std::vector<u32> pairs;
+	for (u32 pair = 0; pair < counts.size(); pair++)
+	{
+		if (counts[pair] > 0)
+		{
+			pairs.push_back(pair);
+		}
+	}
+	std::sort(pairs.begin(), pairs.end(), [&counts](u32 l, u32 r) { return counts[l] > counts[r]; });
+	if (pairs.size() > top)
+	{
+		pairs.resize(top);
+	}
+
+	std::cout << "\nMost frequent opcode pairs of \"" << path << "\", " << executed << " operators:\n";
+	for (u32 pair : pairs)
+	{
+		u8 first = u8(pair >> BIT_SIZE);
+		u8 second = u8(pair);
+		std::cout << std::hex << std::uppercase << std::setfill('0')
+			<< std::setw(2) << u16(first) << ' ' << std::setw(2) << u16(second)
+			<< std::dec << std::nouppercase << std::setfill(' ')
+			<< ":\t" << counts[pair] << (find_fused(first, second) != nullptr ? "\tfused" : "") << '\n';
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <string>
+
+#include "vm_6502.h"
+#include "op_policies_6502.h"
+
+//#define PAIR_STATS_6502
+
+// Superinstructions: two neighbouring instructions decoded into one record with one fused handler.
+// Pairs are picked from real workloads, see report_pair_stats.
+// First instruction of a pair never writes memory or reads pc, so it can't modify the second one
+// and it doesn't matter that pc already stands at the last byte of the pair when it runs.
+// Both operands are packed into one raw operand, first one in low bytes, so a pair carries at most two operand bytes.
+
+// longest fused record: two instructions with two operand bytes between them
+constexpr u32 MAX_FUSED_BYTES = 4;
+
+constexpr u32 PAIR_STATS_TOP = 16;
+
+template <typename first_op, typename first_mode, typename second_op, typename second_mode>
+void exec_fused(cpu& c, u16 raw)
+{
+	static_assert(first_mode::length + second_mode::length <= 2, "fused operands don't fit into one raw operand");
+
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += base_cycles<first_op, first_mode> + base_cycles<second_op, second_mode>;
+	}
+	first_op::template run<first_mode>(c, u16(raw & ((1 << (first_mode::length * BIT_SIZE)) - 1)));
+	second_op::template run<second_mode>(c, u16(raw >> (first_mode::length * BIT_SIZE)));
+}
+
+struct fused_entry
+{
+	u8				first	= 0;		// opcode of first instruction
+	u8				second	= 0;		// opcode of second instruction
+	decoded_handler	exec	= nullptr;
+};
+
+template <typename first_op, typename first_mode, typename second_op, typename second_mode>
+constexpr fused_entry make_fused(u8 first, u8 second)
+{
+	return { first, second, &exec_fused<first_op, first_mode, second_op, second_mode> };
+}
+
+inline constexpr auto fused_pairs = []()
+{
+	using namespace operation;
+
+	using bne = branch<flag::z, false>;
+	using beq = branch<flag::z, true>;
+
+	return std::array
+	{
+		// compare and branch
+		make_fused<alu<cmp<reg::x>>, mode::im, bne, mode::rel>(op::CPX_IM, op::BNE),
+		make_fused<alu<cmp<reg::x>>, mode::im, beq, mode::rel>(op::CPX_IM, op::BEQ),
+		make_fused<alu<cmp<reg::y>>, mode::im, bne, mode::rel>(op::CPY_IM, op::BNE),
+		make_fused<alu<cmp<reg::y>>, mode::im, beq, mode::rel>(op::CPY_IM, op::BEQ),
+		make_fused<alu<cmp<reg::a>>, mode::im, bne, mode::rel>(op::CMP_IM, op::BNE),
+		make_fused<alu<cmp<reg::a>>, mode::im, beq, mode::rel>(op::CMP_IM, op::BEQ),
+
+		// count and branch
+		make_fused<rmw<dec>, mode::on_reg<reg::x>, bne, mode::rel>(op::DEX, op::BNE),
+		make_fused<rmw<dec>, mode::on_reg<reg::y>, bne, mode::rel>(op::DEY, op::BNE),
+		make_fused<rmw<inc>, mode::on_reg<reg::x>, bne, mode::rel>(op::INX, op::BNE),
+		make_fused<rmw<inc>, mode::on_reg<reg::y>, bne, mode::rel>(op::INY, op::BNE),
+
+		// carry setup and arithmetic
+		make_fused<set_flag<flag::c, false>, mode::imp, alu<adc>, mode::im>(op::CLC, op::ADC_IM),
+		make_fused<set_flag<flag::c, false>, mode::imp, alu<adc>, mode::zp>(op::CLC, op::ADC_ZP),
+		make_fused<set_flag<flag::c, false>, mode::imp, alu<adc>, mode::abs>(op::CLC, op::ADC_ABS),
+		make_fused<set_flag<flag::c, true>, mode::imp, alu<sbc>, mode::im>(op::SEC, op::SBC_IM),
+		make_fused<set_flag<flag::c, true>, mode::imp, alu<sbc>, mode::zp>(op::SEC, op::SBC_ZP),
+		make_fused<set_flag<flag::c, true>, mode::imp, alu<sbc>, mode::abs>(op::SEC, op::SBC_ABS),
+
+		// moves
+		make_fused<load<reg::a>, mode::im, store<reg::a>, mode::zp>(op::LDA_IM, op::STA_ZP),
+		make_fused<load<reg::a>, mode::zp, store<reg::a>, mode::zp>(op::LDA_ZP, op::STA_ZP),
+	};
+}();
+
+// nullptr if pair isn't fused
+inline decoded_handler find_fused(u8 first, u8 second)
+{
+	for (const fused_entry& entry : fused_pairs)
+	{
+		if (entry.first == first && entry.second == second)
+		{
+			return entry.exec;
+		}
+	}
+	return nullptr;
+}
+
+/// <summary>
+/// Compiles 'path', runs it once through op_table and counts every pair of opcodes executed back to back.
+/// Prints 'top' most frequent pairs and marks the ones already in fused_pairs.
+/// </summary>
+void report_pair_stats(const std::string& path, u32 top = PAIR_STATS_TOP);
\ No newline at end of file
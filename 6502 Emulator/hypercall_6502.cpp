@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "hypercall_6502.h"
+
+constexpr u32 MAX_HYPERCALL_STRING = 256;	// longest format or path, longer ones are cut
+
+u16 hypercall_word(const cpu& cpu_ref, u8 offset)
+{
+	u8 addr = u8(cpu_ref.hypercall_block + offset);
+	return cpu_ref.mem[addr] | (cpu_ref.mem[u8(addr + 1)] << BIT_SIZE);
+}
+
+void set_hypercall_word(cpu& cpu_ref, u8 offset, u16 value)
+{
+	u8 addr = u8(cpu_ref.hypercall_block + offset);
+	cpu_ref.write(addr, u8(value));
+	cpu_ref.write(u8(addr + 1), u8(value >> BIT_SIZE));
+}
+
+void register_hypercall(cpu& cpu_ref, u8 service, hypercall_handler handler)
+{
+	cpu_ref.hypercalls[service] = handler;
+}
+
+// zero-terminated string at 'addr', wraps around memory
+static std::string read_string(const cpu& cpu_ref, u16 addr)
+{
+	std::string text;
+	for (u32 i = 0; i < MAX_HYPERCALL_STRING && cpu_ref.mem[u16(addr + i)] != 0; i++)
+	{
+		text += char(cpu_ref.mem[u16(addr + i)]);
+	}
+	return text;
+}
+
+static void mul16(cpu& c)
+{
+	u32 product = u32(hypercall_word(c, 0)) * hypercall_word(c, 2);
+	set_hypercall_word(c, 4, u16(product));
+	set_hypercall_word(c, 6, u16(product >> (2 * BIT_SIZE)));
+	c.c = 0;
+}
+
+static void div16(cpu& c)
+{
+	u16 dividend = hypercall_word(c, 0);
+	u16 divisor = hypercall_word(c, 2);
+	if (divisor == 0)
+	{
+		c.c = 1;
+		return;
+	}
+	set_hypercall_word(c, 4, dividend / divisor);
+	set_hypercall_word(c, 6, dividend % divisor);
+	c.c = 0;
+}
+
+static void copy(cpu& c)
+{
+	u16 src = hypercall_word(c, 0);
+	u16 dst = hypercall_word(c, 2);
+	u16 count = hypercall_word(c, 4);
+
+	// source is read whole first, overlapping ranges copy as memmove
+	std::vector<u8> bytes(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		bytes[i] = c.mem[u16(src + i)];
+	}
+	for (u32 i = 0; i < count; i++)
+	{
+		c.write(u16(dst + i), bytes[i]);
+	}
+	c.c = 0;
+}
+
+static void print(cpu& c)
+{
+	std::string format = read_string(c, hypercall_word(c, 0));
+	const u8 args[] = { c.a, c.x, c.y };
+	u32 next_arg = 0;
+
+	for (u32 i = 0; i < format.size(); i++)
+	{
+		if (format[i] != '%' || i + 1 == format.size())
+		{
+			std::cout << format[i];
+			continue;
+		}
+
+		char spec = format[++i];
+		if (spec == '%' || next_arg == std::size(args))
+		{
+			std::cout << spec;
+			continue;
+		}
+		u8 arg = args[next_arg++];
+		switch (spec)
+		{
+		case 'd':
+			std::cout << u16(arg);
+			break;
+		case 'x':
+			std::cout << std::hex << u16(arg) << std::dec;
+			break;
+		case 'c':
+			std::cout << char(arg);
+			break;
+		default:
+			std::cout << '%' << spec;
+			next_arg--;
+			break;
+		}
+	}
+	c.c = 0;
+}
+
+// guest path inside cpu::hypercall_root, empty if it is absolute, has a drive or a '..' component,
+// or if it leads out of the root through a symbolic link
+static std::string confined_path(const cpu& cpu_ref, const std::string& path)
+{
+	if (cpu_ref.hypercall_root.empty() || path.empty() || path[0] == '/' || path[0] == '\\' || path.find(':') != std::string::npos)
+	{
+		return {};
+	}
+	for (size_t begin = 0; begin <= path.size();)
+	{
+		size_t end = path.find_first_of("/\\", begin);
+		if (end == std::string::npos)
+		{
+			end = path.size();
+		}
+		if (path.compare(begin, end - begin, "..") == 0)
+		{
+			return {};
+		}
+		begin = end + 1;
+	}
+
+	// links are resolved on both sides, the resolved path has to start with every component of the resolved root
+	std::error_code error;
+	std::filesystem::path root = std::filesystem::canonical(cpu_ref.hypercall_root, error);
+	if (error)
+	{
+		return {};
+	}
+	std::filesystem::path full = std::filesystem::weakly_canonical(root / path, error);
+	if (error || std::mismatch(root.begin(), root.end(), full.begin(), full.end()).first != root.end())
+	{
+		return {};
+	}
+	return full.string();
+}
+
+static void load(cpu& c)
+{
+	std::string path = confined_path(c, read_string(c, hypercall_word(c, 0)));
+	std::ifstream fin;
+	if (!path.empty())
+	{
+		fin.open(path, std::ios::binary);
+	}
+	if (!fin.is_open())
+	{
+		c.c = 1;
+		return;
+	}
+
+	u16 dst = hypercall_word(c, 2);
+	u16 limit = hypercall_word(c, 4);
+	u16 count = 0;
+	char byte;
+	while (count < limit && fin.get(byte))
+	{
+		c.write(u16(dst + count), u8(byte));
+		count++;
+	}
+	set_hypercall_word(c, 6, count);
+	c.c = 0;
+}
+
+void register_standard_hypercalls(cpu& cpu_ref)
+{
+	register_hypercall(cpu_ref, u8(hypercall_service::mul16), &mul16);
+	register_hypercall(cpu_ref, u8(hypercall_service::div16), &div16);
+	register_hypercall(cpu_ref, u8(hypercall_service::copy), &copy);
+	register_hypercall(cpu_ref, u8(hypercall_service::print), &print);
+}
+
+void register_file_hypercalls(cpu& cpu_ref, const std::string& root)
+{
+	if (root.empty())
+	{
+		return;
+	}
+	cpu_ref.hypercall_root = root;
+	register_hypercall(cpu_ref, u8(hypercall_service::load), &load);
+}
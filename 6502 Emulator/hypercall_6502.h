@@ -0,0 +1,50 @@
+#pragma once
+#include "vm_6502.h"
+
+// Hypercalls: HYP #service (0x02, unofficial) calls cpu::hypercalls[service], a host function registered per cpu.
+// Arguments are a, x, y and the parameter block in zero page at cpu::hypercall_block, words are little-endian.
+// A service clears carry when it succeeds and sets it on error, unregistered services only set carry,
+// so a program can probe for a service and fall back to its own code.
+// Services write memory through cpu::write, decoded code they overwrite is dropped as with any store.
+// Standard services (register_standard_hypercalls), offsets are into the parameter block:
+//   mul16:	[0] * [2] -> [4] 32 bit product
+//   div16:	[0] / [2] -> [4] quotient, [6] remainder, carry on division by zero
+//   copy:	[4] bytes from [0] to [2], as memmove
+//   print:	zero-terminated format at [0] to stdout, %d %x %c take a, x, y in this order, %% prints %
+// File services reach the host file system and are opt-in (register_file_hypercalls),
+// paths are relative to cpu::hypercall_root, absolute paths, '..' components and links leading out of it are rejected with carry:
+//   load:	zero-terminated path at [0], up to [4] bytes of the file to [2], [6] bytes read, carry if it can't be opened
+
+enum struct hypercall_service : u8
+{
+	mul16,
+	div16,
+	copy,
+	print,
+	load
+};
+
+/// <summary>
+/// Word at 'offset' in the parameter block.
+/// </summary>
+u16 hypercall_word(const cpu& cpu_ref, u8 offset);
+
+/// <summary>
+/// Writes word at 'offset' in the parameter block.
+/// </summary>
+void set_hypercall_word(cpu& cpu_ref, u8 offset, u16 value);
+
+/// <summary>
+/// Registers 'handler' as 'service' of 'cpu_ref', nullptr unregisters it.
+/// </summary>
+void register_hypercall(cpu& cpu_ref, u8 service, hypercall_handler handler);
+
+/// <summary>
+/// Registers the hypercall_services that don't touch the host, everything but load.
+/// </summary>
+void register_standard_hypercalls(cpu& cpu_ref);
+
+/// <summary>
+/// Registers the file services confined to host directory 'root', an empty 'root' leaves them unregistered.
+/// </summary>
+void register_file_hypercalls(cpu& cpu_ref, const std::string& root);
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#include "idiom_6502.h"
+#include "op_policies_6502.h"
+
+static const char* const IDIOM_NAMES[IDIOM_KIND_COUNT] = { "none", "copy", "fill", "multiply", "divide" };
+
+static constexpr bool is_load(u8 code)
+{
+	return code == op::LDA_ABS_X || code == op::LDA_ZP_X || code == op::LDA_ABS_Y || code == op::LDA_IN_Y;
+}
+
+static constexpr bool is_store(u8 code)
+{
+	return code == op::STA_ABS_X || code == op::STA_ZP_X || code == op::STA_ABS_Y || code == op::STA_IN_Y;
+}
+
+// is_load and is_store pick exactly the indexed LDA and STA of op_entries
+static constexpr bool loads_and_stores_match_entries()
+{
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		const op_entry& entry = op_entries[code];
+		op_mode mode = entry.mode;
+		bool indexed = mode == op_mode::abs_x || mode == op_mode::zp_x || mode == op_mode::abs_y || mode == op_mode::in_y;
+		bool lda = entry.mnemonic != nullptr && std::string_view(entry.mnemonic) == "LDA";
+		bool sta = entry.mnemonic != nullptr && std::string_view(entry.mnemonic) == "STA";
+		if (is_load(u8(code)) != (lda && indexed) || is_store(u8(code)) != (sta && indexed))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(loads_and_stores_match_entries());
+
+// register indexing load/store or changed by counting instruction: 'X', 'Y', 0 - neither
+static char loop_register(u8 code)
+{
+	switch (code)
+	{
+	case op::LDA_ABS_X: case op::LDA_ZP_X: case op::STA_ABS_X: case op::STA_ZP_X:
+	case op::INX: case op::DEX:
+		return 'X';
+	case op::LDA_ABS_Y: case op::LDA_IN_Y: case op::STA_ABS_Y: case op::STA_IN_Y:
+	case op::INY: case op::DEY:
+		return 'Y';
+	}
+	return 0;
+}
+
+static u16 operand_at(const ram& mem, u16 addr, u8 length)
+{
+	return length == 3 ? u16(mem[u16(addr + 1)] | (mem[u16(addr + 2)] << BIT_SIZE)) : mem[u16(addr + 1)];
+}
+
+// effective address of copy/fill load or store for given value of its index register
+static u16 indexed_addr(const cpu& c, u8 code, u16 raw, u8 index)
+{
+	switch (code)
+	{
+	case op::LDA_ZP_X: case op::STA_ZP_X:
+		return u8(raw + index);
+	case op::LDA_IN_Y: case op::STA_IN_Y:
+		return u16(zp_word(c, u8(raw)) + index);
+	}
+	return u16(raw + index);
+}
+
+// index values in [first, first + count) for which copy load pays a cycle for crossing a page
+static u32 load_crossings(const cpu& c, const idiom_loop& loop, u32 first, u32 count)
+{
+	if (loop.src != op::LDA_ABS_X && loop.src != op::LDA_ABS_Y && loop.src != op::LDA_IN_Y)
+	{
+		return 0;
+	}
+	// index reaching the next page after low byte of base address, 256 - never
+	u32 from = std::max(first, RAM_PAGE_SIZE - u8(indexed_addr(c, loop.src, loop.src_raw, 0)));
+	return first + count > from ? first + count - from : 0;
+}
+
+// cycles of a branch taken from 'at' to 'target'
+static u32 taken_cycles(u16 at, u16 target)
+{
+	return 1 + page_crossed(u16(at + 2), target);
+}
+
+// zero page pointer of (zp),Y operand lies in [first, first + count)
+static bool pointer_in(u8 code, u16 raw, u32 first, u32 count)
+{
+	if (code != op::LDA_IN_Y && code != op::STA_IN_Y)
+	{
+		return false;
+	}
+	return u32(u8(raw)) - first < count || u32(u8(raw + 1)) - first < count;
+}
+
+idiom_loop match_idiom(const ram& mem, u16 head)
+{
+	idiom_loop loop;
+	auto at = [&](u32 offset) { return mem[u16(head + offset)]; };
+	auto closes = [&](u32 offset) { return at(offset) == op::BNE && branch_target(u16(head + offset), at(offset + 1)) == head; };
+	auto counts_down = [&](u32 offset) { return at(offset) == op::DEX || at(offset) == op::DEY; };
+	u8 code = at(0);
+
+	if (is_load(code) || is_store(code))
+	{
+		u32 offset = 0;
+		if (is_load(code))
+		{
+			loop.src = code;
+			loop.src_raw = operand_at(mem, head, op_entries[code].length);
+			offset += op_entries[code].length;
+		}
+		u8 store = at(offset);
+		u8 counter = at(offset + op_entries[store].length);
+		if (!is_store(store) || loop_register(counter) != loop_register(store)
+			|| (loop.src != 0 && loop_register(loop.src) != loop_register(store)))
+		{
+			return idiom_loop();
+		}
+		loop.dst = store;
+		loop.dst_raw = operand_at(mem, u16(head + offset), op_entries[store].length);
+		offset += op_entries[store].length + 1;
+		if (!closes(offset))
+		{
+			return idiom_loop();
+		}
+		loop.kind = loop.src != 0 ? idiom_kind::copy : idiom_kind::fill;
+		loop.counter = counter;
+		loop.length = u8(offset + 2);
+		return loop;
+	}
+
+	if (code == op::BCC && branch_target(head, at(1)) == u16(head + 5) && at(2) == op::CLC && at(3) == op::ADC_ZP
+		&& at(5) == op::ROR_A && at(6) == op::ROR_ZP && counts_down(8) && closes(9))
+	{
+		loop.kind = idiom_kind::multiply;
+		loop.length = 11;
+		loop.counter = at(8);
+		loop.src = op::ADC_ZP;
+		loop.src_raw = at(4);
+		loop.dst = op::ROR_ZP;
+		loop.dst_raw = at(7);
+		return loop;
+	}
+
+	if (code == op::ASL_ZP && at(2) == op::ROL_A && at(3) == op::CMP_ZP
+		&& at(5) == op::BCC && branch_target(u16(head + 5), at(6)) == u16(head + 11)
+		&& at(7) == op::SBC_ZP && at(8) == at(4) && at(9) == op::INC_ZP && at(10) == at(1) && counts_down(11) && closes(12))
+	{
+		loop.kind = idiom_kind::divide;
+		loop.length = 14;
+		loop.counter = at(11);
+		loop.src = op::SBC_ZP;
+		loop.src_raw = at(4);
+		loop.dst = op::ASL_ZP;
+		loop.dst_raw = at(1);
+	}
+	return loop;
+}
+
+// copy and fill, one pass: [LDA src;] STA dst; counter; BNE head
+static i32 run_transfer(cpu& c, const idiom_loop& loop, i32 operators)
+{
+	bool copy = loop.kind == idiom_kind::copy;
+	i32 pass_operators = copy ? 4 : 3;
+	u8& index = loop_register(loop.counter) == 'X' ? c.x : c.y;
+	bool up = loop.counter == op::INX || loop.counter == op::INY;
+
+	// passes until the counter reaches 0, BNE falls through on that pass
+	u32 left = up ? u8(0 - index) : index;
+	if (left == 0)
+	{
+		left = RAM_PAGE_SIZE;
+	}
+	u32 run = std::min(left, u32(operators / pass_operators));
+	if (run == 0)
+	{
+		return 0;
+	}
+
+	// index values of the run in increasing order, if they don't wrap
+	i32 lowest = up ? index : i32(index) - i32(run) + 1;
+	u32 done = 0;
+	u32 crossings = 0;	// page crossings of the load
+	if (lowest >= 0 && lowest + run <= RAM_PAGE_SIZE)
+	{
+		u32 dst = indexed_addr(c, loop.dst, loop.dst_raw, u8(lowest));
+		u32 src = copy ? indexed_addr(c, loop.src, loop.src_raw, u8(lowest)) : 0;
+		bool contiguous = indexed_addr(c, loop.dst, loop.dst_raw, u8(lowest + run - 1)) == dst + run - 1
+			&& (!copy || indexed_addr(c, loop.src, loop.src_raw, u8(lowest + run - 1)) == src + run - 1);
+		bool disjoint = (!copy || src + run <= dst || dst + run <= src)
+			&& !pointer_in(loop.dst, loop.dst_raw, dst, run) && !(copy && pointer_in(loop.src, loop.src_raw, dst, run));
+
+		bool code_written = false;
+		for (u32 page = dst >> BIT_SIZE; contiguous && page <= (dst + run - 1) >> BIT_SIZE; page++)
+		{
+			code_written = code_written || c.code_pages[page];
+		}
+
+		// order of passes doesn't matter, each byte is written once and nothing written is read back
+		if (contiguous && disjoint && !code_written)
+		{
+			if constexpr (COUNT_CYCLES)
+			{
+				crossings = load_crossings(c, loop, u32(lowest), run);
+			}
+			if (copy)
+			{
+				memcpy(c.mem.data + dst, c.mem.data + src, run);
+				c.a = c.mem[up ? src + run - 1 : src];
+			}
+			else
+			{
+				memset(c.mem.data + dst, c.a, run);
+			}
+			c.mem.mark_dirty(u8(dst >> BIT_SIZE), u8((dst + run - 1) >> BIT_SIZE));
+			index = up ? u8(index + run) : u8(index - run);
+			done = run;
+		}
+	}
+
+	// byte by byte in program order, stops before a pass writing into decoded code
+	for (; done < run; done++)
+	{
+		u16 dst = indexed_addr(c, loop.dst, loop.dst_raw, index);
+		if (c.code_pages[dst >> BIT_SIZE])
+		{
+			break;
+		}
+		if (copy)
+		{
+			if constexpr (COUNT_CYCLES)
+			{
+				crossings += load_crossings(c, loop, index, 1);
+			}
+			c.a = c.mem[indexed_addr(c, loop.src, loop.src_raw, index)];
+		}
+		c.mem[dst] = c.a;
+		c.mem.dirty_pages[dst >> BIT_SIZE] = 1;
+		index = up ? u8(index + 1) : u8(index - 1);
+	}
+	if (done == 0)
+	{
+		return 0;
+	}
+
+	if constexpr (COUNT_CYCLES)
+	{
+		// every BNE is taken except the one falling through
+		u32 taken = taken_cycles(u16(c.pc + loop.length - 2), c.pc);
+		u32 pass = (copy ? op_cycles[loop.src] : 0) + op_cycles[loop.dst] + op_cycles[loop.counter] + op_cycles[op::BNE] + taken;
+		c.cycles += done * pass + crossings - (done == left ? taken : 0);
+	}
+	c.set_nz(index);
+	c.pc = done == left ? u16(c.pc + loop.length) : c.pc;
+	return i32(done) * pass_operators;
+}
+
+// multiply and divide, zero page operands, passes run until the counter reaches 0
+static i32 run_arithmetic(cpu& c, const idiom_loop& loop, i32 operators)
+{
+	// both write their zero page operand
+	if (c.code_pages[0])
+	{
+		return 0;
+	}
+
+	u8& counter = loop.counter == op::DEX ? c.x : c.y;
+	u8& shifted = c.mem[loop.dst_raw];
+	bool multiply = loop.kind == idiom_kind::multiply;
+	i32 longest_pass = multiply ? 7 : 8;
+	i32 done = 0;
+	u16 head = c.pc;
+	u64 cycles = 0;
+
+	while (operators - done >= longest_pass)
+	{
+		if (multiply)
+		{
+			// BCC skip; CLC; ADC src; skip: ROR A; ROR dst
+			done += 5;
+			cycles += op_cycles[op::BCC] + op_cycles[op::ROR_A] + op_cycles[op::ROR_ZP];
+			if (c.c)
+			{
+				c.c = 0;
+				operation::adc::apply(c, c.mem[loop.src_raw]);
+				done += 2;
+				cycles += op_cycles[op::CLC] + op_cycles[op::ADC_ZP];
+			}
+			else
+			{
+				cycles += taken_cycles(head, u16(head + 5));
+			}
+			c.a = operation::ror::apply(c, c.a);
+			shifted = operation::ror::apply(c, shifted);
+		}
+		else
+		{
+			// ASL dst; ROL A; CMP src; BCC skip; SBC src; INC dst
+			done += 6;
+			cycles += op_cycles[op::ASL_ZP] + op_cycles[op::ROL_A] + op_cycles[op::CMP_ZP] + op_cycles[op::BCC];
+			shifted = operation::asl::apply(c, shifted);
+			c.a = operation::rol::apply(c, c.a);
+			operation::cmp<reg::a>::apply(c, c.mem[loop.src_raw]);
+			if (c.c)
+			{
+				operation::sbc::apply(c, c.mem[loop.src_raw]);
+				shifted = operation::inc::apply(c, shifted);
+				done += 2;
+				cycles += op_cycles[op::SBC_ZP] + op_cycles[op::INC_ZP];
+			}
+			else
+			{
+				cycles += taken_cycles(u16(head + 5), u16(head + 11));
+			}
+		}
+
+		// DEX/DEY; BNE head
+		counter = operation::dec::apply(c, counter);
+		cycles += op_cycles[loop.counter] + op_cycles[op::BNE];
+		if (counter == 0)
+		{
+			c.pc = u16(c.pc + loop.length);
+			break;
+		}
+		cycles += taken_cycles(u16(head + loop.length - 2), head);
+	}
+	// every pass writes the zero page operand
+	if (done > 0)
+	{
+		c.mem.dirty_pages[0] = 1;
+	}
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += cycles;
+	}
+	return done;
+}
+
+i32 run_idiom(cpu& cpu_ref, const idiom_loop& loop, i32 operators)
+{
+	// native passes work on mem.data, not through the page table
+	if (!cpu_ref.mem.plain())
+	{
+		return 0;
+	}
+
+	i32 done = 0;
+	switch (loop.kind)
+	{
+	case idiom_kind::copy:
+	case idiom_kind::fill:
+		done = run_transfer(cpu_ref, loop, operators);
+		break;
+	case idiom_kind::multiply:
+	case idiom_kind::divide:
+		done = run_arithmetic(cpu_ref, loop, operators);
+		break;
+	default:
+		break;
+	}
+
+	if (done > 0)
+	{
+		cpu_ref.idiom_runs[u32(loop.kind)]++;
+	}
+	return done;
+}
+
+void report_idioms(const cpu& cpu_ref)
+{
+	std::cout << "\nLoops run natively:\n";
+	for (u32 kind = 1; kind < IDIOM_KIND_COUNT; kind++)
+	{
+		std::cout << "  " << IDIOM_NAMES[kind] << ": " << cpu_ref.idiom_runs[kind] << '\n';
+	}
+}
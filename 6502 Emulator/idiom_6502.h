@@ -0,0 +1,53 @@
+#pragma once
+#include "vm_6502.h"
+
+// Idioms: standard loops that run as native host code instead of operator by operator.
+//   copy:		LDA src; STA dst; INX/DEX/INY/DEY; BNE head		(src, dst - abs,X/abs,Y/zp,X/(zp),Y on the counter)
+//				memcpy when source and destination don't overlap, byte loop otherwise
+//   fill:		STA dst; INX/DEX/INY/DEY; BNE head					memset when possible, byte loop otherwise
+//   multiply:	BCC skip; CLC; ADC zp; skip: ROR A; ROR zp; DEX/DEY; BNE head			(shift-and-add 8x8)
+//   divide:	ASL zp; ROL A; CMP zp; BCC skip; SBC zp; INC zp; skip: DEX/DEY; BNE head	(shift-and-subtract 16/8)
+//				whole passes run through operation policies on cpu, without fetch, decode and dispatch
+// Registers, flags, memory, operator and cycle counts end up exactly as after interpreting the same passes.
+// A pass that would write into a page holding decoded code is left to the interpreter (self-modifying loops stay exact).
+// Predecoded and fused engines recognize loop heads when decoding, see cpu::run_idioms,
+// cpu::idiom_runs counts how many times native code took over a loop.
+
+constexpr u32 MAX_IDIOM_LOOP_BYTES = 14;	// divide loop
+
+enum struct idiom_kind : u8
+{
+	none,
+	copy,
+	fill,
+	multiply,
+	divide
+};
+static_assert(u32(idiom_kind::divide) + 1 == IDIOM_KIND_COUNT);
+
+struct idiom_loop
+{
+	idiom_kind kind = idiom_kind::none;
+	u8 length = 0;		// bytes from head to the end of the loop
+	u8 counter = 0;		// opcode of counting instruction
+	u8 src = 0;			// copy: opcode of load, multiply/divide: opcode of accumulator operation reading 'src_raw'
+	u16 src_raw = 0;
+	u8 dst = 0;			// copy/fill: opcode of store, multiply/divide: opcode of shift writing 'dst_raw'
+	u16 dst_raw = 0;
+};
+
+/// <summary>
+/// Recognizes idiom loop starting at 'head', kind is none if there is no such loop.
+/// </summary>
+idiom_loop match_idiom(const ram& mem, u16 head);
+
+/// <summary>
+/// Runs whole passes of 'loop' natively with cpu at its head, never more than 'operators'.
+/// Returns operators consumed, 0 - nothing was done and the head has to run normally.
+/// </summary>
+i32 run_idiom(cpu& cpu_ref, const idiom_loop& loop, i32 operators);
+
+/// <summary>
+/// Prints cpu::idiom_runs by kind.
+/// </summary>
+void report_idioms(const cpu& cpu_ref);
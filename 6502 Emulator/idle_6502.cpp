@@ -0,0 +1,163 @@
+#include <algorithm>
+
+#include "idle_6502.h"
+#include "op_policies_6502.h"
+
+// conditional branch, relative mode is only theirs on NMOS
+static bool is_branch(u8 code)
+{
+	return op_entries[code].mode == op_mode::rel;
+}
+
+static u16 operand_at(const ram& mem, u16 addr, u8 length)
+{
+	return length == 3 ? u16(mem[u16(addr + 1)] | (mem[u16(addr + 2)] << BIT_SIZE)) : mem[u16(addr + 1)];
+}
+
+// register or memory counter of delay loop, 0 if code doesn't count
+static u8 delay_counter_length(u8 code)
+{
+	switch (code)
+	{
+	case op::DEX: case op::DEY: case op::INX: case op::INY:
+	case op::DEC_ZP: case op::INC_ZP:
+	case op::DEC_ABS: case op::INC_ABS:
+		return op_entries[code].length;
+	}
+	return 0;
+}
+
+// instruction that may follow a load in spin loop, compares or masks loaded register
+static bool is_spin_test(u8 load, u8 code)
+{
+	switch (load)
+	{
+	case op::LDA_ZP: case op::LDA_ABS:
+		return code == op::CMP_IM || code == op::CMP_ZP || code == op::CMP_ABS || code == op::AND_IM;
+	case op::LDX_ZP: case op::LDX_ABS:
+		return code == op::CPX_IM || code == op::CPX_ZP || code == op::CPX_ABS;
+	case op::LDY_ZP: case op::LDY_ABS:
+		return code == op::CPY_IM || code == op::CPY_ZP || code == op::CPY_ABS;
+	}
+	return false;
+}
+
+static bool is_spin_read(u8 code)
+{
+	switch (code)
+	{
+	case op::LDA_ZP: case op::LDA_ABS:
+	case op::LDX_ZP: case op::LDX_ABS:
+	case op::LDY_ZP: case op::LDY_ABS:
+	case op::BIT_ZP: case op::BIT_ABS:
+		return true;
+	}
+	return false;
+}
+
+idle_loop match_idle_loop(const ram& mem, u16 head)
+{
+	idle_loop loop;
+	u8 code = mem[head];
+
+	if (code == op::JMP_ABS && operand_at(mem, head, 3) == head)
+	{
+		loop.kind = idle_kind::spin;
+		loop.operators = 1;
+		loop.length = 3;
+		return loop;
+	}
+
+	if (u8 length = delay_counter_length(code))
+	{
+		u16 branch = u16(head + length);
+		u16 counter_addr = length > 1 ? operand_at(mem, head, length) : 0;
+		bool counter_in_loop = length > 1 && u16(counter_addr - head) < length + 2;
+		if (mem[branch] == op::BNE && branch_target(branch, mem[u16(branch + 1)]) == head && !counter_in_loop)
+		{
+			loop.kind = idle_kind::delay;
+			loop.operators = 2;
+			loop.length = length + 2;
+			loop.counter = code;
+			loop.counter_addr = counter_addr;
+		}
+		return loop;
+	}
+
+	if (is_spin_read(code))
+	{
+		u16 at = u16(head + op_entries[code].length);
+		u8 operators = 1;
+		if (is_spin_test(code, mem[at]))
+		{
+			at += op_entries[mem[at]].length;
+			operators++;
+		}
+		if (is_branch(mem[at]) && branch_target(at, mem[u16(at + 1)]) == head)
+		{
+			loop.kind = idle_kind::spin;
+			loop.operators = operators + 1;
+			loop.length = u8(u16(at + 2 - head));
+		}
+	}
+	return loop;
+}
+
+i32 skip_idle_loop(cpu& cpu_ref, const idle_loop& loop, i32 operators)
+{
+	// a mapped page may change between passes
+	i32 passes = operators / loop.operators;
+	if (passes == 0 || !cpu_ref.mem.plain())
+	{
+		return 0;
+	}
+
+	u16 head = cpu_ref.pc;
+	if (loop.kind == idle_kind::delay)
+	{
+		bool memory = delay_counter_length(loop.counter) > 1;
+		u8& reg = (loop.counter == op::DEX || loop.counter == op::INX) ? cpu_ref.x : cpu_ref.y;
+		u8 value = memory ? cpu_ref.mem[loop.counter_addr] : reg;
+		bool up = loop.counter == op::INX || loop.counter == op::INY || loop.counter == op::INC_ZP || loop.counter == op::INC_ABS;
+
+		// passes until counter reaches 0, BNE falls through on that pass
+		u32 left = up ? u8(0 - value) : value;
+		if (left == 0)
+		{
+			left = RAM_PAGE_SIZE;
+		}
+		u32 run = std::min(left, u32(passes));
+		value = up ? u8(value + run) : u8(value - run);
+		if (memory)
+		{
+			cpu_ref.write(loop.counter_addr, value);
+		}
+		else
+		{
+			reg = value;
+		}
+		cpu_ref.set_nz(value);
+		cpu_ref.pc = run == left ? u16(head + loop.length) : head;
+		if constexpr (COUNT_CYCLES)
+		{
+			// every BNE is taken except the one falling through
+			u32 taken = 1 + page_crossed(u16(head + loop.length), head);
+			cpu_ref.cycles += run * (op_cycles[loop.counter] + op_cycles[op::BNE] + taken) - (run == left ? taken : 0);
+		}
+		return i32(run) * loop.operators;
+	}
+
+	// first pass for real, then every pass repeats it, cycles too
+	u64 cycles = cpu_ref.cycles;
+	for (u8 i = 0; i < loop.operators; i++)
+	{
+		cpu_ref.exe_op(cpu_ref.mem[cpu_ref.pc]);
+		cpu_ref.pc++;
+	}
+	if (cpu_ref.pc != head)
+	{
+		return loop.operators;
+	}
+	cpu_ref.cycles += (passes - 1) * (cpu_ref.cycles - cycles);
+	return passes * loop.operators;
+}
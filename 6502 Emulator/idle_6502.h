@@ -0,0 +1,40 @@
+#pragma once
+#include "vm_6502.h"
+
+// Idle loops: short loops whose state can't change except through the loop counter or from outside the program.
+//   delay:	DEX/DEY/INX/INY/DEC M/INC M; BNE head
+//			runs until the counter wraps to 0, skipped analytically straight to the exit
+//   spin:	LDA/LDX/LDY M [CMP/CPX/CPY/AND operand]; Bxx head,  BIT M; Bxx head,  JMP head
+//			nothing in the loop writes, so state after one pass is a fixed point and every next pass is the same,
+//			passes are skipped up to the budget (nothing outside the program writes memory while it runs)
+// Skipped passes are counted as operators (and cycles) exactly like running them, state ends up the same as after running them.
+// Predecoded and fused engines recognize loop heads when decoding, see cpu::skip_idle.
+
+constexpr u32 MAX_IDLE_LOOP_BYTES = 7;	// LDA abs, CMP #, Bxx
+
+enum struct idle_kind : u8
+{
+	none,
+	delay,
+	spin
+};
+
+struct idle_loop
+{
+	idle_kind kind = idle_kind::none;
+	u8 operators = 0;		// one pass
+	u8 length = 0;			// bytes from head to the end of the loop
+	u8 counter = 0;			// delay: opcode of counting instruction
+	u16 counter_addr = 0;	// delay: address of memory counter
+};
+
+/// <summary>
+/// Recognizes idle loop starting at 'head', kind is none if there is no such loop.
+/// </summary>
+idle_loop match_idle_loop(const ram& mem, u16 head);
+
+/// <summary>
+/// Runs or skips whole passes of 'loop' with cpu at its head, never more than 'operators'.
+/// Returns operators consumed, 0 - nothing was done and the head has to run normally.
+/// </summary>
+i32 skip_idle_loop(cpu& cpu_ref, const idle_loop& loop, i32 operators);
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "vm_6502.h"
+
+//#define JIT_WIN64_6502	// compile blocks on 64-bit Windows too, its entry path (rcx argument, Win64 callee-saved set) is untested
+
+// basic-block compiler to x86-64, other hosts run cpu::start_jit through the loop
+#if defined(__x86_64__) || (defined(_M_X64) && defined(JIT_WIN64_6502))
+#define JIT_6502
+#endif
+
+// Each basic block (up to a branch, JMP, JSR or RTS) is compiled once into host code.
+// Inside compiled code a, x, y, c, v and z/n live in host registers, sp, i and d stay in jit_state.
+// Blocks jump to each other through 'blocks' table without going back to cpu::start_jit, table misses go back to compile.
+// Compiled code never calls anything, everything it can't do safely is left to the interpreter:
+//   - operators that aren't compiled (BRK, RTI, PHP, PLP, KIL, HYP and unknown ones) end the block before them
+//   - a write into a page from cpu::code_pages leaves the block before the write, so cpu::write can invalidate
+//   - ADC and SBC leave the block before them while d is set, compiled code is binary only (d changes in the interpreter)
+//   - a block needing more operators than left leaves before its first instruction
+//   - a block ends before a breakpoint and none starts at one, cpu::start_jit sees them between blocks
+// so 'k' can only be set by the interpreter and every operator is counted exactly like in cpu::start_loop.
+// With CYCLES_6502 a block adds base cycles of all its operators at entry and gives back the ones it didn't run,
+// page crossing of indexed reads and taken branches add their cycles where they happen.
+
+constexpr u32 JIT_ARENA_BYTES = 8 * 1024 * 1024;
+constexpr u32 JIT_MAX_BLOCK_OPERATORS = 64;
+constexpr u32 JIT_MAX_BLOCK_BYTES = 16 * 1024;	// host code of one block, with every exit stub
+constexpr u32 JIT_PAGE_BYTES = 4 * 1024;		// protection granularity of the arena
+
+enum struct jit_exit : u8
+{
+	lookup,		// no block at pc, compile it or interpret
+	interpret	// next operator must be run by the interpreter
+};
+
+// cpu state as compiled code sees it, offsets are taken by compiled code
+struct jit_state
+{
+	u8* mem = nullptr;
+	const u8* code_pages = nullptr;
+	u8* dirty_pages = nullptr;		// ram::dirty_pages, stores mark their page
+	void* const* blocks = nullptr;
+	const void* entry = nullptr;
+
+	i32 budget = 0;			// operators left
+	u64 cycles = 0;			// cpu::cycles, only with CYCLES_6502
+	u16 pc = 0;
+	u8 sp = 0;
+	u8 a = 0;
+	u8 x = 0;
+	u8 y = 0;
+	u8 c = 0;
+	u8 v = 0;
+	u8 z_value = 0;			// z is set if z_value == 0
+	u8 n_value = 0;			// n is bit 7 of n_value
+	u8 i = 0;
+	u8 d = 0;				// read only, SED, CLD, PLP and RTI aren't compiled
+	jit_exit exit = jit_exit::lookup;
+};
+
+struct jit_cache
+{
+	u8* arena = nullptr;	// executable memory, trampoline at start, blocks after it
+	u32 used = 0;
+	u32 trampoline_bytes = 0;
+	void (*enter)(jit_state* state) = nullptr;
+	const u8* exit_stub = nullptr;
+
+	std::vector<void*> blocks = std::vector<void*>(MAX_RAM_BYTES, nullptr);		// host code by 6502 address
+	std::array<std::vector<u16>, RAM_PAGE_COUNT> page_blocks = {};				// starts of blocks touching the page
+
+	bool verify = false;	// run every new block against the interpreter before using it
+	u32 verified = 0;
+	u32 mismatches = 0;
+
+	jit_cache();
+	~jit_cache();
+	jit_cache(const jit_cache&) = delete;
+	jit_cache& operator = (const jit_cache&) = delete;
+
+	// compiles block starting at cpu.pc, marks its pages in cpu.code_pages
+	// returns nullptr if first operator can't be compiled
+	void* compile(cpu& cpu_ref);
+
+	void invalidate_page(u8 page);
+
+	// drops every block and reuses the whole arena
+	void flush();
+
+	// arena pages holding bytes 'from'..'to' become read-write while code is written into them, read-execute otherwise,
+	// the arena is never writable and executable at once
+	void protect(u32 from, u32 to, bool writable);
+
+	// runs block on copy of cpu state and compares to cpu::start_loop with the same amount of operators
+	bool verify_block(const cpu& cpu_ref, void* entry, u32 operators);
+};
\ No newline at end of file
@@ -0,0 +1,1308 @@
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include "jit_6502.h"
+#include "op_policies_6502.h"
+
+#ifdef JIT_6502
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+// what compiled code does for an opcode, 'none' - left to the interpreter
+enum struct jit_kind : u8
+{
+	none,
+	lda, ldx, ldy, sta, stx, sty,
+	tax, tay, txa, tya, tsx, txs, pha, pla,
+	and_, eor, ora, bit, adc, sbc, cmp, cpx, cpy,
+	inc, dec, inx, iny, dex, dey,
+	asl, lsr, rol, ror,
+	jmp, jsr, rts,
+	bcc, bcs, beq, bmi, bne, bpl, bvc, bvs,
+	clc, cli, clv, sec, sei, nop
+};
+
+// mnemonic of every jit_kind, by its value
+constexpr const char* JIT_KIND_MNEMONICS[] =
+{
+	nullptr,
+	"LDA", "LDX", "LDY", "STA", "STX", "STY",
+	"TAX", "TAY", "TXA", "TYA", "TSX", "TXS", "PHA", "PLA",
+	"AND", "EOR", "ORA", "BIT", "ADC", "SBC", "CMP", "CPX", "CPY",
+	"INC", "DEC", "INX", "INY", "DEX", "DEY",
+	"ASL", "LSR", "ROL", "ROR",
+	"JMP", "JSR", "RTS",
+	"BCC", "BCS", "BEQ", "BMI", "BNE", "BPL", "BVC", "BVS",
+	"CLC", "CLI", "CLV", "SEC", "SEI", "NOP"
+};
+
+struct jit_op
+{
+	jit_kind kind = jit_kind::none;
+	op_mode mode = op_mode::imp;
+};
+
+// the table below only picks what compiled code does, addressing modes are taken from op_entries
+constexpr std::array<jit_op, OP_TABLE_SIZE> make_jit_ops()
+{
+	using k = jit_kind;
+
+	std::array<jit_op, OP_TABLE_SIZE> t = {};
+
+	// load/store operations
+	t[op::LDA_IM]		= { k::lda };
+	t[op::LDA_ZP]		= { k::lda };
+	t[op::LDA_ZP_X]		= { k::lda };
+	t[op::LDA_ABS]		= { k::lda };
+	t[op::LDA_ABS_X]	= { k::lda };
+	t[op::LDA_ABS_Y]	= { k::lda };
+	t[op::LDA_IN_X]		= { k::lda };
+	t[op::LDA_IN_Y]		= { k::lda };
+
+	t[op::STA_ZP]		= { k::sta };
+	t[op::STA_ZP_X]		= { k::sta };
+	t[op::STA_ABS]		= { k::sta };
+	t[op::STA_ABS_X]	= { k::sta };
+	t[op::STA_ABS_Y]	= { k::sta };
+	t[op::STA_IN_X]		= { k::sta };
+	t[op::STA_IN_Y]		= { k::sta };
+
+	t[op::LDX_IM]		= { k::ldx };
+	t[op::LDX_ZP]		= { k::ldx };
+	t[op::LDX_ZP_Y]		= { k::ldx };
+	t[op::LDX_ABS]		= { k::ldx };
+	t[op::LDX_ABS_Y]	= { k::ldx };
+
+	t[op::STX_ZP]		= { k::stx };
+	t[op::STX_ZP_Y]		= { k::stx };
+	t[op::STX_ABS]		= { k::stx };
+
+	t[op::LDY_IM]		= { k::ldy };
+	t[op::LDY_ZP]		= { k::ldy };
+	t[op::LDY_ZP_X]		= { k::ldy };
+	t[op::LDY_ABS]		= { k::ldy };
+	t[op::LDY_ABS_X]	= { k::ldy };
+
+	t[op::STY_ZP]		= { k::sty };
+	t[op::STY_ZP_X]		= { k::sty };
+	t[op::STY_ABS]		= { k::sty };
+
+	// register transfers
+	t[op::TAX]			= { k::tax };
+	t[op::TAY]			= { k::tay };
+	t[op::TXA]			= { k::txa };
+	t[op::TYA]			= { k::tya };
+
+	// stack operations, PHP and PLP are left to the interpreter (b, d and k aren't in host registers)
+	t[op::TSX]			= { k::tsx };
+	t[op::TXS]			= { k::txs };
+	t[op::PHA]			= { k::pha };
+	t[op::PLA]			= { k::pla };
+
+	// logical
+	t[op::AND_IM]		= { k::and_ };
+	t[op::AND_ZP]		= { k::and_ };
+	t[op::AND_ZP_X]		= { k::and_ };
+	t[op::AND_ABS]		= { k::and_ };
+	t[op::AND_ABS_X]	= { k::and_ };
+	t[op::AND_ABS_Y]	= { k::and_ };
+	t[op::AND_IN_X]		= { k::and_ };
+	t[op::AND_IN_Y]		= { k::and_ };
+
+	t[op::EOR_IM]		= { k::eor };
+	t[op::EOR_ZP]		= { k::eor };
+	t[op::EOR_ZP_X]		= { k::eor };
+	t[op::EOR_ABS]		= { k::eor };
+	t[op::EOR_ABS_X]	= { k::eor };
+	t[op::EOR_ABS_Y]	= { k::eor };
+	t[op::EOR_IN_X]		= { k::eor };
+	t[op::EOR_IN_Y]		= { k::eor };
+
+	t[op::ORA_IM]		= { k::ora };
+	t[op::ORA_ZP]		= { k::ora };
+	t[op::ORA_ZP_X]		= { k::ora };
+	t[op::ORA_ABS]		= { k::ora };
+	t[op::ORA_ABS_X]	= { k::ora };
+	t[op::ORA_ABS_Y]	= { k::ora };
+	t[op::ORA_IN_X]		= { k::ora };
+	t[op::ORA_IN_Y]		= { k::ora };
+
+	t[op::BIT_ZP]		= { k::bit };
+	t[op::BIT_ABS]		= { k::bit };
+
+	// arithmetic
+	t[op::ADC_IM]		= { k::adc };
+	t[op::ADC_ZP]		= { k::adc };
+	t[op::ADC_ZP_X]		= { k::adc };
+	t[op::ADC_ABS]		= { k::adc };
+	t[op::ADC_ABS_X]	= { k::adc };
+	t[op::ADC_ABS_Y]	= { k::adc };
+	t[op::ADC_IN_X]		= { k::adc };
+	t[op::ADC_IN_Y]		= { k::adc };
+
+	t[op::SBC_IM]		= { k::sbc };
+	t[op::SBC_ZP]		= { k::sbc };
+	t[op::SBC_ZP_X]		= { k::sbc };
+	t[op::SBC_ABS]		= { k::sbc };
+	t[op::SBC_ABS_X]	= { k::sbc };
+	t[op::SBC_ABS_Y]	= { k::sbc };
+	t[op::SBC_IN_X]		= { k::sbc };
+	t[op::SBC_IN_Y]		= { k::sbc };
+
+	t[op::CMP_IM]		= { k::cmp };
+	t[op::CMP_ZP]		= { k::cmp };
+	t[op::CMP_ZP_X]		= { k::cmp };
+	t[op::CMP_ABS]		= { k::cmp };
+	t[op::CMP_ABS_X]	= { k::cmp };
+	t[op::CMP_ABS_Y]	= { k::cmp };
+	t[op::CMP_IN_X]		= { k::cmp };
+	t[op::CMP_IN_Y]		= { k::cmp };
+
+	t[op::CPX_IM]		= { k::cpx };
+	t[op::CPX_ZP]		= { k::cpx };
+	t[op::CPX_ABS]		= { k::cpx };
+
+	t[op::CPY_IM]		= { k::cpy };
+	t[op::CPY_ZP]		= { k::cpy };
+	t[op::CPY_ABS]		= { k::cpy };
+
+	// increments & decrements
+	t[op::INC_ZP]		= { k::inc };
+	t[op::INC_ZP_X]		= { k::inc };
+	t[op::INC_ABS]		= { k::inc };
+	t[op::INC_ABS_X]	= { k::inc };
+
+	t[op::INX]			= { k::inx };
+	t[op::INY]			= { k::iny };
+
+	t[op::DEC_ZP]		= { k::dec };
+	t[op::DEC_ZP_X]		= { k::dec };
+	t[op::DEC_ABS]		= { k::dec };
+	t[op::DEC_ABS_X]	= { k::dec };
+
+	t[op::DEX]			= { k::dex };
+	t[op::DEY]			= { k::dey };
+
+	// shifts
+	t[op::ASL_A]		= { k::asl };
+	t[op::ASL_ZP]		= { k::asl };
+	t[op::ASL_ZP_X]		= { k::asl };
+	t[op::ASL_ABS]		= { k::asl };
+	t[op::ASL_ABS_X]	= { k::asl };
+
+	t[op::LSR_A]		= { k::lsr };
+	t[op::LSR_ZP]		= { k::lsr };
+	t[op::LSR_ZP_X]		= { k::lsr };
+	t[op::LSR_ABS]		= { k::lsr };
+	t[op::LSR_ABS_X]	= { k::lsr };
+
+	t[op::ROL_A]		= { k::rol };
+	t[op::ROL_ZP]		= { k::rol };
+	t[op::ROL_ZP_X]		= { k::rol };
+	t[op::ROL_ABS]		= { k::rol };
+	t[op::ROL_ABS_X]	= { k::rol };
+
+	t[op::ROR_A]		= { k::ror };
+	t[op::ROR_ZP]		= { k::ror };
+	t[op::ROR_ZP_X]		= { k::ror };
+	t[op::ROR_ABS]		= { k::ror };
+	t[op::ROR_ABS_X]	= { k::ror };
+
+	// jumps & calls
+	t[op::JMP_ABS]		= { k::jmp };
+	t[op::JMP_IN]		= { k::jmp };
+	t[op::JSR_ABS]		= { k::jsr };
+	t[op::RTS]			= { k::rts };
+
+	// branches
+	t[op::BCC]			= { k::bcc };
+	t[op::BCS]			= { k::bcs };
+	t[op::BEQ]			= { k::beq };
+	t[op::BMI]			= { k::bmi };
+	t[op::BNE]			= { k::bne };
+	t[op::BPL]			= { k::bpl };
+	t[op::BVC]			= { k::bvc };
+	t[op::BVS]			= { k::bvs };
+
+	// status flag changes
+	t[op::CLC]			= { k::clc };
+	t[op::CLI]			= { k::cli };
+	t[op::CLV]			= { k::clv };
+	t[op::SEC]			= { k::sec };
+	t[op::SEI]			= { k::sei };
+
+	// system functions, BRK, RTI, KIL and HYP are left to the interpreter
+	t[op::NOP]			= { k::nop };
+
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		t[code].mode = op_entries[code].mode;
+	}
+	return t;
+}
+
+constexpr std::array<jit_op, OP_TABLE_SIZE> jit_ops = make_jit_ops();
+
+// every compiled opcode is the instruction op_entries describes under its code
+constexpr bool jit_ops_match_entries()
+{
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		const char* mnemonic = JIT_KIND_MNEMONICS[u8(jit_ops[code].kind)];
+		if (mnemonic != nullptr && (op_entries[code].mnemonic == nullptr || std::string_view(mnemonic) != op_entries[code].mnemonic))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(std::size(JIT_KIND_MNEMONICS) == u8(jit_kind::nop) + 1);
+static_assert(jit_ops_match_entries());
+
+namespace x64
+{
+	enum host_reg : u8
+	{
+		RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15,
+		NO_REG = 0xFF
+	};
+
+	// condition codes for jcc/setcc
+	enum cond : u8
+	{
+		AE	= 0x3,
+		E	= 0x4,
+		NE	= 0x5,
+		L	= 0xC
+	};
+
+	// /digit of 0x81 and 0xC1 groups
+	enum group : u8
+	{
+		ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7,
+		SHL = 4, SHR = 5
+	};
+
+	// opcodes of "op r/m32, r32" form
+	constexpr u8 ADD_RR = 0x01;
+	constexpr u8 OR_RR = 0x09;
+	constexpr u8 AND_RR = 0x21;
+	constexpr u8 SUB_RR = 0x29;
+	constexpr u8 XOR_RR = 0x31;
+	constexpr u8 CMP_RR = 0x39;
+
+	// [base + index * (1 << scale) + disp]
+	struct mem
+	{
+		host_reg base;
+		host_reg index = NO_REG;
+		u8 scale = 0;
+		i32 disp = 0;
+	};
+
+	// writes host code into arena, only forms used by the block compiler
+	struct emitter
+	{
+		u8* code;
+		u32 at;
+
+		void byte(u8 value) { code[at++] = value; }
+		void word(u16 value) { memcpy(code + at, &value, sizeof(value)); at += sizeof(value); }
+		void dword(u32 value) { memcpy(code + at, &value, sizeof(value)); at += sizeof(value); }
+
+		const u8* here() const { return code + at; }
+
+		// byte registers always get REX, so r8b..r15b and al..dl are encoded the same way
+		void rex(bool w, u8 r, u8 x, u8 b, bool force)
+		{
+			u8 value = 0x40 | (w << 3) | (((r >> 3) & 1) << 2) | (((x >> 3) & 1) << 1) | ((b >> 3) & 1);
+			if (value != 0x40 || force)
+			{
+				byte(value);
+			}
+		}
+
+		void opcode(std::initializer_list<u8> bytes)
+		{
+			for (u8 value : bytes)
+			{
+				byte(value);
+			}
+		}
+
+		// register to register, 'r' goes to modrm.reg
+		void rr(std::initializer_list<u8> bytes, u8 r, u8 rm, bool w = false, bool force_rex = false)
+		{
+			rex(w, r, 0, rm, force_rex);
+			opcode(bytes);
+			byte(0xC0 | ((r & 7) << 3) | (rm & 7));
+		}
+
+		// register and memory, 'r' goes to modrm.reg
+		void rm(std::initializer_list<u8> bytes, u8 r, const mem& m, bool w = false, bool force_rex = false)
+		{
+			rex(w, r, m.index == NO_REG ? 0 : m.index, m.base, force_rex);
+			opcode(bytes);
+
+			u8 mod = 2;
+			if (m.disp == 0 && (m.base & 7) != RBP)
+			{
+				mod = 0;
+			}
+			else if (m.disp >= -128 && m.disp <= 127)
+			{
+				mod = 1;
+			}
+
+			if (m.index == NO_REG && (m.base & 7) != RSP)
+			{
+				byte((mod << 6) | ((r & 7) << 3) | (m.base & 7));
+			}
+			else
+			{
+				u8 index = (m.index == NO_REG) ? RSP : (m.index & 7);
+				byte((mod << 6) | ((r & 7) << 3) | RSP);
+				byte((m.scale << 6) | (index << 3) | (m.base & 7));
+			}
+
+			if (mod == 1)
+			{
+				byte(u8(m.disp));
+			}
+			else if (mod == 2)
+			{
+				dword(u32(m.disp));
+			}
+		}
+
+		void mov(host_reg dst, host_reg src)			{ rr({ 0x89 }, src, dst); }
+		void mov64(host_reg dst, host_reg src)			{ rr({ 0x89 }, src, dst, true); }
+		void mov(host_reg dst, u32 imm)					{ rex(false, 0, 0, dst, false); byte(0xB8 + (dst & 7)); dword(imm); }
+		void alu(u8 op, host_reg dst, host_reg src)		{ rr({ op }, src, dst); }
+		void alu(group g, host_reg dst, u32 imm)		{ rr({ 0x81 }, g, dst); dword(imm); }
+		void shift(group g, host_reg dst, u8 imm)		{ rr({ 0xC1 }, g, dst); byte(imm); }
+		void movzx8(host_reg dst, host_reg src)			{ rr({ 0x0F, 0xB6 }, dst, src, false, true); }
+		void movzx16(host_reg dst, host_reg src)		{ rr({ 0x0F, 0xB7 }, dst, src); }
+		void load8(host_reg dst, const mem& m)			{ rm({ 0x0F, 0xB6 }, dst, m); }
+		void load32(host_reg dst, const mem& m)			{ rm({ 0x8B }, dst, m); }
+		void load64(host_reg dst, const mem& m)			{ rm({ 0x8B }, dst, m, true); }
+		void store8(const mem& m, host_reg src)			{ rm({ 0x88 }, src, m, false, true); }
+		void store8(const mem& m, u8 imm)				{ rm({ 0xC6 }, 0, m); byte(imm); }
+		void store16(const mem& m, host_reg src)		{ byte(0x66); rm({ 0x89 }, src, m); }
+		void store16(const mem& m, u16 imm)				{ byte(0x66); rm({ 0xC7 }, 0, m); word(imm); }
+		void store32(const mem& m, host_reg src)		{ rm({ 0x89 }, src, m); }
+		void lea(host_reg dst, const mem& m)			{ rm({ 0x8D }, dst, m); }
+		void test(host_reg a, host_reg b)				{ rr({ 0x85 }, b, a); }
+		void test64(host_reg a, host_reg b)				{ rr({ 0x85 }, b, a, true); }
+		void test(host_reg a, u32 imm)					{ rr({ 0xF7 }, 0, a); dword(imm); }
+		void setcc(cond cc, host_reg dst)				{ rr({ 0x0F, u8(0x90 + cc) }, 0, dst, false, true); }
+		void cmp8(const mem& m, u8 imm)					{ rm({ 0x80 }, 7, m); byte(imm); }
+		void alu64(group g, const mem& m, u32 imm)		{ rm({ 0x81 }, g, m, true); dword(imm); }
+		void add64(const mem& m, host_reg src)			{ rm({ ADD_RR }, src, m, true); }
+		void push(host_reg r)							{ rex(false, 0, 0, r, false); byte(0x50 + (r & 7)); }
+		void pop(host_reg r)							{ rex(false, 0, 0, r, false); byte(0x58 + (r & 7)); }
+		void ret()										{ byte(0xC3); }
+		void jmp(host_reg r)							{ rr({ 0xFF }, 4, r); }
+		void jmp(const mem& m)							{ rm({ 0xFF }, 4, m); }
+
+		void jmp(const u8* target)
+		{
+			byte(0xE9);
+			dword(u32(target - (here() + sizeof(u32))));
+		}
+
+		// returns position of rel32 to patch later
+		u32 jcc(cond cc)
+		{
+			byte(0x0F);
+			byte(0x80 + cc);
+			dword(0);
+			return at - sizeof(u32);
+		}
+
+		// points rel32 at 'patch' to current position
+		void bind(u32 patch)
+		{
+			u32 rel = at - (patch + sizeof(u32));
+			memcpy(code + patch, &rel, sizeof(rel));
+		}
+	};
+}
+
+using namespace x64;
+
+// 6502 state in host registers, every one holds a zero-extended byte
+constexpr host_reg REG_A = R8;
+constexpr host_reg REG_X = R9;
+constexpr host_reg REG_Y = R10;
+constexpr host_reg REG_C = R11;		// 0 or 1
+constexpr host_reg REG_V = R12;		// 0 or 1
+constexpr host_reg REG_Z = R13;		// z_value
+constexpr host_reg REG_N = R14;		// n_value
+
+constexpr host_reg REG_STATE = RBX;	// jit_state*
+constexpr host_reg REG_MEM = RSI;	// jit_state::mem
+constexpr host_reg REG_PAGES = RBP;	// jit_state::code_pages
+constexpr host_reg REG_BUDGET = RDI;	// operators left
+constexpr host_reg REG_BLOCKS = R15;	// jit_state::blocks
+
+// saved by trampoline, superset of callee-saved registers of both Windows and System V ABI
+constexpr host_reg SAVED_REGS[] = { RBX, RBP, RSI, RDI, R12, R13, R14, R15 };
+
+constexpr mem field(size_t offset)
+{
+	return { REG_STATE, NO_REG, 0, i32(offset) };
+}
+
+constexpr u16 STACK_BASE = 0x0100;
+constexpr u8 STACK_PAGE = 0x01;
+
+static void load_state(const cpu& c, jit_state& state)
+{
+	state.mem = c.mem.data;
+	state.code_pages = c.code_pages.data();
+	state.dirty_pages = c.mem.dirty_pages.data();
+	state.blocks = c.jit->blocks.data();
+	state.pc = c.pc;
+	state.sp = c.sp;
+	state.a = c.a;
+	state.x = c.x;
+	state.y = c.y;
+	state.c = c.c;
+	state.v = c.get_v();
+	state.z_value = c.z_value;
+	state.n_value = c.n_value;
+	state.i = c.i;
+	state.d = c.d;
+	state.cycles = c.cycles;
+}
+
+static void store_state(const jit_state& state, cpu& c)
+{
+	c.pc = state.pc;
+	c.sp = state.sp;
+	c.a = state.a;
+	c.x = state.x;
+	c.y = state.y;
+	c.c = state.c;
+	c.set_v(state.v);
+	c.z_value = state.z_value;
+	c.n_value = state.n_value;
+	c.i = state.i;
+	c.cycles = state.cycles;
+}
+
+// compiles one basic block, see jit_cache::compile
+struct block_compiler
+{
+	// instruction of the block
+	struct instruction
+	{
+		u16 pc;
+		jit_op op;
+		u16 raw;	// operand bytes
+		u8 length;
+		u8 cycles;	// base cycles
+	};
+
+	// leaves compiled code, emitted after block body
+	struct pending_exit
+	{
+		u32 patch;
+		u16 pc;
+		u32 refund;		// operators not run, given back to budget
+		u32 refund_cycles;	// their base cycles, taken back from jit_state::cycles
+		jit_exit reason;
+	};
+
+	// effective address, either known while compiling or in eax
+	struct address
+	{
+		bool fixed;
+		u16 value;
+	};
+
+	emitter& e;
+	const u8* exit_stub;
+	std::vector<instruction> block = {};
+	std::vector<pending_exit> exits = {};
+	u32 current = 0;	// index of instruction being compiled
+
+	// leaves block before instruction being compiled, it will run in the interpreter
+	void exit_to_interpreter(u32 patch)
+	{
+		u32 cycles = 0;
+		for (u32 i = current; i < block.size(); i++)
+		{
+			cycles += block[i].cycles;
+		}
+		exits.push_back({ patch, block[current].pc, u32(block.size() - current), cycles, jit_exit::interpret });
+	}
+
+	void set_nz(host_reg value)
+	{
+		e.mov(REG_Z, value);
+		e.mov(REG_N, value);
+	}
+
+	address resolve(op_mode mode, u16 raw)
+	{
+		switch (mode)
+		{
+		case op_mode::zp:
+		case op_mode::abs:
+			return { true, raw };
+		case op_mode::zp_x:
+		case op_mode::zp_y:
+			e.lea(RAX, { mode == op_mode::zp_x ? REG_X : REG_Y, NO_REG, 0, raw });
+			e.movzx8(RAX, RAX);
+			return { false, 0 };
+		case op_mode::abs_x:
+		case op_mode::abs_y:
+			e.lea(RAX, { mode == op_mode::abs_x ? REG_X : REG_Y, NO_REG, 0, raw });
+			e.movzx16(RAX, RAX);
+			return { false, 0 };
+		case op_mode::in_x:
+			e.lea(RCX, { REG_X, NO_REG, 0, raw });
+			e.movzx8(RCX, RCX);
+			e.load8(RAX, { REG_MEM, RCX });
+			e.alu(ADD, RCX, 1);
+			e.movzx8(RCX, RCX);
+			e.load8(RDX, { REG_MEM, RCX });
+			e.shift(SHL, RDX, BIT_SIZE);
+			e.alu(OR_RR, RAX, RDX);
+			return { false, 0 };
+		case op_mode::in_y:
+			e.load8(RAX, { REG_MEM, NO_REG, 0, u8(raw) });
+			e.load8(RDX, { REG_MEM, NO_REG, 0, u8(raw + 1) });
+			e.shift(SHL, RDX, BIT_SIZE);
+			e.alu(OR_RR, RAX, RDX);
+			e.alu(ADD_RR, RAX, REG_Y);
+			e.movzx16(RAX, RAX);
+			return { false, 0 };
+		default:
+			return { true, 0 };
+		}
+	}
+
+	mem at(address addr)
+	{
+		return addr.fixed ? mem{ REG_MEM, NO_REG, 0, addr.value } : mem{ REG_MEM, RAX };
+	}
+
+	// leaves block if address is in a page holding decoded or compiled code, otherwise marks the page dirty, clobbers rcx and rdx
+	void guard_write(address addr)
+	{
+		if (addr.fixed)
+		{
+			e.cmp8({ REG_PAGES, NO_REG, 0, addr.value >> BIT_SIZE }, 0);
+		}
+		else
+		{
+			e.mov(RDX, RAX);
+			e.shift(SHR, RDX, BIT_SIZE);
+			e.cmp8({ REG_PAGES, RDX }, 0);
+		}
+		exit_to_interpreter(e.jcc(NE));
+
+		e.load64(RCX, field(offsetof(jit_state, dirty_pages)));
+		e.store8(addr.fixed ? mem{ RCX, NO_REG, 0, addr.value >> BIT_SIZE } : mem{ RCX, RDX }, u8(1));
+	}
+
+	// leaves block in decimal mode, decimal ADC and SBC run in the interpreter
+	void guard_decimal()
+	{
+		e.cmp8(field(offsetof(jit_state, d)), 0);
+		exit_to_interpreter(e.jcc(NE));
+	}
+
+	// adds the cycle of an indexed read crossing a page: low byte of base + index carries, clobbers rdx
+	void page_penalty(op_mode mode, u16 raw)
+	{
+		if (mode == op_mode::abs_x || mode == op_mode::abs_y)
+		{
+			e.lea(RDX, { mode == op_mode::abs_x ? REG_X : REG_Y, NO_REG, 0, u8(raw) });
+		}
+		else if (mode == op_mode::in_y)
+		{
+			e.load8(RDX, { REG_MEM, NO_REG, 0, u8(raw) });
+			e.alu(ADD_RR, RDX, REG_Y);
+		}
+		else
+		{
+			return;
+		}
+		e.shift(SHR, RDX, BIT_SIZE);
+		e.add64(field(offsetof(jit_state, cycles)), RDX);
+	}
+
+	void read_operand(op_mode mode, u16 raw, host_reg dst)
+	{
+		if constexpr (COUNT_CYCLES)
+		{
+			page_penalty(mode, raw);
+		}
+		if (mode == op_mode::im)
+		{
+			e.mov(dst, u32(raw));
+		}
+		else
+		{
+			e.load8(dst, at(resolve(mode, raw)));
+		}
+	}
+
+	// read-modify-write on 'value', clobbers rdx only
+	void modify(jit_kind kind, host_reg value)
+	{
+		switch (kind)
+		{
+		case jit_kind::inc:
+			e.alu(ADD, value, 1);
+			e.alu(AND, value, 0xFF);
+			break;
+		case jit_kind::dec:
+			e.alu(SUB, value, 1);
+			e.alu(AND, value, 0xFF);
+			break;
+		case jit_kind::asl:
+			e.mov(REG_C, value);
+			e.shift(SHR, REG_C, 7);
+			e.shift(SHL, value, 1);
+			e.alu(AND, value, 0xFF);
+			break;
+		case jit_kind::lsr:
+			e.mov(REG_C, value);
+			e.alu(AND, REG_C, 1);
+			e.shift(SHR, value, 1);
+			break;
+		case jit_kind::rol:
+			e.mov(RDX, value);
+			e.shift(SHR, RDX, 7);
+			e.shift(SHL, value, 1);
+			e.alu(OR_RR, value, REG_C);
+			e.alu(AND, value, 0xFF);
+			e.mov(REG_C, RDX);
+			break;
+		case jit_kind::ror:
+			e.mov(RDX, value);
+			e.alu(AND, RDX, 1);
+			e.shift(SHL, REG_C, 7);
+			e.shift(SHR, value, 1);
+			e.alu(OR_RR, value, REG_C);
+			e.mov(REG_C, RDX);
+			break;
+		default:
+			break;
+		}
+		set_nz(value);
+	}
+
+	// v from previous a (edx), operand (ecx) and new a, like operation::adc
+	void overflow()
+	{
+		e.mov(REG_V, RDX);
+		e.alu(XOR_RR, REG_V, REG_A);
+		e.mov(RAX, RCX);
+		e.alu(XOR_RR, RAX, REG_A);
+		e.alu(AND_RR, REG_V, RAX);
+		e.shift(SHR, REG_V, 7);
+		e.alu(AND, REG_V, 1);
+	}
+
+	void compare(host_reg target)
+	{
+		e.alu(CMP_RR, target, RCX);
+		e.setcc(AE, REG_C);
+		e.mov(RAX, target);
+		e.alu(SUB_RR, RAX, RCX);
+		e.alu(AND, RAX, 0xFF);
+		set_nz(RAX);
+	}
+
+	// jumps straight into block at 'target' or leaves to compile it
+	void chain(u16 target)
+	{
+		e.load64(RAX, { REG_BLOCKS, NO_REG, 0, i32(target) * i32(sizeof(void*)) });
+		e.test64(RAX, RAX);
+		exits.push_back({ e.jcc(E), target, 0, 0, jit_exit::lookup });
+		e.jmp(RAX);
+	}
+
+	// same for target computed into eax
+	void chain_dynamic()
+	{
+		e.load64(RDX, { REG_BLOCKS, RAX, 3 });
+		e.test64(RDX, RDX);
+		u32 miss = e.jcc(E);
+		e.jmp(RDX);
+		e.bind(miss);
+		e.store16(field(offsetof(jit_state, pc)), RAX);
+		e.store8(field(offsetof(jit_state, exit)), u8(jit_exit::lookup));
+		e.jmp(exit_stub);
+	}
+
+	void branch(cond taken_if, u16 pc, u16 raw)
+	{
+		u16 target = u16(pc + 1 + i8(raw));	// offset is counted from operand byte, as in operation::branch
+		u32 taken = e.jcc(taken_if);
+		chain(u16(pc + 2));
+		e.bind(taken);
+		if constexpr (COUNT_CYCLES)
+		{
+			e.alu64(ADD, field(offsetof(jit_state, cycles)), 1 + page_crossed(u16(pc + 2), target));
+		}
+		chain(target);
+	}
+
+	void push_byte(u8 value)
+	{
+		e.load8(RAX, field(offsetof(jit_state, sp)));
+		e.store8(mem{ REG_MEM, RAX, 0, STACK_BASE }, value);
+		e.alu(SUB, RAX, 1);
+		e.store8(field(offsetof(jit_state, sp)), RAX);
+	}
+
+	// pulled byte goes to 'dst', clobbers eax
+	void pull_byte(host_reg dst)
+	{
+		e.load8(RAX, field(offsetof(jit_state, sp)));
+		e.alu(ADD, RAX, 1);
+		e.movzx8(RAX, RAX);
+		e.store8(field(offsetof(jit_state, sp)), RAX);
+		e.load8(dst, mem{ REG_MEM, RAX, 0, STACK_BASE });
+	}
+
+	void compile_instruction(const instruction& ins)
+	{
+		op_mode mode = ins.op.mode;
+		u16 raw = ins.raw;
+
+		switch (ins.op.kind)
+		{
+		// load/store
+		case jit_kind::lda: read_operand(mode, raw, REG_A); set_nz(REG_A); break;
+		case jit_kind::ldx: read_operand(mode, raw, REG_X); set_nz(REG_X); break;
+		case jit_kind::ldy: read_operand(mode, raw, REG_Y); set_nz(REG_Y); break;
+
+		case jit_kind::sta:
+		case jit_kind::stx:
+		case jit_kind::sty:
+		{
+			host_reg src = (ins.op.kind == jit_kind::sta) ? REG_A : (ins.op.kind == jit_kind::stx) ? REG_X : REG_Y;
+			address addr = resolve(mode, raw);
+			guard_write(addr);
+			e.store8(at(addr), src);
+			break;
+		}
+
+		// transfers & stack
+		case jit_kind::tax: e.mov(REG_X, REG_A); set_nz(REG_X); break;
+		case jit_kind::tay: e.mov(REG_Y, REG_A); set_nz(REG_Y); break;
+		case jit_kind::txa: e.mov(REG_A, REG_X); set_nz(REG_A); break;
+		case jit_kind::tya: e.mov(REG_A, REG_Y); set_nz(REG_A); break;
+		case jit_kind::tsx: e.load8(REG_X, field(offsetof(jit_state, sp))); set_nz(REG_X); break;
+		case jit_kind::txs: e.store8(field(offsetof(jit_state, sp)), REG_X); break;
+
+		case jit_kind::pha:
+			guard_write({ true, STACK_BASE });
+			e.load8(RAX, field(offsetof(jit_state, sp)));
+			e.store8(mem{ REG_MEM, RAX, 0, STACK_BASE }, REG_A);
+			e.alu(SUB, RAX, 1);
+			e.store8(field(offsetof(jit_state, sp)), RAX);
+			break;
+
+		case jit_kind::pla:
+			pull_byte(REG_A);
+			set_nz(REG_A);
+			break;
+
+		// logical & arithmetic, operand in ecx
+		case jit_kind::and_: read_operand(mode, raw, RCX); e.alu(AND_RR, REG_A, RCX); set_nz(REG_A); break;
+		case jit_kind::eor: read_operand(mode, raw, RCX); e.alu(XOR_RR, REG_A, RCX); set_nz(REG_A); break;
+		case jit_kind::ora: read_operand(mode, raw, RCX); e.alu(OR_RR, REG_A, RCX); set_nz(REG_A); break;
+
+		case jit_kind::bit:
+			read_operand(mode, raw, RCX);
+			e.mov(REG_Z, REG_A);
+			e.alu(AND_RR, REG_Z, RCX);
+			e.mov(REG_N, RCX);
+			e.mov(REG_V, RCX);
+			e.shift(SHR, REG_V, 6);
+			e.alu(AND, REG_V, 1);
+			break;
+
+		case jit_kind::adc:
+			guard_decimal();
+			read_operand(mode, raw, RCX);
+			e.mov(RDX, REG_A);
+			e.alu(ADD_RR, REG_A, RCX);
+			e.alu(ADD_RR, REG_A, REG_C);
+			e.mov(REG_C, REG_A);
+			e.shift(SHR, REG_C, BIT_SIZE);
+			e.alu(AND, REG_A, 0xFF);
+			overflow();
+			set_nz(REG_A);
+			break;
+
+		case jit_kind::sbc:
+			guard_decimal();
+			read_operand(mode, raw, RCX);
+			e.mov(RDX, REG_A);
+			e.alu(SUB_RR, REG_A, RCX);
+			e.alu(ADD_RR, REG_A, REG_C);
+			e.alu(SUB, REG_A, 1);
+			e.alu(AND, REG_A, 0xFF);
+			overflow();
+			e.mov(REG_C, REG_V);
+			e.alu(XOR, REG_C, 1);
+			set_nz(REG_A);
+			break;
+
+		case jit_kind::cmp: read_operand(mode, raw, RCX); compare(REG_A); break;
+		case jit_kind::cpx: read_operand(mode, raw, RCX); compare(REG_X); break;
+		case jit_kind::cpy: read_operand(mode, raw, RCX); compare(REG_Y); break;
+
+		// read-modify-write
+		case jit_kind::inx: modify(jit_kind::inc, REG_X); break;
+		case jit_kind::iny: modify(jit_kind::inc, REG_Y); break;
+		case jit_kind::dex: modify(jit_kind::dec, REG_X); break;
+		case jit_kind::dey: modify(jit_kind::dec, REG_Y); break;
+
+		case jit_kind::inc:
+		case jit_kind::dec:
+		case jit_kind::asl:
+		case jit_kind::lsr:
+		case jit_kind::rol:
+		case jit_kind::ror:
+		{
+			if (mode == op_mode::acc)
+			{
+				modify(ins.op.kind, REG_A);
+				break;
+			}
+			address addr = resolve(mode, raw);
+			guard_write(addr);
+			e.load8(RCX, at(addr));
+			modify(ins.op.kind, RCX);
+			e.store8(at(addr), RCX);
+			break;
+		}
+
+		// jumps & calls end the block
+		case jit_kind::jmp:
+			if (mode == op_mode::abs)
+			{
+				chain(raw);
+				break;
+			}
+			e.load8(RAX, { REG_MEM, NO_REG, 0, raw });
+			e.load8(RDX, { REG_MEM, NO_REG, 0, u16(raw + 1) });
+			e.shift(SHL, RDX, BIT_SIZE);
+			e.alu(OR_RR, RAX, RDX);
+			chain_dynamic();
+			break;
+
+		case jit_kind::jsr:
+		{
+			// pushes address of its last byte, as operation::jsr
+			u16 ret = u16(ins.pc + 2);
+			guard_write({ true, STACK_BASE });
+			push_byte(u8(ret));
+			push_byte(u8(ret >> BIT_SIZE));
+			chain(raw);
+			break;
+		}
+
+		case jit_kind::rts:
+			pull_byte(RCX);
+			e.shift(SHL, RCX, BIT_SIZE);
+			pull_byte(RDX);
+			e.alu(OR_RR, RCX, RDX);
+			e.lea(RAX, { RCX, NO_REG, 0, 1 });
+			e.movzx16(RAX, RAX);
+			chain_dynamic();
+			break;
+
+		// branches end the block
+		case jit_kind::bcc: e.test(REG_C, REG_C); branch(E, ins.pc, raw); break;
+		case jit_kind::bcs: e.test(REG_C, REG_C); branch(NE, ins.pc, raw); break;
+		case jit_kind::beq: e.test(REG_Z, REG_Z); branch(E, ins.pc, raw); break;
+		case jit_kind::bne: e.test(REG_Z, REG_Z); branch(NE, ins.pc, raw); break;
+		case jit_kind::bmi: e.test(REG_N, 0x80); branch(NE, ins.pc, raw); break;
+		case jit_kind::bpl: e.test(REG_N, 0x80); branch(E, ins.pc, raw); break;
+		case jit_kind::bvc: e.test(REG_V, REG_V); branch(E, ins.pc, raw); break;
+		case jit_kind::bvs: e.test(REG_V, REG_V); branch(NE, ins.pc, raw); break;
+
+		// status flag changes
+		case jit_kind::clc: e.mov(REG_C, 0u); break;
+		case jit_kind::sec: e.mov(REG_C, 1u); break;
+		case jit_kind::clv: e.mov(REG_V, 0u); break;
+		case jit_kind::cli: e.store8(field(offsetof(jit_state, i)), u8(0)); break;
+		case jit_kind::sei: e.store8(field(offsetof(jit_state, i)), u8(1)); break;
+
+		default:
+			break;
+		}
+	}
+
+	static bool ends_block(jit_kind kind)
+	{
+		return kind == jit_kind::jmp || kind == jit_kind::jsr || kind == jit_kind::rts || (kind >= jit_kind::bcc && kind <= jit_kind::bvs);
+	}
+
+	// 'next' - address after last instruction, used if block doesn't end with a jump
+	void compile(u16 next, bool next_supported)
+	{
+		u32 operators = u32(block.size());
+
+		// whole block is paid at entry, it never runs partially because of budget
+		e.alu(CMP, REG_BUDGET, operators);
+		exits.push_back({ e.jcc(L), block.front().pc, 0, 0, jit_exit::interpret });
+		e.alu(SUB, REG_BUDGET, operators);
+		if constexpr (COUNT_CYCLES)
+		{
+			u32 cycles = 0;
+			for (const instruction& ins : block)
+			{
+				cycles += ins.cycles;
+			}
+			e.alu64(ADD, field(offsetof(jit_state, cycles)), cycles);
+		}
+
+		for (current = 0; current < block.size(); current++)
+		{
+			compile_instruction(block[current]);
+		}
+
+		if (!ends_block(block.back().op.kind))
+		{
+			if (next_supported)
+			{
+				chain(next);
+			}
+			else
+			{
+				e.store16(field(offsetof(jit_state, pc)), next);
+				e.store8(field(offsetof(jit_state, exit)), u8(jit_exit::interpret));
+				e.jmp(exit_stub);
+			}
+		}
+
+		for (const pending_exit& exit : exits)
+		{
+			e.bind(exit.patch);
+			if (exit.refund > 0)
+			{
+				e.alu(ADD, REG_BUDGET, exit.refund);
+			}
+			if (COUNT_CYCLES && exit.refund_cycles > 0)
+			{
+				e.alu64(SUB, field(offsetof(jit_state, cycles)), exit.refund_cycles);
+			}
+			e.store16(field(offsetof(jit_state, pc)), exit.pc);
+			e.store8(field(offsetof(jit_state, exit)), u8(exit.reason));
+			e.jmp(exit_stub);
+		}
+	}
+};
+
+jit_cache::jit_cache()
+{
+#ifdef _WIN32
+	arena = (u8*)VirtualAlloc(nullptr, JIT_ARENA_BYTES, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* memory = mmap(nullptr, JIT_ARENA_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	arena = (memory == MAP_FAILED) ? nullptr : (u8*)memory;
+#endif
+	if (arena == nullptr)
+	{
+		std::cerr << "JIT arena is not available, running in the interpreter.\n";
+		return;
+	}
+
+	// trampoline: void enter(jit_state*)
+	emitter e{ arena, 0 };
+	for (host_reg r : SAVED_REGS)
+	{
+		e.push(r);
+	}
+#ifdef _WIN32
+	e.mov64(REG_STATE, RCX);
+#else
+	e.mov64(REG_STATE, RDI);
+#endif
+	e.load64(REG_MEM, field(offsetof(jit_state, mem)));
+	e.load64(REG_PAGES, field(offsetof(jit_state, code_pages)));
+	e.load64(REG_BLOCKS, field(offsetof(jit_state, blocks)));
+	e.load32(REG_BUDGET, field(offsetof(jit_state, budget)));
+	e.load8(REG_A, field(offsetof(jit_state, a)));
+	e.load8(REG_X, field(offsetof(jit_state, x)));
+	e.load8(REG_Y, field(offsetof(jit_state, y)));
+	e.load8(REG_C, field(offsetof(jit_state, c)));
+	e.load8(REG_V, field(offsetof(jit_state, v)));
+	e.load8(REG_Z, field(offsetof(jit_state, z_value)));
+	e.load8(REG_N, field(offsetof(jit_state, n_value)));
+	e.jmp(field(offsetof(jit_state, entry)));
+
+	// every block leaves through here, pc and exit are already stored
+	exit_stub = e.here();
+	e.store32(field(offsetof(jit_state, budget)), REG_BUDGET);
+	e.store8(field(offsetof(jit_state, a)), REG_A);
+	e.store8(field(offsetof(jit_state, x)), REG_X);
+	e.store8(field(offsetof(jit_state, y)), REG_Y);
+	e.store8(field(offsetof(jit_state, c)), REG_C);
+	e.store8(field(offsetof(jit_state, v)), REG_V);
+	e.store8(field(offsetof(jit_state, z_value)), REG_Z);
+	e.store8(field(offsetof(jit_state, n_value)), REG_N);
+	for (u32 i = std::size(SAVED_REGS); i > 0; i--)
+	{
+		e.pop(SAVED_REGS[i - 1]);
+	}
+	e.ret();
+
+	enter = (void(*)(jit_state*))arena;
+	trampoline_bytes = e.at;
+	used = e.at;
+	protect(0, JIT_ARENA_BYTES, false);
+}
+
+jit_cache::~jit_cache()
+{
+	if (arena == nullptr)
+	{
+		return;
+	}
+#ifdef _WIN32
+	VirtualFree(arena, 0, MEM_RELEASE);
+#else
+	munmap(arena, JIT_ARENA_BYTES);
+#endif
+}
+
+void* jit_cache::compile(cpu& cpu_ref)
+{
+	if (arena == nullptr || jit_ops[cpu_ref.mem[cpu_ref.pc]].kind == jit_kind::none || cpu_ref.at_breakpoint(cpu_ref.pc))
+	{
+		return nullptr;
+	}
+	if (used + JIT_MAX_BLOCK_BYTES > JIT_ARENA_BYTES)
+	{
+		flush();
+	}
+
+	u32 first = used;
+	protect(first, first + JIT_MAX_BLOCK_BYTES, true);
+	emitter e{ arena, used };
+	block_compiler bc{ e, exit_stub };
+	u16 start = cpu_ref.pc;
+	u16 pc = start;
+
+	while (bc.block.size() < JIT_MAX_BLOCK_OPERATORS)
+	{
+		u8 code = cpu_ref.mem[pc];
+		jit_op op = jit_ops[code];
+		if (op.kind == jit_kind::none || cpu_ref.at_breakpoint(pc))
+		{
+			break;
+		}
+
+		u8 length = op_entries[code].length;
+		u16 raw = 0;
+		if (length == 2)
+		{
+			raw = cpu_ref.mem[u16(pc + 1)];
+		}
+		else if (length == 3)
+		{
+			raw = cpu_ref.mem[u16(pc + 1)] | (cpu_ref.mem[u16(pc + 2)] << BIT_SIZE);
+		}
+		bc.block.push_back({ pc, op, raw, length, op_cycles[code] });
+		pc += length;
+
+		if (block_compiler::ends_block(op.kind))
+		{
+			break;
+		}
+	}
+
+	// block stopped by size limit goes on into the next block, by unknown operator - into the interpreter
+	bc.compile(pc, jit_ops[cpu_ref.mem[pc]].kind != jit_kind::none);
+
+	void* entry = arena + used;
+	used = e.at;
+	protect(first, first + JIT_MAX_BLOCK_BYTES, false);
+
+	// every page holding a byte of the block
+	u16 last = u16(pc - 1);
+	for (u8 page = u8(start >> BIT_SIZE);; page++)
+	{
+		page_blocks[page].push_back(start);
+		cpu_ref.code_pages[page] = true;
+		if (page == u8(last >> BIT_SIZE))
+		{
+			break;
+		}
+	}
+	blocks[start] = entry;
+
+	if (verify)
+	{
+		verify_block(cpu_ref, entry, u32(bc.block.size()));
+	}
+	return entry;
+}
+
+void jit_cache::invalidate_page(u8 page)
+{
+	for (u16 start : page_blocks[page])
+	{
+		blocks[start] = nullptr;
+	}
+	page_blocks[page].clear();
+}
+
+void jit_cache::flush()
+{
+	for (std::vector<u16>& starts : page_blocks)
+	{
+		starts.clear();
+	}
+	std::fill(blocks.begin(), blocks.end(), nullptr);
+	used = trampoline_bytes;
+}
+
+void jit_cache::protect(u32 from, u32 to, bool writable)
+{
+	u32 start = from / JIT_PAGE_BYTES * JIT_PAGE_BYTES;
+	u32 end = std::min(JIT_ARENA_BYTES, (to + JIT_PAGE_BYTES - 1) / JIT_PAGE_BYTES * JIT_PAGE_BYTES);
+#ifdef _WIN32
+	DWORD previous = 0;
+	VirtualProtect(arena + start, end - start, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &previous);
+	if (!writable)
+	{
+		FlushInstructionCache(GetCurrentProcess(), arena + start, end - start);
+	}
+#else
+	mprotect(arena + start, end - start, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
+#endif
+}
+
+bool jit_cache::verify_block(const cpu& cpu_ref, void* entry, u32 operators)
+{
+	ram ram_ref;
+	ram ram_gen;
+	cpu ref(ram_ref);
+	cpu gen(ram_gen);
+
+	for (cpu* c : { &ref, &gen })
+	{
+		memcpy(c->mem.data, cpu_ref.mem.data, MAX_RAM_BYTES);
+		c->cycles = cpu_ref.cycles;
+		c->pc = cpu_ref.pc;
+		c->sp = cpu_ref.sp;
+		c->a = cpu_ref.a;
+		c->x = cpu_ref.x;
+		c->y = cpu_ref.y;
+		restore_status(*c, process_status(cpu_ref));
+	}
+
+	ref.start_loop(i32(operators));
+
+	// block alone, budget stops it at next block, whatever it left is finished by the interpreter
+	jit_state state;
+	load_state(gen, state);
+	state.code_pages = cpu_ref.code_pages.data();
+	state.blocks = blocks.data();
+	state.entry = entry;
+	state.budget = i32(operators);
+	enter(&state);
+	store_state(state, gen);
+	gen.start_loop(state.budget);
+
+	const char* diff = nullptr;
+	if (ref.pc != gen.pc)								diff = "pc";
+	else if (ref.sp != gen.sp)							diff = "sp";
+	else if (ref.a != gen.a)							diff = "a";
+	else if (ref.x != gen.x)							diff = "x";
+	else if (ref.y != gen.y)							diff = "y";
+	else if (process_status(ref) != process_status(gen))	diff = "status";
+	else if (memcmp(ram_ref.data, ram_gen.data, MAX_RAM_BYTES) != 0)	diff = "memory";
+	else if (ref.cycles != gen.cycles)					diff = "cycles";
+
+	verified++;
+	if (diff != nullptr)
+	{
+		std::cerr << std::hex << "JIT block at \'" << cpu_ref.pc << "\' differs from interpreter in " << diff << '\n' << std::dec;
+		mismatches++;
+	}
+	return diff == nullptr;
+}
+
+i32 cpu::start_jit(i32 operators)
+{
+	if (!jit)
+	{
+		jit = std::make_unique<jit_cache>();
+	}
+
+	jit_state state;
+	const i32 budget = operators;
+	while (operators > 0 && !k)
+	{
+		// blocks never start at a breakpoint and end before one, so every breakpoint is reached here
+		if (operators != budget && at_breakpoint(pc))
+		{
+			break;
+		}
+
+		void* entry = jit->blocks[pc];
+		if (entry == nullptr)
+		{
+			entry = jit->compile(*this);
+		}
+
+		if (entry != nullptr)
+		{
+			load_state(*this, state);
+			state.entry = entry;
+			state.budget = operators;
+			jit->enter(&state);
+			store_state(state, *this);
+			operators = state.budget;
+
+			if (state.exit != jit_exit::interpret || operators <= 0 || at_breakpoint(pc))
+			{
+				continue;
+			}
+		}
+
+		// one operator in the interpreter, same as one iteration of cpu::start_loop
+		exe_op(mem[pc]);
+		pc++;
+		operators--;
+	}
+	return operators;
+}
+
+#else
+
+jit_cache::jit_cache() {}
+jit_cache::~jit_cache() {}
+void* jit_cache::compile(cpu&) { return nullptr; }
+void jit_cache::invalidate_page(u8) {}
+void jit_cache::flush() {}
+void jit_cache::protect(u32, u32, bool) {}
+bool jit_cache::verify_block(const cpu&, void*, u32) { return true; }
+
+i32 cpu::start_jit(i32 operators)
+{
+	return start_loop(operators);
+}
+
+#endif // JIT_6502
\ No newline at end of file
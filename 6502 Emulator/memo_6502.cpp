@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <iostream>
+
+#include "memo_6502.h"
+#include "op_policies_6502.h"
+
+// register of call_trace, remembers whether the call read it before writing it
+struct traced_reg
+{
+	u8 value = 0;
+	mutable bool input = false;
+	bool written = false;
+
+	operator u8() const
+	{
+		input = input || !written;
+		return value;
+	}
+
+	traced_reg& operator = (u8 new_value)
+	{
+		value = new_value;
+		written = true;
+		return *this;
+	}
+
+	traced_reg& operator = (const traced_reg& other) { return *this = u8(other); }
+	traced_reg& operator += (u8 operand) { return *this = u8(u8(*this) + operand); }
+	traced_reg& operator -= (u8 operand) { return *this = u8(u8(*this) - operand); }
+	traced_reg& operator &= (u8 operand) { return *this = u8(u8(*this) & operand); }
+	traced_reg& operator |= (u8 operand) { return *this = u8(u8(*this) | operand); }
+	traced_reg& operator ^= (u8 operand) { return *this = u8(u8(*this) ^ operand); }
+};
+
+struct call_trace;
+
+// memory as op_policies read it through c.mem
+struct traced_mem
+{
+	call_trace& trace;
+
+	u8 operator [] (u16 addr) const;
+};
+
+// same members as cpu that op_policies use, runs one call for real and records what it reads and writes
+struct call_trace
+{
+	cpu& owner;
+	traced_mem mem;
+
+	u16 pc;
+	traced_reg sp;
+	traced_reg a;
+	traced_reg x, y;
+	traced_reg c;
+	traced_reg z_value;
+	traced_reg n_value;
+	traced_reg v_value;
+	traced_reg i, d, b, k;
+	u64 cycles;				// not an input, a cached call adds the same cycles on every replay
+
+	std::vector<std::pair<u16, u8>> reads = {};
+	std::vector<std::pair<u16, u8>> writes = {};
+	std::vector<u8> pages = {};		// of code run
+	bool trapped = false;
+
+	explicit call_trace(cpu& owner_ref) : owner(owner_ref), mem{ *this }
+	{
+		load();
+	}
+
+	traced_reg& reg(memo_reg r)
+	{
+		switch (r)
+		{
+		case memo_reg::a: return a;
+		case memo_reg::x: return x;
+		case memo_reg::y: return y;
+		case memo_reg::sp: return sp;
+		case memo_reg::c: return c;
+		case memo_reg::z: return z_value;
+		case memo_reg::n: return n_value;
+		case memo_reg::v: return v_value;
+		case memo_reg::i: return i;
+		case memo_reg::d: return d;
+		case memo_reg::b: return b;
+		default: return k;
+		}
+	}
+
+	void load();
+	void store();
+
+	bool get_z() const { return u8(z_value) == 0; }
+	bool get_n() const { return (u8(n_value) & 0x80) != 0; }
+	bool get_v() const { return (u8(v_value) & 0x80) != 0; }
+
+	void set_z(bool value) { z_value = !value; }
+	void set_n(bool value) { n_value = value ? 0x80 : 0; }
+	void set_v(bool value) { v_value = value ? 0x80 : 0; }
+
+	void set_nz(u8 result) { z_value = result; n_value = result; }
+
+	void run_code(u16 addr)
+	{
+		u8 page = u8(addr >> BIT_SIZE);
+		if (std::find(pages.begin(), pages.end(), page) == pages.end())
+		{
+			pages.push_back(page);
+		}
+	}
+
+	u8 next_byte()
+	{
+		run_code(++pc);
+		return owner.mem[pc];
+	}
+
+	u8 read(u16 addr)
+	{
+		u8 value = owner.read(addr);
+		auto same = [addr](const std::pair<u16, u8>& access) { return access.first == addr; };
+		if (std::none_of(writes.begin(), writes.end(), same) && std::none_of(reads.begin(), reads.end(), same))
+		{
+			reads.emplace_back(addr, value);
+		}
+		return value;
+	}
+
+	void write(u16 addr, u8 value)
+	{
+		owner.write(addr, value);
+		auto same = std::find_if(writes.begin(), writes.end(), [addr](const std::pair<u16, u8>& access) { return access.first == addr; });
+		if (same != writes.end())
+		{
+			same->second = value;
+		}
+		else
+		{
+			writes.emplace_back(addr, value);
+		}
+	}
+
+	void push(u8 bt)
+	{
+		write(u16(0x0100 + sp), bt);
+		sp = u8(sp - 1);
+	}
+
+	u8 pull()
+	{
+		sp = u8(sp + 1);
+		return read(u16(0x0100 + sp));
+	}
+
+	// registers go through cpu, the call isn't cached
+	static void trap_unknown_op(call_trace& trace)
+	{
+		trace.store();
+		cpu::trap_unknown_op(trace.owner);
+		trace.load();
+		trace.trapped = true;
+	}
+
+	// host service has effects the trace can't see, the call isn't cached
+	void hypercall(u8 service)
+	{
+		store();
+		owner.hypercall(service);
+		load();
+		trapped = true;
+	}
+};
+
+u8 traced_mem::operator [] (u16 addr) const
+{
+	return trace.read(addr);
+}
+
+static u8 get_register(const cpu& c, memo_reg r)
+{
+	switch (r)
+	{
+	case memo_reg::a: return c.a;
+	case memo_reg::x: return c.x;
+	case memo_reg::y: return c.y;
+	case memo_reg::sp: return c.sp;
+	case memo_reg::c: return c.c;
+	case memo_reg::z: return c.z_value;
+	case memo_reg::n: return c.n_value;
+	case memo_reg::v: return c.v_value;
+	case memo_reg::i: return c.i;
+	case memo_reg::d: return c.d;
+	case memo_reg::b: return c.b;
+	default: return c.k;
+	}
+}
+
+static void set_register(cpu& c, memo_reg r, u8 value)
+{
+	switch (r)
+	{
+	case memo_reg::a: c.a = value; break;
+	case memo_reg::x: c.x = value; break;
+	case memo_reg::y: c.y = value; break;
+	case memo_reg::sp: c.sp = value; break;
+	case memo_reg::c: c.c = value; break;
+	case memo_reg::z: c.z_value = value; break;
+	case memo_reg::n: c.n_value = value; break;
+	case memo_reg::v: c.v_value = value; break;
+	case memo_reg::i: c.i = value; break;
+	case memo_reg::d: c.d = value; break;
+	case memo_reg::b: c.b = value; break;
+	default: c.k = value; break;
+	}
+}
+
+// call_state bits an input register covers, flags are status bits as process_status packs them
+static u64 state_bits(memo_reg r)
+{
+	switch (r)
+	{
+	case memo_reg::a: return u64(0xFF) << 16;
+	case memo_reg::x: return u64(0xFF) << 24;
+	case memo_reg::y: return u64(0xFF) << 32;
+	case memo_reg::sp: return u64(0xFF) << 40;
+	case memo_reg::c: return u64(1) << 48;
+	case memo_reg::z: return u64(1) << 49;
+	case memo_reg::i: return u64(1) << 50;
+	case memo_reg::d: return u64(1) << 51;
+	case memo_reg::b: return u64(1) << 52;
+	case memo_reg::k: return u64(1) << 53;
+	case memo_reg::v: return u64(1) << 54;
+	default: return u64(1) << 55;
+	}
+}
+
+void call_trace::load()
+{
+	pc = owner.pc;
+	cycles = owner.cycles;
+	for (u32 r = 0; r < MEMO_REG_COUNT; r++)
+	{
+		reg(memo_reg(r)).value = get_register(owner, memo_reg(r));
+	}
+}
+
+void call_trace::store()
+{
+	owner.pc = pc;
+	owner.cycles = cycles;
+	for (u32 r = 0; r < MEMO_REG_COUNT; r++)
+	{
+		set_register(owner, memo_reg(r), reg(memo_reg(r)).value);
+	}
+}
+
+static constexpr std::array<basic_op_entry<call_trace>, OP_TABLE_SIZE> traced_ops[CPU_VARIANT_COUNT] =
+{
+	make_op_entries<call_trace, cpu_variant::nmos>(),
+	make_op_entries<call_trace, cpu_variant::cmos>()
+};
+
+u64 call_state(const cpu& cpu_ref)
+{
+	return u64(cpu_ref.pc) | (u64(cpu_ref.a) << 16) | (u64(cpu_ref.x) << 24) | (u64(cpu_ref.y) << 32)
+		| (u64(cpu_ref.sp) << 40) | (u64(process_status(cpu_ref)) << 48);
+}
+
+static bool writes_into(const std::vector<std::pair<u16, u8>>& writes, const std::vector<u8>& pages)
+{
+	return std::any_of(writes.begin(), writes.end(), [&pages](const std::pair<u16, u8>& access)
+		{
+			return std::find(pages.begin(), pages.end(), u8(access.first >> BIT_SIZE)) != pages.end();
+		});
+}
+
+static void make_impure(memo_subroutine& sub)
+{
+	sub.impure = true;
+	sub.entries.clear();
+}
+
+// adds a finished call to its subroutine
+static void record_call(cpu& c, memo_subroutine& sub, memo_entry&& entry, u64 inputs, const std::vector<u8>& pages)
+{
+	if (writes_into(entry.writes, pages) || writes_into(entry.writes, sub.pages))
+	{
+		make_impure(sub);
+		return;
+	}
+	for (u8 page : pages)
+	{
+		if (std::find(sub.pages.begin(), sub.pages.end(), page) == sub.pages.end())
+		{
+			for (const auto& [state, cached] : sub.entries)
+			{
+				if (writes_into(cached.writes, { page }))
+				{
+					make_impure(sub);
+					return;
+				}
+			}
+			sub.pages.push_back(page);
+		}
+		// cpu::write reports writes into the page from now on
+		c.code_pages[page] = true;
+	}
+
+	// a call reading more registers than cached ones did narrows every key
+	if ((sub.mask | inputs) != sub.mask)
+	{
+		sub.mask |= inputs;
+		std::unordered_multimap<u64, memo_entry> rekeyed;
+		for (auto& [state, cached] : sub.entries)
+		{
+			rekeyed.emplace(cached.state & sub.mask, std::move(cached));
+		}
+		sub.entries = std::move(rekeyed);
+	}
+	sub.entries.emplace(entry.state & sub.mask, std::move(entry));
+}
+
+static i32 replay(cpu& c, const memo_entry& entry)
+{
+	for (u32 r = 0; r < MEMO_REG_COUNT; r++)
+	{
+		if (entry.written & (1 << r))
+		{
+			set_register(c, memo_reg(r), entry.registers[r]);
+		}
+	}
+	for (const auto& [addr, value] : entry.writes)
+	{
+		c.write(addr, value);
+	}
+	c.pc = entry.pc;
+	c.cycles += entry.cycles;
+	return entry.operators;
+}
+
+i32 run_memoized(cpu& cpu_ref, i32 operators)
+{
+	// a device read isn't an input a replay can check
+	if (!cpu_ref.mem.plain())
+	{
+		return 0;
+	}
+	if (!cpu_ref.memo)
+	{
+		cpu_ref.memo = std::make_unique<memo_cache>();
+	}
+	memo_cache& cache = *cpu_ref.memo;
+
+	u16 site = cpu_ref.pc;
+	u16 target = cpu_ref.mem[u16(site + 1)] | (cpu_ref.mem[u16(site + 2)] << BIT_SIZE);
+	u64 state = call_state(cpu_ref);
+	{
+		memo_subroutine& sub = cache.subroutines[target];
+		if (sub.impure)
+		{
+			return 0;
+		}
+
+		auto [first, last] = sub.entries.equal_range(state & sub.mask);
+		for (auto it = first; it != last; ++it)
+		{
+			const memo_entry& entry = it->second;
+			bool same_inputs = std::all_of(entry.reads.begin(), entry.reads.end(), [&cpu_ref](const std::pair<u16, u8>& access)
+				{
+					return cpu_ref.mem[access.first] == access.second;
+				});
+			if (same_inputs)
+			{
+				if (entry.operators > operators)
+				{
+					return 0;
+				}
+				cache.replayed++;
+				return replay(cpu_ref, entry);
+			}
+		}
+		if (sub.entries.size() >= MEMO_MAX_ENTRIES)
+		{
+			return 0;
+		}
+	}
+
+	// profiles the call, stop conditions and pc stepping mirror cpu::start_loop
+	cache.traced++;
+	call_trace trace(cpu_ref);
+	const std::array<basic_op_entry<call_trace>, OP_TABLE_SIZE>& ops = traced_ops[u8(cpu_ref.variant)];
+	u8 sp = trace.sp.value;
+	u64 cycles = trace.cycles;
+	i32 done = 0;
+	bool returned = false;
+	bool too_big = false;
+	while (done < operators && !trace.k.value && !trace.trapped && !returned && !too_big)
+	{
+		u8 code = cpu_ref.mem[trace.pc];
+		trace.run_code(trace.pc);
+		ops[code].exec(trace);
+		trace.pc++;
+		done++;
+		if (done == 1)
+		{
+			// JSR itself is the call site, its bytes are read anew by every call
+			trace.pages.clear();
+		}
+
+		returned = code == op::RTS && trace.pc == u16(site + 3) && trace.sp.value == sp;
+		too_big = trace.reads.size() > MEMO_MAX_READS || trace.writes.size() > MEMO_MAX_WRITES || done >= MEMO_MAX_OPERATORS;
+	}
+	trace.store();
+
+	// writes during the call may have dropped the subroutine
+	memo_subroutine& sub = cache.subroutines[target];
+	if (sub.impure)
+	{
+		return done;
+	}
+	if (too_big || trace.k.value || trace.trapped)
+	{
+		make_impure(sub);
+		return done;
+	}
+	if (!returned)
+	{
+		// budget ran out inside the call, profile it next time
+		return done;
+	}
+
+	memo_entry entry;
+	u64 inputs = 0xFFFF;
+	entry.state = state;
+	entry.reads = std::move(trace.reads);
+	entry.writes = std::move(trace.writes);
+	for (u32 r = 0; r < MEMO_REG_COUNT; r++)
+	{
+		const traced_reg& value = trace.reg(memo_reg(r));
+		if (value.input)
+		{
+			inputs |= state_bits(memo_reg(r));
+		}
+		if (value.written)
+		{
+			entry.written |= 1 << r;
+			entry.registers[r] = value.value;
+		}
+	}
+	entry.pc = trace.pc;
+	entry.operators = done;
+	entry.cycles = trace.cycles - cycles;
+	record_call(cpu_ref, sub, std::move(entry), inputs, trace.pages);
+	return done;
+}
+
+void memo_cache::invalidate_page(u8 page)
+{
+	std::erase_if(subroutines, [page](const auto& item)
+		{
+			const std::vector<u8>& pages = item.second.pages;
+			return std::find(pages.begin(), pages.end(), page) != pages.end();
+		});
+}
+
+void report_memo(const cpu& cpu_ref)
+{
+	std::cout << "\nMemoized calls:\n";
+	if (!cpu_ref.memo)
+	{
+		std::cout << "  none\n";
+		return;
+	}
+
+	u64 impure = 0;
+	u64 entries = 0;
+	for (const auto& [target, sub] : cpu_ref.memo->subroutines)
+	{
+		impure += sub.impure;
+		entries += sub.entries.size();
+	}
+	std::cout << "  subroutines: " << cpu_ref.memo->subroutines.size() << ", impure: " << impure << ", cached calls: " << entries << '\n';
+	std::cout << "  traced: " << cpu_ref.memo->traced << ", replayed: " << cpu_ref.memo->replayed << '\n';
+}
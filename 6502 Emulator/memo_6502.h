@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vm_6502.h"
+
+// Subroutine memoization (cpu::memoize), predecoded and fused engines run JSR records through run_memoized.
+// A call is profiled by running it on call_trace (memo_6502.cpp): same op_policies, but every register and memory byte
+// remembers whether the call read it before writing it (its inputs) and what it wrote (its outputs).
+// A call that returns to its site within MEMO_MAX_OPERATORS, reads and writes few bytes of memory,
+// doesn't trap, call the host (HYP), stop or write into pages of its own code is cached as inputs -> outputs under the subroutine.
+// A later call with the same inputs replays the outputs instead of running: registers it wrote,
+// memory bytes it wrote (with their final values, return address on stack too), pc after the return, operator and cycle count.
+// Inputs are checked on every replay, so a write into the read set makes the entry stale by itself,
+// a write into a page of subroutine code (cpu::write -> invalidate_page) drops every entry of the subroutine.
+// Subroutines whose calls can't be cached are marked impure once and run normally from then on.
+
+constexpr u32 MEMO_MAX_READS = 16;			// memory bytes a cached call may read before writing them
+constexpr u32 MEMO_MAX_WRITES = 16;			// memory bytes a cached call may write, return address on stack included
+constexpr i32 MEMO_MAX_OPERATORS = 4096;	// longer calls aren't cached
+constexpr u32 MEMO_MAX_ENTRIES = 1024;		// cached calls per subroutine, further inputs just run
+
+// registers a call may read or write, bit per register in memo_entry::written
+enum struct memo_reg : u8
+{
+	a,
+	x,
+	y,
+	sp,
+	c,
+	z,
+	n,
+	v,
+	i,
+	d,
+	b,
+	k
+};
+constexpr u32 MEMO_REG_COUNT = 12;
+
+// one cached call
+struct memo_entry
+{
+	u64 state = 0;										// call_state at the call, before masking
+	std::vector<std::pair<u16, u8>> reads = {};			// memory inputs: address, value
+	std::vector<std::pair<u16, u8>> writes = {};		// memory outputs: address, final value
+	u16 written = 0;									// registers written, bit per memo_reg
+	std::array<u8, MEMO_REG_COUNT> registers = {};		// their final values
+	u16 pc = 0;											// next opcode after the return
+	i32 operators = 0;
+	u64 cycles = 0;										// the call with its JSR, 0 without CYCLES_6502
+};
+
+struct memo_subroutine
+{
+	bool impure = false;
+	u64 mask = 0;										// call_state bits any cached call depends on
+	std::unordered_multimap<u64, memo_entry> entries = {};	// by call_state & mask
+	std::vector<u8> pages = {};							// pages of code run by cached calls
+};
+
+struct memo_cache
+{
+	std::unordered_map<u16, memo_subroutine> subroutines = {};	// by entry address
+	u64 traced = 0;		// calls run on call_trace
+	u64 replayed = 0;	// calls replayed from entries
+
+	// drops subroutines running code from the page
+	void invalidate_page(u8 page);
+};
+
+/// <summary>
+/// Call site, a, x, y, sp and status of cpu at JSR: bits 0-15 pc, 16-23 a, 24-31 x, 32-39 y, 40-47 sp, 48-55 status.
+/// </summary>
+u64 call_state(const cpu& cpu_ref);
+
+/// <summary>
+/// Runs JSR at cpu::pc: replays a cached call with the same inputs or profiles the call, never more than 'operators'.
+/// Returns operators consumed, pc is at the next opcode, 0 - nothing was done and JSR has to run normally.
+/// </summary>
+i32 run_memoized(cpu& cpu_ref, i32 operators);
+
+/// <summary>
+/// Prints cached subroutines, calls traced and replayed.
+/// </summary>
+void report_memo(const cpu& cpu_ref);
@@ -0,0 +1,953 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+#include "decimal_6502.h"
+#include "vm_6502.h"
+
+// Opcode handlers generated from (addressing mode) x (operation) policies.
+// Every table entry is exec<operation, mode>, a separate specialization the compiler inlines as a unit.
+//   addressing mode policy:	static constexpr u8 length - operand bytes after opcode
+//								static constexpr op_mode id - the mode as op_entries and the assembler know it
+//								static u16 addr(auto& c, u16 raw) - effective address for raw operand
+//   operation policy:			template <typename mode> static void run(auto& c, u16 raw)
+//								static constexpr u8 flags - flag_bit of every status bit it may change
+// Policies take any cpu-like 'c' (cpu itself or local register cache of vm_cached_6502.cpp),
+// so the same code runs on the struct and on registers kept in host registers.
+// Operation sees pc at the last byte of instruction, raw operand is either fetched by exec (through next_byte)
+// or taken from decoded record by exec_decoded, so both share one implementation.
+// Semantics (incl. pc stepping, stack order and SBC flags) follow the reference lambdas in ops_6502.cpp.
+// Cycles (CYCLES_6502): exec and exec_decoded add base_cycles of the operator, policies add what depends on state:
+// +1 for a read through abs,x, abs,y or (zp),y crossing a page, +1 for a taken branch and +1 more if it lands in another page.
+// Stores and read-modify-writes through indexed modes always take the extra cycle, so it is part of their base.
+
+// fetches next two bytes as little-endian word, sequenced
+inline u16 next_word(auto& c)
+{
+	u16 low = c.next_byte();
+	return low | (c.next_byte() << BIT_SIZE);
+}
+
+// reads little-endian word from zero page, wraps inside zero page
+inline u16 zp_word(auto& c, u8 addr)
+{
+	return c.mem[addr] | (c.mem[u8(addr + 1)] << BIT_SIZE);
+}
+
+inline u8 process_status(const auto& c)
+{
+	return (c.get_n() << 7) | (c.get_v() << 6) | (c.k << 5) | (c.b << 4) | (c.d << 3) | (c.i << 2) | (c.get_z() << 1) | (c.c);
+}
+
+inline void restore_status(auto& c, u8 status)
+{
+	c.n_value = status;
+	c.v_value = u8(status << 1);
+	c.k = (status & (1 << 5)) != 0;
+	c.b = (status & (1 << 4)) != 0;
+	c.d = (status & (1 << 3)) != 0;
+	c.i = (status & (1 << 2)) != 0;
+	c.set_z((status & (1 << 1)) != 0);
+	c.c = (status & (1)) != 0;
+}
+
+namespace reg
+{
+	struct a	{ static auto& get(auto& c) { return c.a; } };
+	struct x	{ static auto& get(auto& c) { return c.x; } };
+	struct y	{ static auto& get(auto& c) { return c.y; } };
+	struct sp	{ static auto& get(auto& c) { return c.sp; } };
+	struct zero	{ static u8 get(auto&) { return 0; } };	// STZ, read only
+}
+
+namespace flag
+{
+	struct c { static constexpr u8 bit = flag_bit::c; static bool get(const auto& cp) { return cp.c; } static void set(auto& cp, bool value) { cp.c = value; } };
+	struct z { static constexpr u8 bit = flag_bit::z; static bool get(const auto& cp) { return cp.get_z(); } static void set(auto& cp, bool value) { cp.set_z(value); } };
+	struct i { static constexpr u8 bit = flag_bit::i; static bool get(const auto& cp) { return cp.i; } static void set(auto& cp, bool value) { cp.i = value; } };
+	struct d { static constexpr u8 bit = flag_bit::d; static bool get(const auto& cp) { return cp.d; } static void set(auto& cp, bool value) { cp.d = value; } };
+	struct v { static constexpr u8 bit = flag_bit::v; static bool get(const auto& cp) { return cp.get_v(); } static void set(auto& cp, bool value) { cp.set_v(value); } };
+	struct n { static constexpr u8 bit = flag_bit::n; static bool get(const auto& cp) { return cp.get_n(); } static void set(auto& cp, bool value) { cp.set_n(value); } };
+	struct always { static constexpr u8 bit = 0; static bool get(const auto&) { return true; } };	// BRA, read only
+}
+
+namespace mode
+{
+	// cycles - of a read in this mode, other operations adjust it in base_cycles
+
+	struct imp	{ static constexpr u8 length = 0; static constexpr u8 cycles = 2; static constexpr op_mode id = op_mode::imp; };	// implied
+	struct im	{ static constexpr u8 length = 1; static constexpr u8 cycles = 2; static constexpr op_mode id = op_mode::im; };	// immediate
+	struct rel	{ static constexpr u8 length = 1; static constexpr u8 cycles = 2; static constexpr op_mode id = op_mode::rel; };	// relative, only branches
+	template <typename r> struct on_reg { static constexpr u8 length = 0; static constexpr u8 cycles = 2; static constexpr op_mode id = std::is_same_v<r, reg::a> ? op_mode::acc : op_mode::imp; };	// register as operand
+	using acc = on_reg<reg::a>;							// accumulator
+
+	struct zp		{ static constexpr u8 length = 1; static constexpr u8 cycles = 3; static constexpr op_mode id = op_mode::zp; static u16 addr(auto&, u16 raw)	{ return raw; } };							// zero page
+	struct zp_x		{ static constexpr u8 length = 1; static constexpr u8 cycles = 4; static constexpr op_mode id = op_mode::zp_x; static u16 addr(auto& c, u16 raw)	{ return u8(raw + c.x); } };				// zero page, x
+	struct zp_y		{ static constexpr u8 length = 1; static constexpr u8 cycles = 4; static constexpr op_mode id = op_mode::zp_y; static u16 addr(auto& c, u16 raw)	{ return u8(raw + c.y); } };				// zero page, y
+	struct abs		{ static constexpr u8 length = 2; static constexpr u8 cycles = 4; static constexpr op_mode id = op_mode::abs; static u16 addr(auto&, u16 raw)	{ return raw; } };							// absolute
+	struct in_x		{ static constexpr u8 length = 1; static constexpr u8 cycles = 6; static constexpr op_mode id = op_mode::in_x; static u16 addr(auto& c, u16 raw)	{ return zp_word(c, u8(raw + c.x)); } };	// indirect, x
+	struct in_zp	{ static constexpr u8 length = 1; static constexpr u8 cycles = 5; static constexpr op_mode id = op_mode::in_zp; static u16 addr(auto& c, u16 raw)	{ return zp_word(c, u8(raw)); } };		// indirect zero page, 65C02
+
+	// indexed modes that may cross a page, base - address before indexing
+
+	struct abs_x	// absolute, x
+	{
+		static constexpr u8 length = 2;
+		static constexpr u8 cycles = 4;
+		static constexpr op_mode id = op_mode::abs_x;
+		static u16 base(auto&, u16 raw)		{ return raw; }
+		static u16 addr(auto& c, u16 raw)	{ return u16(raw + c.x); }
+	};
+
+	struct abs_y	// absolute, y
+	{
+		static constexpr u8 length = 2;
+		static constexpr u8 cycles = 4;
+		static constexpr op_mode id = op_mode::abs_y;
+		static u16 base(auto&, u16 raw)		{ return raw; }
+		static u16 addr(auto& c, u16 raw)	{ return u16(raw + c.y); }
+	};
+
+	struct in_y		// indirect, y
+	{
+		static constexpr u8 length = 1;
+		static constexpr u8 cycles = 5;
+		static constexpr op_mode id = op_mode::in_y;
+		static u16 base(auto& c, u16 raw)	{ return zp_word(c, u8(raw)); }
+		static u16 addr(auto& c, u16 raw)	{ return u16(zp_word(c, u8(raw)) + c.y); }
+	};
+
+	// indirect, only JMP
+	struct in
+	{
+		static constexpr u8 length = 2;
+		static constexpr u8 cycles = 5;
+		static constexpr op_mode id = op_mode::in;
+
+		static u16 addr(auto& c, u16 raw)
+		{
+			return c.mem[raw] | (c.mem[u16(raw + 1)] << BIT_SIZE);
+		}
+	};
+
+	// indirect absolute, x, only JMP on 65C02
+	struct in_abs_x
+	{
+		static constexpr u8 length = 2;
+		static constexpr u8 cycles = 6;
+		static constexpr op_mode id = op_mode::in_abs_x;
+
+		static u16 addr(auto& c, u16 raw)
+		{
+			u16 at = u16(raw + c.x);
+			return c.mem[at] | (c.mem[u16(at + 1)] << BIT_SIZE);
+		}
+	};
+
+	// indexing may carry into the high byte of address
+	template <typename m>
+	constexpr bool crosses_pages = requires (cpu& c) { m::base(c, u16(0)); };
+}
+
+// 1 if 'from' and 'to' lie in different pages
+inline u8 page_crossed(u16 from, u16 to)
+{
+	return ((from ^ to) >> BIT_SIZE) != 0;
+}
+
+// fetches operand bytes of given addressing mode through next_byte
+template <typename m>
+u16 fetch_operand(auto& c)
+{
+	if constexpr (m::length == 2)
+	{
+		return next_word(c);
+	}
+	else if constexpr (m::length == 1)
+	{
+		return c.next_byte();
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+// where operand lives for given addressing mode
+template <typename m>
+struct operand
+{
+	static u8 read(auto& c, u16 raw)
+	{
+		u16 addr = m::addr(c, raw);
+		if constexpr (COUNT_CYCLES && mode::crosses_pages<m>)
+		{
+			c.cycles += page_crossed(m::base(c, raw), addr);
+		}
+		return c.read(addr);
+	}
+
+	static void write(auto& c, u16 raw, u8 value)
+	{
+		c.write(m::addr(c, raw), value);
+	}
+
+	template <typename modifier>
+	static void modify(auto& c, u16 raw)
+	{
+		u16 addr = m::addr(c, raw);
+		c.write(addr, modifier::apply(c, c.read(addr)));
+	}
+};
+
+template <>
+struct operand<mode::im>
+{
+	static u8 read(auto&, u16 raw)
+	{
+		return u8(raw);
+	}
+};
+
+template <typename r>
+struct operand<mode::on_reg<r>>
+{
+	template <typename modifier>
+	static void modify(auto& c, u16)
+	{
+		auto& target = r::get(c);
+		target = modifier::apply(c, target);
+	}
+};
+
+namespace operation
+{
+	// load/store
+
+	template <typename r>
+	struct load
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			auto& target = r::get(c);
+			target = operand<m>::read(c, raw);
+			c.set_nz(target);
+		}
+	};
+
+	template <typename r>
+	struct store
+	{
+		static constexpr u8 flags = 0;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			operand<m>::write(c, raw, r::get(c));
+		}
+	};
+
+	template <typename from, typename to, bool update_flags = true>
+	struct transfer
+	{
+		static constexpr u8 flags = update_flags ? flag_bit::n | flag_bit::z : 0;
+
+		template <typename m>
+		static void run(auto& c, u16)
+		{
+			to::get(c) = from::get(c);
+			if constexpr (update_flags)
+			{
+				c.set_nz(to::get(c));
+			}
+		}
+	};
+
+	// alu: kind::apply(auto&, u8 value) consumes one read operand
+
+	template <typename kind>
+	struct alu
+	{
+		static constexpr u8 flags = kind::flags;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			kind::apply(c, operand<m>::read(c, raw));
+		}
+	};
+
+	struct and_	{ static constexpr u8 flags = flag_bit::n | flag_bit::z; static void apply(auto& c, u8 value) { c.a &= value; c.set_nz(c.a); } };
+	struct eor	{ static constexpr u8 flags = flag_bit::n | flag_bit::z; static void apply(auto& c, u8 value) { c.a ^= value; c.set_nz(c.a); } };
+	struct ora	{ static constexpr u8 flags = flag_bit::n | flag_bit::z; static void apply(auto& c, u8 value) { c.a |= value; c.set_nz(c.a); } };
+
+	struct bit
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::v | flag_bit::z;
+
+		static void apply(auto& c, u8 value)
+		{
+			c.z_value = c.a & value;
+			c.v_value = u8(value << 1);
+			c.n_value = value;
+		}
+	};
+
+	// BIT immediate of 65C02 has no memory byte to take n and v from, it sets only z
+	struct bit_im { static constexpr u8 flags = flag_bit::z; static void apply(auto& c, u8 value) { c.z_value = c.a & value; } };
+
+	struct adc
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::v | flag_bit::z | flag_bit::c;
+
+		static void apply(auto& c, u8 value)
+		{
+			if (c.d)
+			{
+				apply_decimal(c, decimal_adc[decimal_index(c.c, c.a, value)]);
+				return;
+			}
+			u8 prev_a = c.a;
+			c.a += value + c.c;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
+			c.set_nz(c.a);
+		}
+	};
+
+	struct sbc
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::v | flag_bit::z | flag_bit::c;
+
+		static void apply(auto& c, u8 value)
+		{
+			if (c.d)
+			{
+				apply_decimal(c, decimal_sbc[decimal_index(c.c, c.a, value)]);
+				return;
+			}
+			u8 prev_a = c.a;
+			c.a -= value + !c.c;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
+		}
+	};
+
+	template <typename r>
+	struct cmp
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z | flag_bit::c;
+
+		static void apply(auto& c, u8 value)
+		{
+			u8 reg_value = r::get(c);
+			c.c = (reg_value >= value);
+			c.set_nz(u8(reg_value - value));
+		}
+	};
+
+	// read-modify-write: kind::apply(auto&, u8 value) returns new value, memory or register operand
+
+	template <typename kind>
+	struct rmw
+	{
+		static constexpr u8 flags = kind::flags;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			operand<m>::template modify<kind>(c, raw);
+		}
+	};
+
+	struct inc { static constexpr u8 flags = flag_bit::n | flag_bit::z; static u8 apply(auto& c, u8 value) { ++value; c.set_nz(value); return value; } };
+	struct dec { static constexpr u8 flags = flag_bit::n | flag_bit::z; static u8 apply(auto& c, u8 value) { --value; c.set_nz(value); return value; } };
+
+	struct asl
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z | flag_bit::c;
+
+		static u8 apply(auto& c, u8 value)
+		{
+			c.c = (value & 0x80) != 0;
+			value <<= 1;
+			c.set_nz(value);
+			return value;
+		}
+	};
+
+	struct lsr
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z | flag_bit::c;
+
+		static u8 apply(auto& c, u8 value)
+		{
+			c.c = (value & 0x01) != 0;
+			value >>= 1;
+			c.set_nz(value);
+			return value;
+		}
+	};
+
+	struct rol
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z | flag_bit::c;
+
+		static u8 apply(auto& c, u8 value)
+		{
+			u8 old_c = c.c;
+			c.c = (value & 0x80) != 0;
+			value = (value << 1) | old_c;
+			c.set_nz(value);
+			return value;
+		}
+	};
+
+	struct ror
+	{
+		static constexpr u8 flags = flag_bit::n | flag_bit::z | flag_bit::c;
+
+		static u8 apply(auto& c, u8 value)
+		{
+			u8 old_c = c.c;
+			c.c = (value & 0x01) != 0;
+			value = (value >> 1) | (old_c << (BIT_SIZE - 1));
+			c.set_nz(value);
+			return value;
+		}
+	};
+
+	// test and set / reset bits of 65C02, z from a & operand as BIT does
+	struct tsb { static constexpr u8 flags = flag_bit::z; static u8 apply(auto& c, u8 value) { c.z_value = c.a & value; return u8(value | c.a); } };
+	struct trb { static constexpr u8 flags = flag_bit::z; static u8 apply(auto& c, u8 value) { c.z_value = c.a & value; return u8(value & ~c.a); } };
+
+	// stack
+
+	template <typename r>
+	struct push { static constexpr u8 flags = 0; template <typename m> static void run(auto& c, u16) { c.push(r::get(c)); } };
+
+	template <typename r>
+	struct pull { static constexpr u8 flags = flag_bit::n | flag_bit::z; template <typename m> static void run(auto& c, u16) { r::get(c) = c.pull(); c.set_nz(r::get(c)); } };
+
+	struct php { static constexpr u8 flags = 0; template <typename m> static void run(auto& c, u16) { c.push(process_status(c)); } };
+	struct plp { static constexpr u8 flags = flag_bit::all; template <typename m> static void run(auto& c, u16) { restore_status(c, c.pull()); } };
+
+	// jumps & calls, pc is set to addr - 1, because counter will automaticaly increment
+
+	struct jmp
+	{
+		static constexpr u8 flags = 0;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			c.pc = m::addr(c, raw) - 1;
+		}
+	};
+
+	struct jsr
+	{
+		static constexpr u8 flags = 0;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			// pc is already at return point - 1
+			c.push(c.pc & u16(0x00FF));
+			c.push(c.pc >> BIT_SIZE);
+			c.pc = m::addr(c, raw) - 1;
+		}
+	};
+
+	struct rts
+	{
+		static constexpr u8 flags = 0;
+
+		template <typename m>
+		static void run(auto& c, u16)
+		{
+			u16 high = c.pull();
+			c.pc = (high << BIT_SIZE) | c.pull();
+		}
+	};
+
+	// branches, relative offset is counted from operand byte (pc)
+
+	template <typename f, bool value>
+	struct branch
+	{
+		static constexpr u8 flags = 0;
+
+		template <typename m>
+		static void run(auto& c, u16 raw)
+		{
+			if (f::get(c) == value)
+			{
+				u16 next = u16(c.pc + 1);
+				c.pc += i8(raw) - 1;
+				if constexpr (COUNT_CYCLES)
+				{
+					c.cycles += 1 + page_crossed(next, u16(c.pc + 1));
+				}
+			}
+		}
+	};
+
+	// status flag changes
+
+	template <typename f, bool value>
+	struct set_flag
+	{
+		static constexpr u8 flags = f::bit;
+
+		template <typename m>
+		static void run(auto& c, u16)
+		{
+			f::set(c, value);
+		}
+	};
+
+	// system functions
+
+	// 65C02 clears decimal mode too
+	template <bool clears_d>
+	struct brk
+	{
+		static constexpr u8 flags = clears_d ? flag_bit::b | flag_bit::d : flag_bit::b;
+
+		template <typename m>
+		static void run(auto& c, u16)
+		{
+			c.push(c.pc & 0xFF);
+			c.push((c.pc & 0xFF00) >> BIT_SIZE);
+			c.push(process_status(c));
+			c.pc = c.mem[0xFFFE];
+			c.pc |= (c.mem[0xFFFF] << BIT_SIZE);
+			c.b = true;
+			if constexpr (clears_d)
+			{
+				c.d = false;
+			}
+		}
+	};
+
+	struct rti
+	{
+		static constexpr u8 flags = flag_bit::all;
+
+		template <typename m>
+		static void run(auto& c, u16)
+		{
+			restore_status(c, c.pull());
+			u16 high = c.pull();
+			c.pc = (high << BIT_SIZE) | c.pull();
+		}
+	};
+
+	struct nop { static constexpr u8 flags = 0; template <typename m> static void run(auto&, u16) {} };
+	struct kil { static constexpr u8 flags = flag_bit::k; template <typename m> static void run(auto& c, u16) { c.k = true; } };
+	struct hyp { static constexpr u8 flags = flag_bit::all; template <typename m> static void run(auto& c, u16 raw) { c.hypercall(u8(raw)); } };
+}
+
+// where a taken branch with opcode at 'addr' continues, same as operation::branch
+inline u16 branch_target(u16 addr, u16 raw)
+{
+	return u16(addr + 1 + i8(raw));
+}
+
+// cycles of an operator without page and branch penalties, by default the ones of a read in its mode
+template <typename operation_t, typename mode_t>
+constexpr u8 base_cycles = mode_t::cycles;
+
+// indexed store always takes the cycle a read takes only when crossing a page
+template <typename r, typename m>
+constexpr u8 base_cycles<operation::store<r>, m> = m::cycles + mode::crosses_pages<m>;
+
+// read, modify and write back: two more cycles than a read, register operand takes two in total
+template <typename kind, typename m>
+constexpr u8 base_cycles<operation::rmw<kind>, m> = m::length == 0 ? m::cycles : m::cycles + 2 + mode::crosses_pages<m>;
+
+template <typename r, typename m> constexpr u8 base_cycles<operation::push<r>, m> = 3;
+template <typename m> constexpr u8 base_cycles<operation::php, m> = 3;
+template <typename r, typename m> constexpr u8 base_cycles<operation::pull<r>, m> = 4;
+template <typename m> constexpr u8 base_cycles<operation::plp, m> = 4;
+template <> inline constexpr u8 base_cycles<operation::jmp, mode::abs> = 3;
+template <typename m> constexpr u8 base_cycles<operation::jsr, m> = 6;
+template <typename m> constexpr u8 base_cycles<operation::rts, m> = 6;
+template <bool clears_d, typename m> constexpr u8 base_cycles<operation::brk<clears_d>, m> = 7;
+template <typename m> constexpr u8 base_cycles<operation::rti, m> = 6;
+
+// fetches operand through next_byte, used by op_table
+template <typename operation_t, typename mode_t = mode::imp, typename cpu_t = cpu>
+void exec(cpu_t& c)
+{
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += base_cycles<operation_t, mode_t>;
+	}
+	operation_t::template run<mode_t>(c, fetch_operand<mode_t>(c));
+}
+
+// operand comes from decoded record, caller has moved pc to the last byte of instruction
+template <typename operation_t, typename mode_t = mode::imp, typename cpu_t = cpu>
+void exec_decoded(cpu_t& c, u16 raw)
+{
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += base_cycles<operation_t, mode_t>;
+	}
+	operation_t::template run<mode_t>(c, raw);
+}
+
+template <typename cpu_t = cpu>
+void trap_decoded(cpu_t& c, u16)
+{
+	cpu_t::trap_unknown_op(c);
+}
+
+// operators that may continue somewhere else than the next instruction
+template <typename operation_t>
+constexpr bool jumps = false;
+
+template <typename f, bool value> constexpr bool jumps<operation::branch<f, value>> = true;
+template <> inline constexpr bool jumps<operation::jmp> = true;
+template <> inline constexpr bool jumps<operation::jsr> = true;
+template <> inline constexpr bool jumps<operation::rts> = true;
+template <bool clears_d> constexpr bool jumps<operation::brk<clears_d>> = true;
+template <> inline constexpr bool jumps<operation::rti> = true;
+
+// Everything known about an opcode, one table (op_entries) for every user:
+// dispatch (op_table, decoded records, jit and recompiler lengths), cycle counting, the assembler and tools printing code.
+template <typename cpu_t>
+struct basic_op_entry
+{
+	void (*exec)(cpu_t&)					= &cpu_t::trap_unknown_op;
+	void (*exec_decoded)(cpu_t&, u16)		= &trap_decoded<cpu_t>;
+	const char* mnemonic					= nullptr;	// nullptr - unknown opcode
+	op_mode mode							= op_mode::imp;
+	u8 length								= 1;	// opcode + operand bytes
+	u8 cycles								= 0;	// base_cycles, unknown opcodes take none
+	u8 flags								= 0;	// flag_bit of status bits it may change
+	bool jumps								= false;
+};
+
+using op_entry = basic_op_entry<cpu>;
+
+// converts to entry of any cpu-like type, so one table description serves every instantiation
+template <typename operation_t, typename mode_t>
+struct entry_of
+{
+	const char* mnemonic;
+
+	template <typename cpu_t>
+	constexpr operator basic_op_entry<cpu_t>() const
+	{
+		return
+		{
+			&exec<operation_t, mode_t, cpu_t>, &exec_decoded<operation_t, mode_t, cpu_t>,
+			mnemonic, mode_t::id, u8(1 + mode_t::length), base_cycles<operation_t, mode_t>, operation_t::flags, jumps<operation_t>
+		};
+	}
+};
+
+template <typename operation_t, typename mode_t = mode::imp>
+constexpr entry_of<operation_t, mode_t> make_entry(const char* mnemonic)
+{
+	return { mnemonic };
+}
+
+template <typename cpu_t = cpu, cpu_variant variant = cpu_variant::nmos>
+constexpr std::array<basic_op_entry<cpu_t>, OP_TABLE_SIZE> make_op_entries()
+{
+	using namespace operation;
+
+	std::array<basic_op_entry<cpu_t>, OP_TABLE_SIZE> t = {};
+
+	// load/store operations
+	t[op::LDA_IM]		= make_entry<load<reg::a>, mode::im>("LDA");
+	t[op::LDA_ZP]		= make_entry<load<reg::a>, mode::zp>("LDA");
+	t[op::LDA_ZP_X]		= make_entry<load<reg::a>, mode::zp_x>("LDA");
+	t[op::LDA_ABS]		= make_entry<load<reg::a>, mode::abs>("LDA");
+	t[op::LDA_ABS_X]	= make_entry<load<reg::a>, mode::abs_x>("LDA");
+	t[op::LDA_ABS_Y]	= make_entry<load<reg::a>, mode::abs_y>("LDA");
+	t[op::LDA_IN_X]		= make_entry<load<reg::a>, mode::in_x>("LDA");
+	t[op::LDA_IN_Y]		= make_entry<load<reg::a>, mode::in_y>("LDA");
+
+	t[op::STA_ZP]		= make_entry<store<reg::a>, mode::zp>("STA");
+	t[op::STA_ZP_X]		= make_entry<store<reg::a>, mode::zp_x>("STA");
+	t[op::STA_ABS]		= make_entry<store<reg::a>, mode::abs>("STA");
+	t[op::STA_ABS_X]	= make_entry<store<reg::a>, mode::abs_x>("STA");
+	t[op::STA_ABS_Y]	= make_entry<store<reg::a>, mode::abs_y>("STA");
+	t[op::STA_IN_X]		= make_entry<store<reg::a>, mode::in_x>("STA");
+	t[op::STA_IN_Y]		= make_entry<store<reg::a>, mode::in_y>("STA");
+
+	t[op::LDX_IM]		= make_entry<load<reg::x>, mode::im>("LDX");
+	t[op::LDX_ZP]		= make_entry<load<reg::x>, mode::zp>("LDX");
+	t[op::LDX_ZP_Y]		= make_entry<load<reg::x>, mode::zp_y>("LDX");
+	t[op::LDX_ABS]		= make_entry<load<reg::x>, mode::abs>("LDX");
+	t[op::LDX_ABS_Y]	= make_entry<load<reg::x>, mode::abs_y>("LDX");
+
+	t[op::STX_ZP]		= make_entry<store<reg::x>, mode::zp>("STX");
+	t[op::STX_ZP_Y]		= make_entry<store<reg::x>, mode::zp_y>("STX");
+	t[op::STX_ABS]		= make_entry<store<reg::x>, mode::abs>("STX");
+
+	t[op::LDY_IM]		= make_entry<load<reg::y>, mode::im>("LDY");
+	t[op::LDY_ZP]		= make_entry<load<reg::y>, mode::zp>("LDY");
+	t[op::LDY_ZP_X]		= make_entry<load<reg::y>, mode::zp_x>("LDY");
+	t[op::LDY_ABS]		= make_entry<load<reg::y>, mode::abs>("LDY");
+	t[op::LDY_ABS_X]	= make_entry<load<reg::y>, mode::abs_x>("LDY");
+
+	t[op::STY_ZP]		= make_entry<store<reg::y>, mode::zp>("STY");
+	t[op::STY_ZP_X]		= make_entry<store<reg::y>, mode::zp_x>("STY");
+	t[op::STY_ABS]		= make_entry<store<reg::y>, mode::abs>("STY");
+
+	// register transfers
+	t[op::TAX]			= make_entry<transfer<reg::a, reg::x>>("TAX");
+	t[op::TAY]			= make_entry<transfer<reg::a, reg::y>>("TAY");
+	t[op::TXA]			= make_entry<transfer<reg::x, reg::a>>("TXA");
+	t[op::TYA]			= make_entry<transfer<reg::y, reg::a>>("TYA");
+
+	// stack operations
+	t[op::TSX]			= make_entry<transfer<reg::sp, reg::x>>("TSX");
+	t[op::TXS]			= make_entry<transfer<reg::x, reg::sp, false>>("TXS");
+	t[op::PHA]			= make_entry<push<reg::a>>("PHA");
+	t[op::PHP]			= make_entry<php>("PHP");
+	t[op::PLA]			= make_entry<pull<reg::a>>("PLA");
+	t[op::PLP]			= make_entry<plp>("PLP");
+
+	// logical
+	t[op::AND_IM]		= make_entry<alu<and_>, mode::im>("AND");
+	t[op::AND_ZP]		= make_entry<alu<and_>, mode::zp>("AND");
+	t[op::AND_ZP_X]		= make_entry<alu<and_>, mode::zp_x>("AND");
+	t[op::AND_ABS]		= make_entry<alu<and_>, mode::abs>("AND");
+	t[op::AND_ABS_X]	= make_entry<alu<and_>, mode::abs_x>("AND");
+	t[op::AND_ABS_Y]	= make_entry<alu<and_>, mode::abs_y>("AND");
+	t[op::AND_IN_X]		= make_entry<alu<and_>, mode::in_x>("AND");
+	t[op::AND_IN_Y]		= make_entry<alu<and_>, mode::in_y>("AND");
+
+	t[op::EOR_IM]		= make_entry<alu<eor>, mode::im>("EOR");
+	t[op::EOR_ZP]		= make_entry<alu<eor>, mode::zp>("EOR");
+	t[op::EOR_ZP_X]		= make_entry<alu<eor>, mode::zp_x>("EOR");
+	t[op::EOR_ABS]		= make_entry<alu<eor>, mode::abs>("EOR");
+	t[op::EOR_ABS_X]	= make_entry<alu<eor>, mode::abs_x>("EOR");
+	t[op::EOR_ABS_Y]	= make_entry<alu<eor>, mode::abs_y>("EOR");
+	t[op::EOR_IN_X]		= make_entry<alu<eor>, mode::in_x>("EOR");
+	t[op::EOR_IN_Y]		= make_entry<alu<eor>, mode::in_y>("EOR");
+
+	t[op::ORA_IM]		= make_entry<alu<ora>, mode::im>("ORA");
+	t[op::ORA_ZP]		= make_entry<alu<ora>, mode::zp>("ORA");
+	t[op::ORA_ZP_X]		= make_entry<alu<ora>, mode::zp_x>("ORA");
+	t[op::ORA_ABS]		= make_entry<alu<ora>, mode::abs>("ORA");
+	t[op::ORA_ABS_X]	= make_entry<alu<ora>, mode::abs_x>("ORA");
+	t[op::ORA_ABS_Y]	= make_entry<alu<ora>, mode::abs_y>("ORA");
+	t[op::ORA_IN_X]		= make_entry<alu<ora>, mode::in_x>("ORA");
+	t[op::ORA_IN_Y]		= make_entry<alu<ora>, mode::in_y>("ORA");
+
+	t[op::BIT_ZP]		= make_entry<alu<bit>, mode::zp>("BIT");
+	t[op::BIT_ABS]		= make_entry<alu<bit>, mode::abs>("BIT");
+
+	// arithmetic
+	t[op::ADC_IM]		= make_entry<alu<adc>, mode::im>("ADC");
+	t[op::ADC_ZP]		= make_entry<alu<adc>, mode::zp>("ADC");
+	t[op::ADC_ZP_X]		= make_entry<alu<adc>, mode::zp_x>("ADC");
+	t[op::ADC_ABS]		= make_entry<alu<adc>, mode::abs>("ADC");
+	t[op::ADC_ABS_X]	= make_entry<alu<adc>, mode::abs_x>("ADC");
+	t[op::ADC_ABS_Y]	= make_entry<alu<adc>, mode::abs_y>("ADC");
+	t[op::ADC_IN_X]		= make_entry<alu<adc>, mode::in_x>("ADC");
+	t[op::ADC_IN_Y]		= make_entry<alu<adc>, mode::in_y>("ADC");
+
+	t[op::SBC_IM]		= make_entry<alu<sbc>, mode::im>("SBC");
+	t[op::SBC_ZP]		= make_entry<alu<sbc>, mode::zp>("SBC");
+	t[op::SBC_ZP_X]		= make_entry<alu<sbc>, mode::zp_x>("SBC");
+	t[op::SBC_ABS]		= make_entry<alu<sbc>, mode::abs>("SBC");
+	t[op::SBC_ABS_X]	= make_entry<alu<sbc>, mode::abs_x>("SBC");
+	t[op::SBC_ABS_Y]	= make_entry<alu<sbc>, mode::abs_y>("SBC");
+	t[op::SBC_IN_X]		= make_entry<alu<sbc>, mode::in_x>("SBC");
+	t[op::SBC_IN_Y]		= make_entry<alu<sbc>, mode::in_y>("SBC");
+
+	t[op::CMP_IM]		= make_entry<alu<cmp<reg::a>>, mode::im>("CMP");
+	t[op::CMP_ZP]		= make_entry<alu<cmp<reg::a>>, mode::zp>("CMP");
+	t[op::CMP_ZP_X]		= make_entry<alu<cmp<reg::a>>, mode::zp_x>("CMP");
+	t[op::CMP_ABS]		= make_entry<alu<cmp<reg::a>>, mode::abs>("CMP");
+	t[op::CMP_ABS_X]	= make_entry<alu<cmp<reg::a>>, mode::abs_x>("CMP");
+	t[op::CMP_ABS_Y]	= make_entry<alu<cmp<reg::a>>, mode::abs_y>("CMP");
+	t[op::CMP_IN_X]		= make_entry<alu<cmp<reg::a>>, mode::in_x>("CMP");
+	t[op::CMP_IN_Y]		= make_entry<alu<cmp<reg::a>>, mode::in_y>("CMP");
+
+	t[op::CPX_IM]		= make_entry<alu<cmp<reg::x>>, mode::im>("CPX");
+	t[op::CPX_ZP]		= make_entry<alu<cmp<reg::x>>, mode::zp>("CPX");
+	t[op::CPX_ABS]		= make_entry<alu<cmp<reg::x>>, mode::abs>("CPX");
+
+	t[op::CPY_IM]		= make_entry<alu<cmp<reg::y>>, mode::im>("CPY");
+	t[op::CPY_ZP]		= make_entry<alu<cmp<reg::y>>, mode::zp>("CPY");
+	t[op::CPY_ABS]		= make_entry<alu<cmp<reg::y>>, mode::abs>("CPY");
+
+	// increments & decrements
+	t[op::INC_ZP]		= make_entry<rmw<inc>, mode::zp>("INC");
+	t[op::INC_ZP_X]		= make_entry<rmw<inc>, mode::zp_x>("INC");
+	t[op::INC_ABS]		= make_entry<rmw<inc>, mode::abs>("INC");
+	t[op::INC_ABS_X]	= make_entry<rmw<inc>, mode::abs_x>("INC");
+
+	t[op::INX]			= make_entry<rmw<inc>, mode::on_reg<reg::x>>("INX");
+	t[op::INY]			= make_entry<rmw<inc>, mode::on_reg<reg::y>>("INY");
+
+	t[op::DEC_ZP]		= make_entry<rmw<dec>, mode::zp>("DEC");
+	t[op::DEC_ZP_X]		= make_entry<rmw<dec>, mode::zp_x>("DEC");
+	t[op::DEC_ABS]		= make_entry<rmw<dec>, mode::abs>("DEC");
+	t[op::DEC_ABS_X]	= make_entry<rmw<dec>, mode::abs_x>("DEC");
+
+	t[op::DEX]			= make_entry<rmw<dec>, mode::on_reg<reg::x>>("DEX");
+	t[op::DEY]			= make_entry<rmw<dec>, mode::on_reg<reg::y>>("DEY");
+
+	// shifts
+	t[op::ASL_A]		= make_entry<rmw<asl>, mode::acc>("ASL");
+	t[op::ASL_ZP]		= make_entry<rmw<asl>, mode::zp>("ASL");
+	t[op::ASL_ZP_X]		= make_entry<rmw<asl>, mode::zp_x>("ASL");
+	t[op::ASL_ABS]		= make_entry<rmw<asl>, mode::abs>("ASL");
+	t[op::ASL_ABS_X]	= make_entry<rmw<asl>, mode::abs_x>("ASL");
+
+	t[op::LSR_A]		= make_entry<rmw<lsr>, mode::acc>("LSR");
+	t[op::LSR_ZP]		= make_entry<rmw<lsr>, mode::zp>("LSR");
+	t[op::LSR_ZP_X]		= make_entry<rmw<lsr>, mode::zp_x>("LSR");
+	t[op::LSR_ABS]		= make_entry<rmw<lsr>, mode::abs>("LSR");
+	t[op::LSR_ABS_X]	= make_entry<rmw<lsr>, mode::abs_x>("LSR");
+
+	t[op::ROL_A]		= make_entry<rmw<rol>, mode::acc>("ROL");
+	t[op::ROL_ZP]		= make_entry<rmw<rol>, mode::zp>("ROL");
+	t[op::ROL_ZP_X]		= make_entry<rmw<rol>, mode::zp_x>("ROL");
+	t[op::ROL_ABS]		= make_entry<rmw<rol>, mode::abs>("ROL");
+	t[op::ROL_ABS_X]	= make_entry<rmw<rol>, mode::abs_x>("ROL");
+
+	t[op::ROR_A]		= make_entry<rmw<ror>, mode::acc>("ROR");
+	t[op::ROR_ZP]		= make_entry<rmw<ror>, mode::zp>("ROR");
+	t[op::ROR_ZP_X]		= make_entry<rmw<ror>, mode::zp_x>("ROR");
+	t[op::ROR_ABS]		= make_entry<rmw<ror>, mode::abs>("ROR");
+	t[op::ROR_ABS_X]	= make_entry<rmw<ror>, mode::abs_x>("ROR");
+
+	// jumps & calls
+	t[op::JMP_ABS]		= make_entry<jmp, mode::abs>("JMP");
+	t[op::JMP_IN]		= make_entry<jmp, mode::in>("JMP");
+	t[op::JSR_ABS]		= make_entry<jsr, mode::abs>("JSR");
+	t[op::RTS]			= make_entry<rts>("RTS");
+
+	// branches
+	t[op::BCC]			= make_entry<branch<flag::c, false>, mode::rel>("BCC");
+	t[op::BCS]			= make_entry<branch<flag::c, true>, mode::rel>("BCS");
+	t[op::BEQ]			= make_entry<branch<flag::z, true>, mode::rel>("BEQ");
+	t[op::BMI]			= make_entry<branch<flag::n, true>, mode::rel>("BMI");
+	t[op::BNE]			= make_entry<branch<flag::z, false>, mode::rel>("BNE");
+	t[op::BPL]			= make_entry<branch<flag::n, false>, mode::rel>("BPL");
+	t[op::BVC]			= make_entry<branch<flag::v, false>, mode::rel>("BVC");
+	t[op::BVS]			= make_entry<branch<flag::v, true>, mode::rel>("BVS");
+
+	// status flag changes
+	t[op::CLC]			= make_entry<set_flag<flag::c, false>>("CLC");
+	t[op::CLD]			= make_entry<set_flag<flag::d, false>>("CLD");
+	t[op::CLI]			= make_entry<set_flag<flag::i, false>>("CLI");
+	t[op::CLV]			= make_entry<set_flag<flag::v, false>>("CLV");
+	t[op::SEC]			= make_entry<set_flag<flag::c, true>>("SEC");
+	t[op::SED]			= make_entry<set_flag<flag::d, true>>("SED");
+	t[op::SEI]			= make_entry<set_flag<flag::i, true>>("SEI");
+
+	// system functions
+	t[op::BRK]			= make_entry<operation::brk<false>>("BRK");	// qualified, POSIX brk() may be visible globally
+	t[op::RTI]			= make_entry<rti>("RTI");
+	t[op::NOP]			= make_entry<nop>("NOP");
+	t[op::KIL]			= make_entry<kil>("KIL");
+	t[op::HYP]			= make_entry<hyp, mode::im>("HYP");
+
+	if constexpr (variant == cpu_variant::cmos)
+	{
+		t[op::LDA_IN_ZP]	= make_entry<load<reg::a>, mode::in_zp>("LDA");
+		t[op::STA_IN_ZP]	= make_entry<store<reg::a>, mode::in_zp>("STA");
+
+		t[op::STZ_ZP]		= make_entry<store<reg::zero>, mode::zp>("STZ");
+		t[op::STZ_ZP_X]		= make_entry<store<reg::zero>, mode::zp_x>("STZ");
+		t[op::STZ_ABS]		= make_entry<store<reg::zero>, mode::abs>("STZ");
+		t[op::STZ_ABS_X]	= make_entry<store<reg::zero>, mode::abs_x>("STZ");
+
+		t[op::PHX]			= make_entry<push<reg::x>>("PHX");
+		t[op::PHY]			= make_entry<push<reg::y>>("PHY");
+		t[op::PLX]			= make_entry<pull<reg::x>>("PLX");
+		t[op::PLY]			= make_entry<pull<reg::y>>("PLY");
+
+		t[op::AND_IN_ZP]	= make_entry<alu<and_>, mode::in_zp>("AND");
+		t[op::EOR_IN_ZP]	= make_entry<alu<eor>, mode::in_zp>("EOR");
+		t[op::ORA_IN_ZP]	= make_entry<alu<ora>, mode::in_zp>("ORA");
+
+		t[op::BIT_IM]		= make_entry<alu<bit_im>, mode::im>("BIT");
+		t[op::BIT_ZP_X]		= make_entry<alu<bit>, mode::zp_x>("BIT");
+		t[op::BIT_ABS_X]	= make_entry<alu<bit>, mode::abs_x>("BIT");
+
+		t[op::TRB_ZP]		= make_entry<rmw<trb>, mode::zp>("TRB");
+		t[op::TRB_ABS]		= make_entry<rmw<trb>, mode::abs>("TRB");
+		t[op::TSB_ZP]		= make_entry<rmw<tsb>, mode::zp>("TSB");
+		t[op::TSB_ABS]		= make_entry<rmw<tsb>, mode::abs>("TSB");
+
+		t[op::ADC_IN_ZP]	= make_entry<alu<adc>, mode::in_zp>("ADC");
+		t[op::SBC_IN_ZP]	= make_entry<alu<sbc>, mode::in_zp>("SBC");
+		t[op::CMP_IN_ZP]	= make_entry<alu<cmp<reg::a>>, mode::in_zp>("CMP");
+
+		t[op::INC_A]		= make_entry<rmw<inc>, mode::acc>("INC");
+		t[op::DEC_A]		= make_entry<rmw<dec>, mode::acc>("DEC");
+
+		t[op::JMP_IN_ABS_X]	= make_entry<jmp, mode::in_abs_x>("JMP");
+		t[op::BRA]			= make_entry<branch<flag::always, true>, mode::rel>("BRA");
+
+		t[op::BRK]			= make_entry<operation::brk<true>>("BRK");
+	}
+
+	return t;
+}
+
+// entries of every instruction set, op_entries is the NMOS one
+template <cpu_variant variant>
+inline constexpr std::array<op_entry, OP_TABLE_SIZE> variant_op_entries = make_op_entries<cpu, variant>();
+
+inline constexpr const std::array<op_entry, OP_TABLE_SIZE>& op_entries = variant_op_entries<cpu_variant::nmos>;
+
+// base cycles by opcode, the same whether or not CYCLES_6502 is defined
+constexpr std::array<u8, OP_TABLE_SIZE> make_op_cycles()
+{
+	std::array<u8, OP_TABLE_SIZE> t = {};
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		t[code] = op_entries[code].cycles;
+	}
+	return t;
+}
+
+inline constexpr std::array<u8, OP_TABLE_SIZE> op_cycles = make_op_cycles();
+
+// penalties add at most 2 cycles and only to operators of 5 or less, cpu::run_until slices cycle budgets by this bound
+static_assert(std::ranges::max(op_cycles) == MAX_OPERATOR_CYCLES);
+static_assert(std::ranges::max(variant_op_entries<cpu_variant::cmos>, {}, &op_entry::cycles).cycles == MAX_OPERATOR_CYCLES);
+
+template <cpu_variant variant = cpu_variant::nmos>
+constexpr std::array<op_handler, OP_TABLE_SIZE> make_op_table()
+{
+	std::array<op_handler, OP_TABLE_SIZE> t = {};
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		t[code] = variant_op_entries<variant>[code].exec;
+	}
+	return t;
+}
+
+// expands apply(code) for every opcode 0x00..0xFF, for engines that need one block per opcode
+#define OP_ROW(apply, h)																\
+	apply(0x##h##0) apply(0x##h##1) apply(0x##h##2) apply(0x##h##3)						\
+	apply(0x##h##4) apply(0x##h##5) apply(0x##h##6) apply(0x##h##7)						\
+	apply(0x##h##8) apply(0x##h##9) apply(0x##h##A) apply(0x##h##B)						\
+	apply(0x##h##C) apply(0x##h##D) apply(0x##h##E) apply(0x##h##F)
+
+#define OP_ALL(apply)																	\
+	OP_ROW(apply, 0) OP_ROW(apply, 1) OP_ROW(apply, 2) OP_ROW(apply, 3)					\
+	OP_ROW(apply, 4) OP_ROW(apply, 5) OP_ROW(apply, 6) OP_ROW(apply, 7)					\
+	OP_ROW(apply, 8) OP_ROW(apply, 9) OP_ROW(apply, A) OP_ROW(apply, B)					\
+	OP_ROW(apply, C) OP_ROW(apply, D) OP_ROW(apply, E) OP_ROW(apply, F)
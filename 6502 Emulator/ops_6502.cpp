@@ -5,21 +5,66 @@
 
 #define NEXT_WORD (c.next_byte() | (c.next_byte() << BIT_SIZE))
 #define POP_WORD ((c.pull() << BIT_SIZE) | c.pull())
-#define PROCESS_STATUS ((c.n << 7) | (c.v << 6) | (c.k << 5) | (c.b << 4) | (c.d << 3) | (c.i << 2) | (c.z << 1) | (c.c))
+#define PROCESS_STATUS ((c.get_n() << 7) | (c.get_v() << 6) | (c.k << 5) | (c.b << 4) | (c.d << 3) | (c.i << 2) | (c.get_z() << 1) | (c.c))
 
 #define GET_INDIRECT_ADDR_X u8 addr = u8(c.next_byte() + c.x);
 #define GET_INDIRECT_ADDR_Y u8 addr = u8(c.next_byte());
-#define CONCAT_ADDR (c.mem[addr] | ((c.mem[addr + 1]) << BIT_SIZE))
+#define CONCAT_ADDR (c.mem[addr] | ((c.mem[u8(addr + 1)]) << BIT_SIZE))
 
-std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
+// decimal mode, digit by digit (operation policies use precomputed tables instead, see decimal_6502.h)
+static void add_decimal(cpu& c, u8 value)
+{
+	u8 binary = u8(c.a + value + c.c);
+	u32 lo = (c.a & 0x0F) + (value & 0x0F) + c.c;
+	u32 hi = (c.a >> 4) + (value >> 4);
+	if (lo > 9)
+	{
+		lo += 6;
+		hi++;
+	}
+	// n and v before the high digit is adjusted
+	u8 partial = u8(hi << 4);
+	c.set_n((partial & 0x80) != 0);
+	c.set_v((~(c.a ^ value) & (c.a ^ partial) & 0x80) != 0);
+	c.set_z(binary == 0);
+	if (hi > 9)
+	{
+		hi += 6;
+	}
+	c.c = hi > 0x0F;
+	c.a = u8((hi << 4) | (lo & 0x0F));
+}
+
+static void subtract_decimal(cpu& c, u8 value)
+{
+	// n, v and z of the binary difference, carry if nothing was borrowed
+	u8 binary = u8(c.a - value - !c.c);
+	bool no_borrow = i32(c.a) >= i32(value) + !c.c;
+	c.v_value = (c.a ^ value) & (c.a ^ binary);
+	i32 lo = (c.a & 0x0F) - (value & 0x0F) - !c.c;
+	i32 hi = (c.a >> 4) - (value >> 4);
+	if (lo < 0)
+	{
+		lo -= 6;
+		hi--;
+	}
+	if (hi < 0)
+	{
+		hi -= 6;
+	}
+	c.c = no_borrow;
+	c.set_nz(binary);
+	c.a = u8((hi << 4) | (lo & 0x0F));
+}
+
+std::unordered_map<u8, op_handler> cpu::op_map =
 {
 	{
 		op::LDA_IM,
 		[](cpu& c)
 		{
 			c.a = c.next_byte();
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -28,8 +73,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.mem[c.next_byte()];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -38,8 +82,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.mem[u8(c.next_byte() + c.x)];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -48,8 +91,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.mem[NEXT_WORD];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -57,9 +99,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDA_ABS_X,
 		[](cpu& c)
 		{
-			c.a = c.mem[NEXT_WORD + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a = c.mem[u16(NEXT_WORD + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -67,9 +108,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDA_ABS_Y,
 		[](cpu& c)
 		{
-			c.a = c.mem[NEXT_WORD + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a = c.mem[u16(NEXT_WORD + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -79,8 +119,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			GET_INDIRECT_ADDR_X;
 			c.a = c.mem[CONCAT_ADDR];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -89,9 +128,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			c.a = c.mem[CONCAT_ADDR + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a = c.mem[u16(CONCAT_ADDR + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -107,7 +145,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::STA_ZP_X,
 		[](cpu& c)
 		{
-			c.mem[c.next_byte() + c.x] = c.a;
+			c.mem[u8(c.next_byte() + c.x)] = c.a;
 			return;
 		}
 	},
@@ -123,7 +161,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::STA_ABS_X,
 		[](cpu& c)
 		{
-			c.mem[NEXT_WORD + c.x] = c.a;
+			c.mem[u16(NEXT_WORD + c.x)] = c.a;
 			return;
 		}
 	},
@@ -131,7 +169,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::STA_ABS_Y,
 		[](cpu& c)
 		{
-			c.mem[NEXT_WORD + c.y] = c.a;
+			c.mem[u16(NEXT_WORD + c.y)] = c.a;
 			return;
 		}
 	},
@@ -149,7 +187,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			c.mem[CONCAT_ADDR + c.y] = c.a;
+			c.mem[u16(CONCAT_ADDR + c.y)] = c.a;
 			return;
 		}
 	},	
@@ -158,8 +196,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.x = c.next_byte();
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -168,8 +205,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.x = c.mem[c.next_byte()];
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -177,9 +213,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDX_ZP_Y,
 		[](cpu& c)
 		{
-			c.x = c.mem[c.next_byte() + c.y];
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.x = c.mem[u8(c.next_byte() + c.y)];
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -188,8 +223,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.x = c.mem[NEXT_WORD];
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -197,9 +231,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDX_ABS_Y,
 		[](cpu& c)
 		{
-			c.x = c.mem[NEXT_WORD + c.y];
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.x = c.mem[u16(NEXT_WORD + c.y)];
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -215,7 +248,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::STX_ZP_Y,
 		[](cpu& c)
 		{
-			c.mem[c.next_byte() + c.y] = c.x;
+			c.mem[u8(c.next_byte() + c.y)] = c.x;
 			return;
 		}
 	},
@@ -232,8 +265,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.y = c.next_byte();
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -242,8 +274,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.y = c.mem[c.next_byte()];
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -251,9 +282,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDY_ZP_X,
 		[](cpu& c)
 		{
-			c.y = c.mem[c.next_byte() + c.x];
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.y = c.mem[u8(c.next_byte() + c.x)];
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -262,8 +292,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.y = c.mem[NEXT_WORD];
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -271,9 +300,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LDY_ABS_X,
 		[](cpu& c)
 		{
-			c.y = c.mem[NEXT_WORD + c.x];
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.y = c.mem[u16(NEXT_WORD + c.x)];
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -289,7 +317,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::STY_ZP_X,
 		[](cpu& c)
 		{
-			c.mem[c.next_byte() + c.x] = c.y;
+			c.mem[u8(c.next_byte() + c.x)] = c.y;
 			return;
 		}
 	},
@@ -306,8 +334,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.x = c.a;
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -316,8 +343,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.y = c.a;
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -326,8 +352,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.x;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -336,8 +361,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.y;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -346,8 +370,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.x = c.sp;
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -380,8 +403,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a = c.pull();
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -390,13 +412,13 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 temp = c.pull();
-			c.n = (temp & (1 << 7)) != 0;
-			c.v = (temp & (1 << 6)) != 0;
+			c.n_value = temp;
+			c.v_value = u8(temp << 1);
 			c.k = (temp & (1 << 5)) != 0;
 			c.b = (temp & (1 << 4)) != 0;
 			c.d = (temp & (1 << 3)) != 0;
 			c.i = (temp & (1 << 2)) != 0;
-			c.z = (temp & (1 << 1)) != 0;
+			c.set_z((temp & (1 << 1)) != 0);
 			c.c = (temp & (1)) != 0;
 			return;
 		}
@@ -406,8 +428,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a &= c.next_byte();
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -416,8 +437,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a &= c.mem[c.next_byte()];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -425,9 +445,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::AND_ZP_X,
 		[](cpu& c)
 		{
-			c.a &= c.mem[c.next_byte() + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a &= c.mem[u8(c.next_byte() + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -436,8 +455,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a &= c.mem[NEXT_WORD];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -445,9 +463,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::AND_ABS_X,
 		[](cpu& c)
 		{
-			c.a &= c.mem[NEXT_WORD + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a &= c.mem[u16(NEXT_WORD + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -455,9 +472,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::AND_ABS_Y,
 		[](cpu& c)
 		{
-			c.a &= c.mem[NEXT_WORD + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a &= c.mem[u16(NEXT_WORD + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -467,8 +483,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			GET_INDIRECT_ADDR_X;
 			c.a &= c.mem[CONCAT_ADDR];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -477,9 +492,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			c.a &= c.mem[CONCAT_ADDR + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a &= c.mem[u16(CONCAT_ADDR + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -488,8 +502,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a ^= c.next_byte();
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -498,8 +511,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a ^= c.mem[c.next_byte()];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -507,9 +519,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::EOR_ZP_X,
 		[](cpu& c)
 		{
-			c.a ^= c.mem[c.next_byte() + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a ^= c.mem[u8(c.next_byte() + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -518,8 +529,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a ^= c.mem[NEXT_WORD];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -527,9 +537,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::EOR_ABS_X,
 		[](cpu& c)
 		{
-			c.a ^= c.mem[NEXT_WORD + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a ^= c.mem[u16(NEXT_WORD + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -537,9 +546,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::EOR_ABS_Y,
 		[](cpu& c)
 		{
-			c.a ^= c.mem[NEXT_WORD + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a ^= c.mem[u16(NEXT_WORD + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -549,8 +557,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			GET_INDIRECT_ADDR_X;
 			c.a ^= c.mem[CONCAT_ADDR];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -559,9 +566,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			c.a ^= c.mem[CONCAT_ADDR + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a ^= c.mem[u16(CONCAT_ADDR + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -570,8 +576,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a |= c.next_byte();
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -580,8 +585,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a |= c.mem[c.next_byte()];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -589,9 +593,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ORA_ZP_X,
 		[](cpu& c)
 		{
-			c.a |= c.mem[c.next_byte() + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a |= c.mem[u8(c.next_byte() + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -600,8 +603,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			c.a |= c.mem[NEXT_WORD];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -609,9 +611,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ORA_ABS_X,
 		[](cpu& c)
 		{
-			c.a |= c.mem[NEXT_WORD + c.x];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a |= c.mem[u16(NEXT_WORD + c.x)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -619,9 +620,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ORA_ABS_Y,
 		[](cpu& c)
 		{
-			c.a |= c.mem[NEXT_WORD + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a |= c.mem[u16(NEXT_WORD + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -631,8 +631,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			GET_INDIRECT_ADDR_X;
 			c.a |= c.mem[CONCAT_ADDR];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -641,9 +640,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			c.a |= c.mem[CONCAT_ADDR + c.y];
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.a |= c.mem[u16(CONCAT_ADDR + c.y)];
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -652,9 +650,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 temp = c.mem[c.next_byte()];
-			c.z = ((c.a & temp) == 0);
-			c.v = (temp & 0b01000000) != 0;
-			c.n = (temp & 0b10000000) != 0;
+			c.z_value = c.a & temp;
+			c.v_value = u8(temp << 1);
+			c.n_value = temp;
 			return;
 		}
 	},
@@ -663,9 +661,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 temp = c.mem[NEXT_WORD];
-			c.z = ((c.a & temp) == 0);
-			c.v = (temp & 0b01000000) != 0;
-			c.n = (temp & 0b10000000) != 0;
+			c.z_value = c.a & temp;
+			c.v_value = u8(temp << 1);
+			c.n_value = temp;
 			return;
 		}
 	},
@@ -675,11 +673,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.next_byte();
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -689,11 +691,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.mem[c.next_byte()];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -702,12 +708,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[c.next_byte() + c.x];
+			u8 value = c.mem[u8(c.next_byte() + c.x)];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -717,11 +727,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.mem[NEXT_WORD];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -730,12 +744,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[NEXT_WORD + c.x];
+			u8 value = c.mem[u16(NEXT_WORD + c.x)];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -744,12 +762,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[NEXT_WORD + c.y];
+			u8 value = c.mem[u16(NEXT_WORD + c.y)];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -760,11 +782,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8 prev_a = c.a;
 			GET_INDIRECT_ADDR_X;
 			u8 value = c.mem[CONCAT_ADDR];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -774,12 +800,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			GET_INDIRECT_ADDR_Y;
-			u8 value = c.mem[CONCAT_ADDR + c.y];
+			u8 value = c.mem[u16(CONCAT_ADDR + c.y)];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
 			c.a += value + c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
 			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -789,11 +819,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.next_byte();
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -803,11 +837,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.mem[c.next_byte()];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -816,12 +854,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[c.next_byte() + c.x];
+			u8 value = c.mem[u8(c.next_byte() + c.x)];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -831,11 +873,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			u8 value = c.mem[NEXT_WORD];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -844,12 +890,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[NEXT_WORD + c.x];
+			u8 value = c.mem[u16(NEXT_WORD + c.x)];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -858,12 +908,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 prev_a = c.a;
-			u8 value = c.mem[NEXT_WORD + c.y];
+			u8 value = c.mem[u16(NEXT_WORD + c.y)];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -874,11 +928,15 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8 prev_a = c.a;
 			GET_INDIRECT_ADDR_X;
 			u8 value = c.mem[CONCAT_ADDR];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -888,12 +946,16 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 prev_a = c.a;
 			GET_INDIRECT_ADDR_Y;
-			u8 value = c.mem[CONCAT_ADDR + c.y];
+			u8 value = c.mem[u16(CONCAT_ADDR + c.y)];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
 			c.a -= value + !c.c;
-			c.v = ( (prev_a ^ c.a) & (value ^ c.a) & 0x80 ) != 0;
-			c.c = ~c.v;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -903,8 +965,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.next_byte();
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -914,8 +975,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[c.next_byte()];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -923,10 +983,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::CMP_ZP_X,
 		[](cpu& c)
 		{
-			u8 value = c.mem[c.next_byte() + c.x];
+			u8 value = c.mem[u8(c.next_byte() + c.x)];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -936,8 +995,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[NEXT_WORD];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -945,10 +1003,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::CMP_ABS_X,
 		[](cpu& c)
 		{
-			u8 value = c.mem[NEXT_WORD + c.x];
+			u8 value = c.mem[u16(NEXT_WORD + c.x)];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -956,10 +1013,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::CMP_ABS_Y,
 		[](cpu& c)
 		{
-			u8 value = c.mem[NEXT_WORD + c.y];
+			u8 value = c.mem[u16(NEXT_WORD + c.y)];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -970,8 +1026,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			GET_INDIRECT_ADDR_X;
 			u8 value = c.mem[CONCAT_ADDR];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -980,10 +1035,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			GET_INDIRECT_ADDR_Y;
-			u8 value = c.mem[CONCAT_ADDR + c.y];
+			u8 value = c.mem[u16(CONCAT_ADDR + c.y)];
 			c.c = (c.a >= value);
-			c.z = (c.a == value);
-			c.n = ((c.a - value) & 0x80) != 0;
+			c.set_nz(u8(c.a - value));
 			return;
 		}
 	},
@@ -993,8 +1047,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.next_byte();
 			c.c = (c.x >= value);
-			c.z = (c.x == value);
-			c.n = ((c.x - value) & 0x80) != 0;
+			c.set_nz(u8(c.x - value));
 			return;
 		}
 	},
@@ -1004,8 +1057,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[c.next_byte()];
 			c.c = (c.x >= value);
-			c.z = (c.x == value);
-			c.n = ((c.x - value) & 0x80) != 0;
+			c.set_nz(u8(c.x - value));
 			return;
 		}
 	},
@@ -1015,8 +1067,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[NEXT_WORD];
 			c.c = (c.x >= value);
-			c.z = (c.x == value);
-			c.n = ((c.x - value) & 0x80) != 0;
+			c.set_nz(u8(c.x - value));
 			return;
 		}
 	},
@@ -1026,8 +1077,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.next_byte();
 			c.c = (c.y >= value);
-			c.z = (c.y == value);
-			c.n = ((c.y - value) & 0x80) != 0;
+			c.set_nz(u8(c.y - value));
 			return;
 		}
 	},
@@ -1037,8 +1087,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[c.next_byte()];
 			c.c = (c.y >= value);
-			c.z = (c.y == value);
-			c.n = ((c.y - value) & 0x80) != 0;
+			c.set_nz(u8(c.y - value));
 			return;
 		}
 	},
@@ -1048,8 +1097,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8 value = c.mem[NEXT_WORD];
 			c.c = (c.y >= value);
-			c.z = (c.y == value);
-			c.n = ((c.y - value) & 0x80) != 0;
+			c.set_nz(u8(c.y - value));
 			return;
 		}
 	},
@@ -1059,8 +1107,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8& addr = c.mem[c.next_byte()];
 			++addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1068,10 +1115,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::INC_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			++addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1081,19 +1127,17 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8& addr = c.mem[NEXT_WORD];
 			++addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
 	{
-		op::INC_ABS,
+		op::INC_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			++addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1102,8 +1146,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			++c.x;
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -1112,8 +1155,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			++c.y;
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -1123,8 +1165,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8& addr = c.mem[c.next_byte()];
 			--addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1132,10 +1173,9 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::DEC_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			--addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1145,19 +1185,17 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			u8& addr = c.mem[NEXT_WORD];
 			--addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
 	{
-		op::DEC_ABS,
+		op::DEC_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			--addr;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1166,8 +1204,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			--c.x;
-			c.z = (c.x == 0);
-			c.n = (c.x & 0x80) != 0;
+			c.set_nz(c.x);
 			return;
 		}
 	},
@@ -1176,8 +1213,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			--c.y;
-			c.z = (c.y == 0);
-			c.n = (c.y & 0x80) != 0;
+			c.set_nz(c.y);
 			return;
 		}
 	},
@@ -1187,8 +1223,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			c.c = (c.a & 0x80) != 0;
 			c.a <<= 1;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -1199,8 +1234,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8& addr = c.mem[c.next_byte()];
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1208,11 +1242,10 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ASL_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1223,8 +1256,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8& addr = c.mem[NEXT_WORD];
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1232,11 +1264,10 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ASL_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1246,8 +1277,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		{
 			c.c = (c.a & 0x01) != 0;
 			c.a >>= 1;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -1258,8 +1288,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8& addr = c.mem[c.next_byte()];
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1267,11 +1296,10 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LSR_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1282,8 +1310,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			u8& addr = c.mem[NEXT_WORD];
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1291,11 +1318,10 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::LSR_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1307,8 +1333,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (c.a & 0x80) != 0;
 			c.a <<= 1;
 			c.a |= old_c;
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -1321,8 +1346,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
 			addr |= old_c;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1330,13 +1354,12 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ROL_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			u8 old_c = c.c;
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
 			addr |= old_c;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1349,8 +1372,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
 			addr |= old_c;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1358,13 +1380,12 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ROL_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			u8 old_c = c.c;
 			c.c = (addr & 0x80) != 0;
 			addr <<= 1;
 			addr |= old_c;
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1376,8 +1397,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (c.a & 0x01) != 0;
 			c.a >>= 1;
 			c.a |= (old_c << (BIT_SIZE - 1));
-			c.z = (c.a == 0);
-			c.n = (c.a & 0x80) != 0;
+			c.set_nz(c.a);
 			return;
 		}
 	},
@@ -1390,8 +1410,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
 			addr |= (old_c << (BIT_SIZE - 1));
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1399,13 +1418,12 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ROR_ZP_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[c.next_byte() + c.x];
+			u8& addr = c.mem[u8(c.next_byte() + c.x)];
 			u8 old_c = c.c;
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
 			addr |= (old_c << (BIT_SIZE - 1));
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1418,8 +1436,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
 			addr |= (old_c << (BIT_SIZE - 1));
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1427,13 +1444,12 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::ROR_ABS_X,
 		[](cpu& c)
 		{
-			u8& addr = c.mem[NEXT_WORD + c.x];
+			u8& addr = c.mem[u16(NEXT_WORD + c.x)];
 			u8 old_c = c.c;
 			c.c = (addr & 0x01) != 0;
 			addr >>= 1;
 			addr |= (old_c << (BIT_SIZE - 1));
-			c.z = (addr == 0);
-			c.n = (addr & 0x80) != 0;
+			c.set_nz(addr);
 			return;
 		}
 	},
@@ -1449,8 +1465,8 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::JMP_IN,
 		[](cpu& c)
 		{
-			u16 addr = u16(c.mem[c.next_byte()]) | (c.mem[c.next_byte()] << BIT_SIZE);
-			c.pc = (u16(c.mem[addr]) + (u16(c.mem[addr + 1]) << BIT_SIZE)) - 1;
+			u16 addr = NEXT_WORD;
+			c.pc = (u16(c.mem[addr]) + (u16(c.mem[u16(addr + 1)]) << BIT_SIZE)) - 1;
 			return;
 		}
 	},
@@ -1508,7 +1524,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BEQ,
 		[](cpu& c)
 		{
-			if (c.z != 0)
+			if (c.get_z())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1523,7 +1539,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BMI,
 		[](cpu& c)
 		{
-			if (c.n != 0)
+			if (c.get_n())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1538,7 +1554,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BNE,
 		[](cpu& c)
 		{
-			if (c.z == 0)
+			if (!c.get_z())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1553,7 +1569,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BPL,
 		[](cpu& c)
 		{
-			if (c.n == 0)
+			if (!c.get_n())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1568,7 +1584,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BVC,
 		[](cpu& c)
 		{
-			if (c.v == 0)
+			if (!c.get_v())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1583,7 +1599,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::BVS,
 		[](cpu& c)
 		{
-			if (c.v != 0)
+			if (c.get_v())
 			{
 				c.pc += i8(c.next_byte()) - 1;
 			}
@@ -1602,6 +1618,14 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			return;
 		}
 	},
+	{
+		op::CLD,
+		[](cpu& c)
+		{
+			c.d = false;
+			return;
+		}
+	},
 	{
 		op::CLI,
 		[](cpu& c)
@@ -1614,7 +1638,7 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		op::CLV,
 		[](cpu& c)
 		{
-			c.v = false;
+			c.set_v(false);
 			return;
 		}
 	},
@@ -1626,6 +1650,14 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			return;
 		}
 	},
+	{
+		op::SED,
+		[](cpu& c)
+		{
+			c.d = true;
+			return;
+		}
+	},
 	{
 		op::SEI,
 		[](cpu& c)
@@ -1652,13 +1684,13 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 		[](cpu& c)
 		{
 			u8 temp = c.pull();
-			c.n = (temp & (1 << 7)) != 0;
-			c.v = (temp & (1 << 6)) != 0;
+			c.n_value = temp;
+			c.v_value = u8(temp << 1);
 			c.k = (temp & (1 << 5)) != 0;
 			c.b = (temp & (1 << 4)) != 0;
 			c.d = (temp & (1 << 3)) != 0;
 			c.i = (temp & (1 << 2)) != 0;
-			c.z = (temp & (1 << 1)) != 0;
+			c.set_z((temp & (1 << 1)) != 0);
 			c.c = (temp & (1)) != 0;
 			c.pc = ((c.pull() << BIT_SIZE) | c.pull());
 			return;
@@ -1679,5 +1711,301 @@ std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> cpu::op_map =
 			c.k = true;
 			return;
 		}
+	},
+	{
+		op::HYP,
+		[](cpu& c)
+		{
+			c.hypercall(c.next_byte());
+			return;
+		}
+	}
+};
+#define GET_INDIRECT_ADDR_ZP u8 addr = c.next_byte();
+
+std::unordered_map<u8, op_handler> cpu::cmos_op_map =
+{
+	{
+		op::LDA_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			c.a = c.mem[CONCAT_ADDR];
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::STA_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			c.mem[CONCAT_ADDR] = c.a;
+			return;
+		}
+	},
+	{
+		op::STZ_ZP,
+		[](cpu& c)
+		{
+			c.mem[c.next_byte()] = 0;
+			return;
+		}
+	},
+	{
+		op::STZ_ZP_X,
+		[](cpu& c)
+		{
+			c.mem[u8(c.next_byte() + c.x)] = 0;
+			return;
+		}
+	},
+	{
+		op::STZ_ABS,
+		[](cpu& c)
+		{
+			c.mem[NEXT_WORD] = 0;
+			return;
+		}
+	},
+	{
+		op::STZ_ABS_X,
+		[](cpu& c)
+		{
+			c.mem[u16(NEXT_WORD + c.x)] = 0;
+			return;
+		}
+	},
+	{
+		op::PHX,
+		[](cpu& c)
+		{
+			c.push(c.x);
+			return;
+		}
+	},
+	{
+		op::PHY,
+		[](cpu& c)
+		{
+			c.push(c.y);
+			return;
+		}
+	},
+	{
+		op::PLX,
+		[](cpu& c)
+		{
+			c.x = c.pull();
+			c.set_nz(c.x);
+			return;
+		}
+	},
+	{
+		op::PLY,
+		[](cpu& c)
+		{
+			c.y = c.pull();
+			c.set_nz(c.y);
+			return;
+		}
+	},
+	{
+		op::AND_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			c.a &= c.mem[CONCAT_ADDR];
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::EOR_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			c.a ^= c.mem[CONCAT_ADDR];
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::ORA_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			c.a |= c.mem[CONCAT_ADDR];
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::BIT_IM,
+		[](cpu& c)
+		{
+			c.z_value = c.a & c.next_byte();
+			return;
+		}
+	},
+	{
+		op::BIT_ZP_X,
+		[](cpu& c)
+		{
+			u8 temp = c.mem[u8(c.next_byte() + c.x)];
+			c.z_value = c.a & temp;
+			c.v_value = u8(temp << 1);
+			c.n_value = temp;
+			return;
+		}
+	},
+	{
+		op::BIT_ABS_X,
+		[](cpu& c)
+		{
+			u8 temp = c.mem[u16(NEXT_WORD + c.x)];
+			c.z_value = c.a & temp;
+			c.v_value = u8(temp << 1);
+			c.n_value = temp;
+			return;
+		}
+	},
+	{
+		op::TRB_ZP,
+		[](cpu& c)
+		{
+			u8& addr = c.mem[c.next_byte()];
+			c.z_value = c.a & addr;
+			addr &= ~c.a;
+			return;
+		}
+	},
+	{
+		op::TRB_ABS,
+		[](cpu& c)
+		{
+			u8& addr = c.mem[NEXT_WORD];
+			c.z_value = c.a & addr;
+			addr &= ~c.a;
+			return;
+		}
+	},
+	{
+		op::TSB_ZP,
+		[](cpu& c)
+		{
+			u8& addr = c.mem[c.next_byte()];
+			c.z_value = c.a & addr;
+			addr |= c.a;
+			return;
+		}
+	},
+	{
+		op::TSB_ABS,
+		[](cpu& c)
+		{
+			u8& addr = c.mem[NEXT_WORD];
+			c.z_value = c.a & addr;
+			addr |= c.a;
+			return;
+		}
+	},
+	{
+		op::ADC_IN_ZP,
+		[](cpu& c)
+		{
+			u8 prev_a = c.a;
+			GET_INDIRECT_ADDR_ZP;
+			u8 value = c.mem[CONCAT_ADDR];
+			if (c.d)
+			{
+				add_decimal(c, value);
+				return;
+			}
+			c.a += value + c.c;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = ((u16(prev_a) + value + c.c) & 0xFF00) != 0;
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::SBC_IN_ZP,
+		[](cpu& c)
+		{
+			u8 prev_a = c.a;
+			GET_INDIRECT_ADDR_ZP;
+			u8 value = c.mem[CONCAT_ADDR];
+			if (c.d)
+			{
+				subtract_decimal(c, value);
+				return;
+			}
+			c.a -= value + !c.c;
+			c.v_value = (prev_a ^ c.a) & (value ^ c.a);
+			c.c = !c.get_v();
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::CMP_IN_ZP,
+		[](cpu& c)
+		{
+			GET_INDIRECT_ADDR_ZP;
+			u8 value = c.mem[CONCAT_ADDR];
+			c.c = (c.a >= value);
+			c.set_nz(u8(c.a - value));
+			return;
+		}
+	},
+	{
+		op::INC_A,
+		[](cpu& c)
+		{
+			++c.a;
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::DEC_A,
+		[](cpu& c)
+		{
+			--c.a;
+			c.set_nz(c.a);
+			return;
+		}
+	},
+	{
+		op::JMP_IN_ABS_X,
+		[](cpu& c)
+		{
+			u16 addr = u16(NEXT_WORD + c.x);
+			c.pc = (u16(c.mem[addr]) + (u16(c.mem[u16(addr + 1)]) << BIT_SIZE)) - 1;
+			return;
+		}
+	},
+	{
+		op::BRA,
+		[](cpu& c)
+		{
+			c.pc += i8(c.next_byte()) - 1;
+			return;
+		}
+	},
+	{
+		op::BRK,
+		[](cpu& c)
+		{
+			c.push(c.pc & 0xFF);
+			c.push((c.pc & 0xFF00) >> BIT_SIZE);
+			c.push(PROCESS_STATUS);
+			c.pc = c.mem[0xFFFE];
+			c.pc |= (c.mem[0xFFFF] << BIT_SIZE);
+			c.b = true;
+			c.d = false;
+			return;
+		}
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,166 @@
+// Generated by the static recompiler, see recompiler_6502.h. Don't edit, run "recompile" again.
+#include <cstring>
+
+#include "recompiler_6502.h"
+
+static const u8 range_0200[] =
+{
+	0xA9, 0x00, 0x85, 0x00, 0xA9, 0x01, 0x85, 0x01, 0xA2, 0x02, 0x8A, 0x38, 0xE9, 0x02, 0xA8, 0xB9,
+	0x00, 0x00, 0x85, 0xFF, 0xC8, 0xB9, 0x00, 0x00, 0x18, 0x65, 0xFF, 0x95, 0x00, 0xE8, 0xE0, 0x0C,
+	0xD0, 0xE9, 0xA9, 0x00, 0x85, 0xFF, 0x60,
+};
+
+static const u8 range_FFF6[] =
+{
+	0x20, 0x00, 0x02, 0xFF,
+};
+
+static bool matches(const ram& mem)
+{
+	return std::memcmp(mem.data + 0x0200, range_0200, sizeof(range_0200)) == 0
+		&& std::memcmp(mem.data + 0xFFF6, range_FFF6, sizeof(range_FFF6)) == 0;
+}
+
+static const u8 pages[] = { 0x02, 0xFF };
+
+// cpu::write drops the flag of a page, code after that write may be stale
+static bool code_written(const cpu& c)
+{
+	return !c.code_pages[0x02]
+		|| !c.code_pages[0xFF];
+}
+
+static aot_exit sub_0200(cpu& c, u32 depth);
+static aot_exit sub_FFF6(cpu& c, u32 depth);
+
+static aot_exit sub_0200(cpu& c, u32 depth)
+{
+	if (depth > AOT_MAX_DEPTH)
+	{
+		c.pc = 0x0200;
+		return aot_exit::interpret;
+	}
+	// 0200: A9 00
+	aot_step<0xA9>(c, 0x0000);
+	// 0202: 85 00
+	aot_step<0x85>(c, 0x0000);
+	if (code_written(c))
+	{
+		c.pc = 0x0204;
+		return aot_exit::interpret;
+	}
+	// 0204: A9 01
+	aot_step<0xA9>(c, 0x0001);
+	// 0206: 85 01
+	aot_step<0x85>(c, 0x0001);
+	if (code_written(c))
+	{
+		c.pc = 0x0208;
+		return aot_exit::interpret;
+	}
+	// 0208: A2 02
+	aot_step<0xA2>(c, 0x0002);
+L_020A:
+	// 020A: 8A
+	aot_step<0x8A>(c, 0x0000);
+	// 020B: 38
+	aot_step<0x38>(c, 0x0000);
+	// 020C: E9 02
+	aot_step<0xE9>(c, 0x0002);
+	// 020E: A8
+	aot_step<0xA8>(c, 0x0000);
+	// 020F: B9 00 00
+	aot_step<0xB9>(c, 0x0000);
+	// 0212: 85 FF
+	aot_step<0x85>(c, 0x00FF);
+	if (code_written(c))
+	{
+		c.pc = 0x0214;
+		return aot_exit::interpret;
+	}
+	// 0214: C8
+	aot_step<0xC8>(c, 0x0000);
+	// 0215: B9 00 00
+	aot_step<0xB9>(c, 0x0000);
+	// 0218: 18
+	aot_step<0x18>(c, 0x0000);
+	// 0219: 65 FF
+	aot_step<0x65>(c, 0x00FF);
+	// 021B: 95 00
+	aot_step<0x95>(c, 0x0000);
+	if (code_written(c))
+	{
+		c.pc = 0x021D;
+		return aot_exit::interpret;
+	}
+	// 021D: E8
+	aot_step<0xE8>(c, 0x0000);
+	// 021E: E0 0C
+	aot_step<0xE0>(c, 0x000C);
+	// 0220: D0 E9
+	aot_count(c, op_cycles[0xD0]);
+	if (!c.get_z())
+	{
+		aot_count(c, 1);
+		goto L_020A;
+	}
+	// 0222: A9 00
+	aot_step<0xA9>(c, 0x0000);
+	// 0224: 85 FF
+	aot_step<0x85>(c, 0x00FF);
+	if (code_written(c))
+	{
+		c.pc = 0x0226;
+		return aot_exit::interpret;
+	}
+	// 0226: 60
+	aot_count(c, op_cycles[0x60]);
+	{
+		u16 high = c.pull();
+		c.pc = u16(((high << BIT_SIZE) | c.pull()) + 1);
+	}
+	return aot_exit::returned;
+}
+
+static aot_exit sub_FFF6(cpu& c, u32 depth)
+{
+	if (depth > AOT_MAX_DEPTH)
+	{
+		c.pc = 0xFFF6;
+		return aot_exit::interpret;
+	}
+	// FFF6: 20 00 02
+	aot_count(c, op_cycles[0x20]);
+	c.push(0xF8);
+	c.push(0xFF);
+	if (code_written(c))
+	{
+		c.pc = 0x0200;
+		return aot_exit::interpret;
+	}
+	switch (sub_0200(c, depth + 1))
+	{
+	case aot_exit::returned:
+		if (c.pc != 0xFFF9)
+		{
+			return aot_exit::interpret;
+		}
+		break;
+	case aot_exit::stopped:
+		return aot_exit::stopped;
+	case aot_exit::interpret:
+		return aot_exit::interpret;
+	}
+	// FFF9: FF
+	aot_count(c, op_cycles[0xFF]);
+	c.k = true;
+	c.pc = 0xFFFA;
+	return aot_exit::stopped;
+}
+
+static aot_exit run(cpu& c)
+{
+	return sub_FFF6(c, 0);
+}
+
+extern const aot_program recompiled_program = { 0xFFF6, &run, &matches, pages, u32(sizeof(pages)) };
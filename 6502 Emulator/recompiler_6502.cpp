@@ -0,0 +1,436 @@
+#include <charconv>
+#include <iomanip>
+#include <sstream>
+#include <regex>
+
+#include "recompiler_6502.h"
+#include "compiler_6502.h"
+
+// how an instruction passes control on
+enum struct aot_flow : u8
+{
+	next,		// falls through
+	branch,		// taken target or fall through
+	jump,		// JMP_ABS
+	call,		// JSR_ABS, falls through after callee returns
+	ret,		// RTS
+	stop,		// KIL
+	fallback	// interpreter continues from the instruction
+};
+
+static aot_flow flow_of(u8 code)
+{
+	switch (code)
+	{
+	case op::BCC: case op::BCS: case op::BEQ: case op::BNE:
+	case op::BMI: case op::BPL: case op::BVC: case op::BVS:
+		return aot_flow::branch;
+	case op::JMP_ABS:
+		return aot_flow::jump;
+	case op::JSR_ABS:
+		return aot_flow::call;
+	case op::RTS:
+		return aot_flow::ret;
+	case op::KIL:
+		return aot_flow::stop;
+	case op::JMP_IN: case op::BRK: case op::RTI:
+		return aot_flow::fallback;
+	}
+	return op_entries[code].exec != &cpu::trap_unknown_op ? aot_flow::next : aot_flow::fallback;
+}
+
+// operators that may write into recompiled code
+static bool writes_memory(u8 code)
+{
+	switch (code)
+	{
+	case op::STA_ZP: case op::STA_ZP_X: case op::STA_ABS: case op::STA_ABS_X:
+	case op::STA_ABS_Y: case op::STA_IN_X: case op::STA_IN_Y:
+	case op::STX_ZP: case op::STX_ZP_Y: case op::STX_ABS:
+	case op::STY_ZP: case op::STY_ZP_X: case op::STY_ABS:
+	case op::INC_ZP: case op::INC_ZP_X: case op::INC_ABS: case op::INC_ABS_X:
+	case op::DEC_ZP: case op::DEC_ZP_X: case op::DEC_ABS: case op::DEC_ABS_X:
+	case op::ASL_ZP: case op::ASL_ZP_X: case op::ASL_ABS: case op::ASL_ABS_X:
+	case op::LSR_ZP: case op::LSR_ZP_X: case op::LSR_ABS: case op::LSR_ABS_X:
+	case op::ROL_ZP: case op::ROL_ZP_X: case op::ROL_ABS: case op::ROL_ABS_X:
+	case op::ROR_ZP: case op::ROR_ZP_X: case op::ROR_ABS: case op::ROR_ABS_X:
+	case op::PHA: case op::PHP:
+	case op::HYP:
+		return true;
+	}
+	return false;
+}
+
+static const char* branch_condition(u8 code)
+{
+	switch (code)
+	{
+	case op::BCC: return "!c.c";
+	case op::BCS: return "c.c";
+	case op::BEQ: return "c.get_z()";
+	case op::BNE: return "!c.get_z()";
+	case op::BMI: return "c.get_n()";
+	case op::BPL: return "!c.get_n()";
+	case op::BVC: return "!c.get_v()";
+	case op::BVS: return "c.get_v()";
+	}
+	return "false";
+}
+
+static std::string hex(u32 value, u32 width)
+{
+	std::ostringstream out;
+	out << std::hex << std::uppercase << std::setfill('0') << std::setw(width) << value;
+	return out.str();
+}
+
+void run_recompiled(cpu& cpu_ref, const aot_program& program)
+{
+	if (cpu_ref.pc == program.entry && program.matches(cpu_ref.mem))
+	{
+		// writes into these pages drop the flag, generated code checks it after every write
+		for (u32 i = 0; i < program.page_count; i++)
+		{
+			cpu_ref.code_pages[program.pages[i]] = 1;
+		}
+		if (program.run(cpu_ref) == aot_exit::stopped)
+		{
+			return;
+		}
+	}
+	if (!cpu_ref.k)
+	{
+		cpu_ref.start();
+	}
+}
+
+bool load_image(const std::string& path, ram& mem)
+{
+	if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0)
+	{
+		std::ifstream fin(path, std::ios::binary);
+		if (!fin.is_open())
+		{
+			return false;
+		}
+		mem.clear();
+		fin.read(reinterpret_cast<char*>(mem.data), MAX_RAM_BYTES);
+		mem.mark_dirty(0x00, 0xFF);
+		return true;
+	}
+
+	std::ifstream fin(path);
+	if (!fin.is_open())
+	{
+		return false;
+	}
+	const std::regex byte_line(R"(^\s*0x([0-9a-fA-F]+):\s*([0-9a-fA-F]{1,2})\s*$)");
+	std::smatch byte_match = {};
+	std::string line;
+	bool first = true;
+	u32 program_end = 0x0200;
+	while (std::getline(fin, line))
+	{
+		if (line.empty())
+		{
+			continue;
+		}
+		if (!std::regex_match(line, byte_match, byte_line))
+		{
+			if (!first)
+			{
+				return false;
+			}
+			// not a byte listing, assemble it
+			cpu cpu_tmp(mem);
+			compiler cmplr;
+			return cmplr.compile_and_build(path, cpu_tmp);
+		}
+		if (first)
+		{
+			mem.clear();
+			first = false;
+		}
+		// the byte and the RTS put after the program have to fit below the start-up code
+		std::string digits = byte_match[1].str();
+		u32 addr = 0;
+		auto [ptr, error] = std::from_chars(digits.data(), digits.data() + digits.size(), addr, 16);
+		if (error != std::errc() || addr + 1 >= START_UP_ADDR)
+		{
+			std::cout << "Address of \"" << line << "\" in \"" << path << "\" is past the memory a program can use.\n";
+			return false;
+		}
+		mem[u16(addr)] = u8(std::stoul(byte_match[2].str(), nullptr, 16));
+		mem.mark_dirty(u8(addr >> BIT_SIZE), u8(addr >> BIT_SIZE));
+		program_end = std::max(program_end, addr + 1);
+	}
+	if (first)
+	{
+		return false;
+	}
+	compiler::write_start_up(mem, u16(program_end));
+	return true;
+}
+
+recompiler::recompiler(const ram& image_ref) : image(image_ref) {}
+
+void recompiler::analyze(u16 entry)
+{
+	std::vector<u16> callees = { entry };
+	while (!callees.empty())
+	{
+		u16 sub_entry = callees.back();
+		callees.pop_back();
+		if (subroutines.count(sub_entry) > 0)
+		{
+			continue;
+		}
+		subroutine& sub = subroutines[sub_entry];
+		sub.entry = sub_entry;
+		explore(sub, callees);
+	}
+}
+
+void recompiler::explore(subroutine& sub, std::vector<u16>& callees)
+{
+	std::vector<u16> worklist = { sub.entry };
+	while (!worklist.empty())
+	{
+		u16 addr = worklist.back();
+		worklist.pop_back();
+		if (sub.instructions.count(addr) > 0)
+		{
+			continue;
+		}
+
+		u8 code = image[addr];
+		u8 length = op_entries[code].length;
+		u16 raw = 0;
+		for (u8 i = 1; i < length; i++)
+		{
+			raw |= u16(image[u16(addr + i)]) << ((i - 1) * BIT_SIZE);
+		}
+		sub.instructions[addr] = { addr, code, raw, length };
+		for (u8 i = 0; i < length; i++)
+		{
+			code_bytes[u16(addr + i)] = true;
+		}
+
+		u16 next = u16(addr + length);
+		switch (flow_of(code))
+		{
+		case aot_flow::next:
+		case aot_flow::call:
+			worklist.push_back(next);
+			if (code == op::JSR_ABS)
+			{
+				callees.push_back(raw);
+			}
+			break;
+		case aot_flow::branch:
+			sub.labels.insert(branch_target(addr, raw));
+			worklist.push_back(branch_target(addr, raw));
+			worklist.push_back(next);
+			break;
+		case aot_flow::jump:
+			sub.labels.insert(raw);
+			worklist.push_back(raw);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// fall through into an instruction that isn't emitted right after needs a goto
+	for (auto it = sub.instructions.begin(); it != sub.instructions.end(); it++)
+	{
+		const instruction& ins = it->second;
+		aot_flow flow = flow_of(ins.code);
+		if (flow != aot_flow::next && flow != aot_flow::call && flow != aot_flow::branch)
+		{
+			continue;
+		}
+		u16 next = u16(ins.addr + ins.length);
+		auto following = std::next(it);
+		if (following == sub.instructions.end() || following->first != next)
+		{
+			sub.labels.insert(next);
+		}
+	}
+	if (sub.instructions.begin()->first != sub.entry)
+	{
+		sub.labels.insert(sub.entry);
+	}
+}
+
+bool recompiler::write_cpp(const std::string& path, const std::string& name, u16 entry) const
+{
+	std::ofstream fout(path);
+	if (!fout.is_open() || subroutines.count(entry) == 0)
+	{
+		return false;
+	}
+
+	fout << "// Generated by the static recompiler, see recompiler_6502.h. Don't edit, run \"recompile\" again.\n";
+	fout << "#include <cstring>\n\n#include \"recompiler_6502.h\"\n\n";
+
+	// code bytes in contiguous ranges, compared before running
+	std::vector<std::pair<u16, u32>> ranges;
+	std::set<u8> pages;
+	for (u32 addr = 0; addr < MAX_RAM_BYTES; addr++)
+	{
+		if (!code_bytes[addr])
+		{
+			continue;
+		}
+		pages.insert(u8(addr >> BIT_SIZE));
+		if (!ranges.empty() && ranges.back().first + ranges.back().second == addr)
+		{
+			ranges.back().second++;
+		}
+		else
+		{
+			ranges.push_back({ u16(addr), 1 });
+		}
+	}
+	for (const auto& [begin, size] : ranges)
+	{
+		fout << "static const u8 range_" << hex(begin, 4) << "[] =\n{";
+		for (u32 i = 0; i < size; i++)
+		{
+			fout << (i % 16 == 0 ? "\n\t" : " ") << "0x" << hex(image[begin + i], 2) << ',';
+		}
+		fout << "\n};\n\n";
+	}
+
+	fout << "static bool matches(const ram& mem)\n{\n\treturn";
+	for (u32 i = 0; i < ranges.size(); i++)
+	{
+		fout << (i > 0 ? "\n\t\t&& " : " ") << "std::memcmp(mem.data + 0x" << hex(ranges[i].first, 4)
+			<< ", range_" << hex(ranges[i].first, 4) << ", sizeof(range_" << hex(ranges[i].first, 4) << ")) == 0";
+	}
+	fout << ";\n}\n\n";
+
+	fout << "static const u8 pages[] = {";
+	for (u8 page : pages)
+	{
+		fout << (page != *pages.begin() ? ", " : " ") << "0x" << hex(page, 2);
+	}
+	fout << " };\n\n";
+
+	fout << "// cpu::write drops the flag of a page, code after that write may be stale\n";
+	fout << "static bool code_written(const cpu& c)\n{\n\treturn";
+	for (u8 page : pages)
+	{
+		fout << (page != *pages.begin() ? "\n\t\t|| " : " ") << "!c.code_pages[0x" << hex(page, 2) << ']';
+	}
+	fout << ";\n}\n\n";
+
+	for (const auto& [sub_entry, sub] : subroutines)
+	{
+		fout << "static aot_exit sub_" << hex(sub_entry, 4) << "(cpu& c, u32 depth);\n";
+	}
+	fout << '\n';
+	for (const auto& [sub_entry, sub] : subroutines)
+	{
+		write_subroutine(fout, sub);
+	}
+
+	fout << "static aot_exit run(cpu& c)\n{\n\treturn sub_" << hex(entry, 4) << "(c, 0);\n}\n\n";
+	fout << "extern const aot_program " << name << " = { 0x" << hex(entry, 4) << ", &run, &matches, pages, u32(sizeof(pages)) };\n";
+	fout.close();
+	return true;
+}
+
+void recompiler::write_subroutine(std::ostream& out, const subroutine& sub) const
+{
+	const std::string fall_back_to = "\t{\n\t\tc.pc = 0x";
+
+	out << "static aot_exit sub_" << hex(sub.entry, 4) << "(cpu& c, u32 depth)\n{\n";
+	out << "\tif (depth > AOT_MAX_DEPTH)\n" << fall_back_to << hex(sub.entry, 4) << ";\n\t\treturn aot_exit::interpret;\n\t}\n";
+	if (sub.instructions.begin()->first != sub.entry)
+	{
+		out << "\tgoto L_" << hex(sub.entry, 4) << ";\n";
+	}
+
+	for (auto it = sub.instructions.begin(); it != sub.instructions.end(); it++)
+	{
+		const instruction& ins = it->second;
+		u16 next = u16(ins.addr + ins.length);
+		if (sub.labels.count(ins.addr) > 0)
+		{
+			out << "L_" << hex(ins.addr, 4) << ":\n";
+		}
+
+		std::string bytes = hex(ins.code, 2);
+		for (u8 i = 1; i < ins.length; i++)
+		{
+			bytes += ' ' + hex(u8(ins.raw >> ((i - 1) * BIT_SIZE)), 2);
+		}
+		out << "\t// " << hex(ins.addr, 4) << ": " << bytes << '\n';
+
+		aot_flow flow = flow_of(ins.code);
+		if (flow != aot_flow::next && flow != aot_flow::fallback)
+		{
+			out << "\taot_count(c, op_cycles[0x" << hex(ins.code, 2) << "]);\n";
+		}
+		switch (flow)
+		{
+		case aot_flow::next:
+			out << "\taot_step<0x" << hex(ins.code, 2) << ">(c, 0x" << hex(ins.raw, 4) << ");\n";
+			if (writes_memory(ins.code))
+			{
+				out << "\tif (code_written(c))\n" << fall_back_to << hex(next, 4) << ";\n\t\treturn aot_exit::interpret;\n\t}\n";
+			}
+			if (ins.code == op::PLP)
+			{
+				out << "\tif (c.k)\n" << fall_back_to << hex(next, 4) << ";\n\t\treturn aot_exit::stopped;\n\t}\n";
+			}
+			break;
+		case aot_flow::branch:
+		{
+			// taken: one cycle, one more if the target is on another page than the next operator
+			u16 target = branch_target(ins.addr, ins.raw);
+			u32 taken = 1 + page_crossed(next, target);
+			out << "\tif (" << branch_condition(ins.code) << ")\n\t{\n\t\taot_count(c, " << taken << ");\n\t\tgoto L_" << hex(target, 4) << ";\n\t}\n";
+			break;
+		}
+		case aot_flow::jump:
+			out << "\tgoto L_" << hex(ins.raw, 4) << ";\n";
+			break;
+		case aot_flow::call:
+		{
+			// same pushes as operation::jsr, pc stands at the last byte of JSR
+			u16 ret = u16(ins.addr + 2);
+			out << "\tc.push(0x" << hex(u8(ret), 2) << ");\n";
+			out << "\tc.push(0x" << hex(u8(ret >> BIT_SIZE), 2) << ");\n";
+			out << "\tif (code_written(c))\n" << fall_back_to << hex(ins.raw, 4) << ";\n\t\treturn aot_exit::interpret;\n\t}\n";
+			out << "\tswitch (sub_" << hex(ins.raw, 4) << "(c, depth + 1))\n\t{\n";
+			out << "\tcase aot_exit::returned:\n\t\tif (c.pc != 0x" << hex(next, 4) << ")\n\t\t{\n\t\t\treturn aot_exit::interpret;\n\t\t}\n\t\tbreak;\n";
+			out << "\tcase aot_exit::stopped:\n\t\treturn aot_exit::stopped;\n";
+			out << "\tcase aot_exit::interpret:\n\t\treturn aot_exit::interpret;\n\t}\n";
+			break;
+		}
+		case aot_flow::ret:
+			out << "\t{\n\t\tu16 high = c.pull();\n\t\tc.pc = u16(((high << BIT_SIZE) | c.pull()) + 1);\n\t}\n";
+			out << "\treturn aot_exit::returned;\n";
+			break;
+		case aot_flow::stop:
+			out << "\tc.k = true;\n\tc.pc = 0x" << hex(next, 4) << ";\n\treturn aot_exit::stopped;\n";
+			break;
+		case aot_flow::fallback:
+			out << "\tc.pc = 0x" << hex(ins.addr, 4) << ";\n\treturn aot_exit::interpret;\n";
+			break;
+		}
+
+		if (flow == aot_flow::next || flow == aot_flow::call || flow == aot_flow::branch)
+		{
+			auto following = std::next(it);
+			if (following == sub.instructions.end() || following->first != next)
+			{
+				out << "\tgoto L_" << hex(next, 4) << ";\n";
+			}
+		}
+	}
+	out << "}\n\n";
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "vm_6502.h"
+#include "op_policies_6502.h"
+
+//#define RECOMPILED_6502	// diff recompiled_6502.cpp against the interpreter in main
+
+// Static recompiler: assembled image -> C++ translation unit, one function per subroutine.
+// Control flow graph is recovered from the entry point by following branches, JMP and JSR,
+// every JSR target becomes a subroutine, RTS returns from it.
+// Generated code runs every operator through op_entries with a constant opcode, so it shares semantics with the VM,
+// and falls back to the interpreter (leaves with cpu::pc set) on:
+//   - JMP_IN, BRK, RTI and operators NMOS doesn't know (65C02 ones run in the interpreter of cpu::variant)
+//   - a write into a page holding recompiled code (cpu::write drops the page from cpu::code_pages)
+//   - RTS returning somewhere else than after its JSR
+// Generated code doesn't count operators, it runs until KIL (or k set by PLP) or the fallback.
+// With CYCLES_6502 it counts cycles as the interpreter does: aot_step operators count their own,
+// branches, JMP, JSR, RTS and KIL emitted inline add their base cycles and the taken and page penalties through aot_count.
+
+constexpr u32 AOT_MAX_DEPTH = 1024;	// nested JSR calls, deeper goes to the interpreter
+
+enum struct aot_exit : u8
+{
+	returned,	// RTS, pc is right after JSR
+	stopped,	// k is set
+	interpret	// continue in the interpreter from pc
+};
+
+// what a generated translation unit exports
+struct aot_program
+{
+	u16 entry = 0;							// pc the program starts from
+	aot_exit (*run)(cpu& cpu_ref) = nullptr;
+	bool (*matches)(const ram& mem) = nullptr;	// code bytes are the same as recompiled ones
+	const u8* pages = nullptr;				// pages holding recompiled code
+	u32 page_count = 0;
+};
+
+// one operator with constant opcode, handler is known at compile time and inlined
+template <u8 code>
+inline void aot_step(cpu& c, u16 raw)
+{
+	constexpr decoded_handler handler = op_entries[code].exec_decoded;
+	handler(c, raw);
+}
+
+// cycles of control flow generated code runs itself, nothing without CYCLES_6502
+inline void aot_count(cpu& c, u32 cycles)
+{
+	if constexpr (COUNT_CYCLES)
+	{
+		c.cycles += cycles;
+	}
+}
+
+/// <summary>
+/// Runs 'program' if cpu is at its entry and memory holds the same code, finishes in the interpreter.
+/// Otherwise just runs the interpreter.
+/// </summary>
+void run_recompiled(cpu& cpu_ref, const aot_program& program);
+
+/// <summary>
+/// Loads an image into 'mem':
+///   *.bin - raw memory dump (ram::write_to), program bytes from address 0
+///   text in compiler::write_txt format ("0x200: a9") - bytes at their addresses, plus the same start-up code compile_and_build adds,
+///     fails on an address the program can't use: its byte and the closing RTS have to fit below START_UP_ADDR
+///   any other text is treated as assembly and built with compiler::compile_and_build
+/// </summary>
+bool load_image(const std::string& path, ram& mem);
+
+struct recompiler
+{
+	struct instruction
+	{
+		u16 addr;
+		u8 code;
+		u16 raw;
+		u8 length;
+	};
+
+	struct subroutine
+	{
+		u16 entry;
+		std::map<u16, instruction> instructions = {};	// by address, emitted in this order
+		std::set<u16> labels = {};						// addresses reached by goto
+	};
+
+	const ram& image;
+	std::map<u16, subroutine> subroutines = {};
+	std::vector<bool> code_bytes = std::vector<bool>(MAX_RAM_BYTES, false);
+
+	recompiler(const ram& image_ref);
+
+	// recovers control flow starting from 'entry'
+	void analyze(u16 entry);
+
+	// writes translation unit exporting "const aot_program <name>"
+	bool write_cpp(const std::string& path, const std::string& name, u16 entry) const;
+
+	void explore(subroutine& sub, std::vector<u16>& callees);
+	void write_subroutine(std::ostream& out, const subroutine& sub) const;
+};
+// recompiled_6502.cpp, generated from input.txt by "recompile input.txt recompiled_6502.cpp"
+extern const aot_program recompiled_program;
@@ -0,0 +1,93 @@
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#include "tools_6502.h"
+#include "recompiler_6502.h"
+#include "disasm_6502.h"
+
+// hex address argument, false if 'text' isn't one
+static bool parse_address(const char* text, u32& addr)
+{
+	const char* end = text + strlen(text);
+	auto [ptr, error] = std::from_chars(text, end, addr, 16);
+	return text != end && ptr == end && error == std::errc() && addr < MAX_RAM_BYTES;
+}
+
+static int recompile(int argc, char* argv[])
+{
+	u32 entry = START_UP_ADDR;
+	if (argc < 4 || (argc > 5 && !parse_address(argv[5], entry)))
+	{
+		std::cout << "usage: recompile <image> <out.cpp> [name] [entry]\n";
+		return 1;
+	}
+	std::string name = argc > 4 ? argv[4] : "recompiled_program";
+
+	ram image;
+	if (!load_image(argv[2], image))
+	{
+		std::cout << "Can't load \"" << argv[2] << "\".\n";
+		return 1;
+	}
+
+	recompiler rcmplr(image);
+	rcmplr.analyze(u16(entry));
+	if (!rcmplr.write_cpp(argv[3], name, u16(entry)))
+	{
+		std::cout << "Can't write \"" << argv[3] << "\".\n";
+		return 1;
+	}
+	std::cout << "Recompiled " << rcmplr.subroutines.size() << " subroutines into \"" << argv[3] << "\".\n";
+	return 0;
+}
+
+static int disasm(int argc, char* argv[])
+{
+	u32 from = 0x0000;
+	u32 to = 0xFFFF;
+	if (argc < 3 || (argc > 3 && !parse_address(argv[3], from)) || (argc > 4 && !parse_address(argv[4], to)))
+	{
+		std::cout << "usage: disasm <image> [from] [to] [cmos]\n";
+		return 1;
+	}
+	cpu_variant variant = argc > 5 && std::string(argv[5]) == "cmos" ? cpu_variant::cmos : cpu_variant::nmos;
+	if (from > to)
+	{
+		std::cout << "Range " << std::hex << from << ".." << to << std::dec << " is empty.\n";
+		return 1;
+	}
+
+	ram image;
+	if (!load_image(argv[2], image))
+	{
+		std::cout << "Can't load \"" << argv[2] << "\".\n";
+		return 1;
+	}
+
+	// bytes past 'to' aren't read, an instruction cut there is printed as "???"
+	static char buffer[DISASM_BUFFER_BYTES];
+	for (u32 addr = from; addr <= to;)
+	{
+		u64 consumed = 0;
+		u64 chars = disassemble(image.data + addr, to - addr + 1, u16(addr), buffer, sizeof(buffer), consumed, variant);
+		std::cout.write(buffer, chars);
+		addr += u32(consumed);
+	}
+	return 0;
+}
+
+int run_tool(int argc, char* argv[])
+{
+	std::string tool = argv[1];
+	if (tool == "recompile")
+	{
+		return recompile(argc, argv);
+	}
+	if (tool == "disasm")
+	{
+		return disasm(argc, argv);
+	}
+	std::cout << "Unknown tool \"" << tool << "\", tools: recompile, disasm.\n";
+	return 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+#include "vm_6502.h"
+
+/// <summary>
+/// Command line tools, picked by first argument:
+///   recompile <image> <out.cpp> [name] [entry] - static recompiler, see recompiler_6502.h
+///     name defaults to recompiled_program, entry (hex) defaults to START_UP_ADDR
+///   disasm <image> [from] [to] [cmos] - disassembler to stdout, see disasm_6502.h
+///     from and to (hex, inclusive) default to the whole memory, cmos decodes 65C02 opcodes
+/// Returns process exit code.
+/// </summary>
+int run_tool(int argc, char* argv[]);
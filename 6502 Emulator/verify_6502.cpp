@@ -0,0 +1,1162 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "verify_6502.h"
+#include "op_policies_6502.h"
+#include "fusion_6502.h"
+#include "jit_6502.h"
+#include "recompiler_6502.h"
+#include "compiler_6502.h"
+#include "events_6502.h"
+#include "disasm_6502.h"
+#include "bank_6502.h"
+#include "hypercall_6502.h"
+
+static void randomize(cpu& c, std::mt19937& rng)
+{
+	for (u32 i = 0; i < MAX_RAM_BYTES; i += sizeof(u32))
+	{
+		u32 word = rng();
+		memcpy(c.mem.data + i, &word, sizeof(u32));
+	}
+
+	c.pc = u16(rng());
+	c.sp = u8(rng());
+	c.a = u8(rng());
+	c.x = u8(rng());
+	c.y = u8(rng());
+	restore_status(c, u8(rng()) & ~(1 << 5)); // do not start killed
+}
+
+static void copy_state(const cpu& from, cpu& to)
+{
+	memcpy(to.mem.data, from.mem.data, MAX_RAM_BYTES);
+	to.cycles = from.cycles;
+	to.pc = from.pc;
+	to.sp = from.sp;
+	to.a = from.a;
+	to.x = from.x;
+	to.y = from.y;
+	restore_status(to, process_status(from));
+	to.trap = from.trap;
+	to.trap_pc = from.trap_pc;
+}
+
+// returns name of first differing part of state, or nullptr
+// cycles are compared only when counted, op_map doesn't count them at all
+static const char* compare_state(const cpu& ref, const cpu& gen, bool cycles = COUNT_CYCLES)
+{
+	if (ref.pc != gen.pc)	return "pc";
+	if (ref.sp != gen.sp)	return "sp";
+	if (ref.a != gen.a)		return "a";
+	if (ref.x != gen.x)		return "x";
+	if (ref.y != gen.y)		return "y";
+	if (process_status(ref) != process_status(gen))	return "status";
+	if (ref.trap != gen.trap || ref.trap_pc != gen.trap_pc)	return "trap";
+	if (memcmp(ref.mem.data, gen.mem.data, MAX_RAM_BYTES) != 0)	return "memory";
+	if (cycles && ref.cycles != gen.cycles)	return "cycles";
+	return nullptr;
+}
+
+// published NMOS timings by opcode, 0 - not an official opcode, KIL and HYP are this emulator's own
+static constexpr u8 REFERENCE_CYCLES[OP_TABLE_SIZE] =
+{
+//	0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+	7, 6, 2, 0, 0, 3, 5, 0, 3, 2, 2, 0, 0, 4, 6, 0,	// 0
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,	// 1
+	6, 6, 0, 0, 3, 3, 5, 0, 4, 2, 2, 0, 4, 4, 6, 0,	// 2
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,	// 3
+	6, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 3, 4, 6, 0,	// 4
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,	// 5
+	6, 6, 0, 0, 0, 3, 5, 0, 4, 2, 2, 0, 5, 4, 6, 0,	// 6
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,	// 7
+	0, 6, 0, 0, 3, 3, 3, 0, 2, 0, 2, 0, 4, 4, 4, 0,	// 8
+	2, 6, 0, 0, 4, 4, 4, 0, 2, 5, 2, 0, 0, 5, 0, 0,	// 9
+	2, 6, 2, 0, 3, 3, 3, 0, 2, 2, 2, 0, 4, 4, 4, 0,	// A
+	2, 5, 0, 0, 4, 4, 4, 0, 2, 4, 2, 0, 4, 4, 4, 0,	// B
+	2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,	// C
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,	// D
+	2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,	// E
+	2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 2,	// F
+};
+
+// published 65C02 timings of opcodes it adds, 0 - the NMOS one above (65C02 differences there aren't emulated)
+static constexpr u8 CMOS_REFERENCE_CYCLES[OP_TABLE_SIZE] =
+{
+//	0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+	0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0,	// 0
+	0, 0, 5, 0, 5, 0, 0, 0, 0, 0, 2, 0, 6, 0, 0, 0,	// 1
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 2
+	0, 0, 5, 0, 4, 0, 0, 0, 0, 0, 2, 0, 4, 0, 0, 0,	// 3
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 4
+	0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0,	// 5
+	0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 6
+	0, 0, 5, 0, 4, 0, 0, 0, 0, 0, 4, 0, 6, 0, 0, 0,	// 7
+	2, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0,	// 8
+	0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 0, 5, 0,	// 9
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// A
+	0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// B
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// C
+	0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0,	// D
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// E
+	0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0,	// F
+};
+
+// extra cycles the reference documents for one operator on this state: page crossing of indexed reads, taken branches
+static u32 reference_penalty(const cpu& c)
+{
+	u8 code = c.mem[c.pc];
+	u16 raw = c.mem[u16(c.pc + 1)] | (c.mem[u16(c.pc + 2)] << BIT_SIZE);
+	u8 column = code & 0x0F;
+	bool odd_row = (code & 0x10) != 0;
+
+	if ((column == 0x00 && odd_row) || code == op::BRA)
+	{
+		// branches: bits 7-6 pick n, v, c or z, bit 5 is the value that takes the branch, BRA always takes it
+		static constexpr u8 FLAG_BITS[] = { 0x80, 0x40, 0x01, 0x02 };
+		bool taken = code == op::BRA || ((process_status(c) & FLAG_BITS[code >> 6]) != 0) == ((code & 0x20) != 0);
+		u16 next = u16(c.pc + 2);
+		u16 target = branch_target(c.pc, raw);	// offset is counted from operand byte here
+		return taken ? 1 + ((next >> BIT_SIZE) != (target >> BIT_SIZE)) : 0;
+	}
+
+	u16 base = 0;
+	u8 index = 0;
+	if (code == 0xBE || (odd_row && column == 0x09 && code != 0x99))
+	{
+		base = raw;		// abs,y reads
+		index = c.y;
+	}
+	else if (code == 0xBC || code == 0x3C || (odd_row && column == 0x0D && code != 0x9D))
+	{
+		base = raw;		// abs,x reads
+		index = c.x;
+	}
+	else if (odd_row && column == 0x01 && code != 0x91)
+	{
+		base = c.mem[u8(raw)] | (c.mem[u8(raw + 1)] << BIT_SIZE);	// (zp),y reads
+		index = c.y;
+	}
+	else
+	{
+		return 0;
+	}
+	return ((base ^ u16(base + index)) >> BIT_SIZE) != 0;
+}
+
+static const char* variant_name(cpu_variant variant)
+{
+	return variant == cpu_variant::cmos ? "65C02" : "6502";
+}
+
+// hand written handler of 'code', 65C02 takes the ones it changes from cmos_op_map, nullptr - the variant doesn't have it
+static op_handler reference_op(cpu_variant variant, u8 code)
+{
+	if (variant == cpu_variant::cmos)
+	{
+		auto it = cpu::cmos_op_map.find(code);
+		if (it != cpu::cmos_op_map.end())
+		{
+			return it->second;
+		}
+	}
+	auto it = cpu::op_map.find(code);
+	return it != cpu::op_map.end() ? it->second : nullptr;
+}
+
+bool verify_generated_ops(u32 trials_per_op)
+{
+	std::mt19937 rng(6502);
+	u32 verified = 0;
+	u32 failed = 0;
+
+	std::cout << "\nVerifying generated op_tables against op_map and cmos_op_map, " << trials_per_op << " trials per opcode:\n";
+
+	for (cpu_variant variant : { cpu_variant::nmos, cpu_variant::cmos })
+	{
+		ram ram_ref;
+		ram ram_gen;
+		cpu cpu_ref(ram_ref, variant);
+		cpu cpu_gen(ram_gen, variant);
+
+		for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+		{
+			op_handler ref = reference_op(variant, u8(code));
+			op_handler gen = cpu_gen.op_table[code];
+			const op_entry& entry = cpu_gen.entries[code];
+			bool has_ref = ref != nullptr;
+			bool has_gen = gen != &cpu::trap_unknown_op;
+
+			if (has_gen != (entry.mnemonic != nullptr))
+			{
+				std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << " has " << (has_gen ? "no mnemonic" : "a mnemonic but no handler") << '\n' << std::dec;
+				failed++;
+				continue;
+			}
+
+			if (!has_ref && !has_gen)
+			{
+				continue;
+			}
+			if (has_ref != has_gen)
+			{
+				std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << " is implemented only by " << (has_ref ? "op_map" : "op_table") << '\n' << std::dec;
+				failed++;
+				continue;
+			}
+
+			for (u32 trial = 0; trial < trials_per_op; trial++)
+			{
+				randomize(cpu_ref, rng);
+				cpu_ref.mem[cpu_ref.pc] = u8(code);
+				copy_state(cpu_ref, cpu_gen);
+				u8 status = process_status(cpu_gen);
+
+				ref(cpu_ref);
+				gen(cpu_gen);
+
+				const char* diff = compare_state(cpu_ref, cpu_gen, false);
+				if (diff == nullptr && ((process_status(cpu_gen) ^ status) & ~entry.flags) != 0)
+				{
+					diff = "a status bit op_entries doesn't list";
+				}
+				if (diff != nullptr)
+				{
+					std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << " differs in " << diff << " (trial " << std::dec << trial << ")\n";
+					failed++;
+					break;
+				}
+			}
+			verified++;
+		}
+	}
+
+	std::cout << "Verified " << verified << " opcodes, " << failed << " mismatches.\n";
+	return failed == 0;
+}
+
+// decimal results and carries of NMOS 6502, http://www.6502.org/tutorials/decimal_mode.html (examples and appendix A)
+struct decimal_vector
+{
+	u8 code;
+	u8 carry;
+	u8 a;
+	u8 value;
+	u8 result;
+	u8 carry_out;
+	i8 v = -1;		// -1 - not checked
+};
+
+static const decimal_vector DECIMAL_VECTORS[] =
+{
+	{ op::ADC_IM, 0, 0x12, 0x34, 0x46, 0 },
+	{ op::ADC_IM, 0, 0x15, 0x26, 0x41, 0 },
+	{ op::ADC_IM, 0, 0x81, 0x92, 0x73, 1 },
+	{ op::ADC_IM, 0, 0x58, 0x46, 0x04, 1 },
+	{ op::ADC_IM, 1, 0x58, 0x46, 0x05, 1 },
+	{ op::ADC_IM, 0, 0x99, 0x01, 0x00, 1, 0 },
+	{ op::SBC_IM, 1, 0x46, 0x12, 0x34, 1, 0 },
+	{ op::SBC_IM, 1, 0x40, 0x13, 0x27, 1, 0 },
+	{ op::SBC_IM, 0, 0x32, 0x02, 0x29, 1, 0 },
+	{ op::SBC_IM, 1, 0x12, 0x21, 0x91, 0, 0 },
+	{ op::SBC_IM, 1, 0x21, 0x34, 0x87, 0, 0 },
+	{ op::SBC_IM, 1, 0x30, 0x90, 0x40, 0, 1 },
+	{ op::SBC_IM, 1, 0x01, 0x80, 0x21, 0, 1 },
+	{ op::SBC_IM, 0, 0x00, 0x00, 0x99, 0, 0 }
+};
+
+bool verify_decimal()
+{
+	ram ram_ref;
+	ram ram_gen;
+	cpu cpu_ref(ram_ref);
+	cpu cpu_gen(ram_gen);
+	std::mt19937 rng(6502);
+	u32 failed = 0;
+
+	std::cout << "\nVerifying decimal ADC and SBC tables against op_map, every a, operand and carry:\n";
+
+	randomize(cpu_ref, rng);
+	cpu_ref.d = true;
+	for (u8 code : { op::ADC_IM, op::SBC_IM })
+	{
+		for (u32 i = 0; i < DECIMAL_TABLE_SIZE; i++)
+		{
+			cpu_ref.pc = 0;
+			cpu_ref.mem[0] = code;
+			cpu_ref.mem[1] = u8(i);
+			cpu_ref.a = u8(i >> BIT_SIZE);
+			cpu_ref.c = (i >> (2 * BIT_SIZE)) != 0;
+			copy_state(cpu_ref, cpu_gen);
+
+			cpu::op_map.at(code)(cpu_ref);
+			cpu_gen.op_table[code](cpu_gen);
+
+			if (const char* diff = compare_state(cpu_ref, cpu_gen, false))
+			{
+				std::cout << std::hex << " > opcode " << u32(code) << " differs in " << diff << " (index " << i << ")\n" << std::dec;
+				failed++;
+				break;
+			}
+		}
+	}
+
+	// op_map is no reference for itself, both implementations have to give the published results
+	for (const decimal_vector& vector : DECIMAL_VECTORS)
+	{
+		for (cpu* c : { &cpu_ref, &cpu_gen })
+		{
+			c->pc = 0;
+			c->mem[0] = vector.code;
+			c->mem[1] = vector.value;
+			c->a = vector.a;
+			c->c = vector.carry;
+			if (c == &cpu_ref)
+			{
+				cpu::op_map.at(vector.code)(*c);
+			}
+			else
+			{
+				c->op_table[vector.code](*c);
+			}
+			if (c->a != vector.result || c->c != vector.carry_out || (vector.v >= 0 && c->get_v() != (vector.v != 0)))
+			{
+				std::cout << std::hex << " > " << (c == &cpu_ref ? "op_map" : "op_table") << " opcode " << u32(vector.code) << " of " << u32(vector.a)
+					<< " and " << u32(vector.value) << " with carry " << u32(vector.carry) << " gives " << u32(c->a) << " carry " << u32(c->c) << '\n' << std::dec;
+				failed++;
+			}
+		}
+	}
+
+	std::cout << "Verified " << 2 * DECIMAL_TABLE_SIZE << " operations and " << std::size(DECIMAL_VECTORS) << " published results, " << failed << " mismatches.\n";
+	return failed == 0;
+}
+
+bool verify_cycles(u32 trials_per_op)
+{
+	std::mt19937 rng(6502);
+	u32 verified = 0;
+	u32 failed = 0;
+
+	// without CYCLES_6502 nothing is counted, only base cycles of the table are checked
+	std::cout << "\nVerifying cycles against published timings, " << (COUNT_CYCLES ? trials_per_op : 0) << " trials per opcode:\n";
+
+	for (cpu_variant variant : { cpu_variant::nmos, cpu_variant::cmos })
+	{
+		ram ram_0;
+		cpu cpu_0(ram_0, variant);
+
+		for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+		{
+			if (cpu_0.op_table[code] == &cpu::trap_unknown_op)
+			{
+				continue;
+			}
+			u8 reference = variant == cpu_variant::cmos && CMOS_REFERENCE_CYCLES[code] != 0 ? CMOS_REFERENCE_CYCLES[code] : REFERENCE_CYCLES[code];
+			if (cpu_0.entries[code].cycles != reference)
+			{
+				std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << std::dec << " takes " << u32(cpu_0.entries[code].cycles)
+					<< " base cycles instead of " << u32(reference) << '\n';
+				failed++;
+				continue;
+			}
+
+			for (u32 trial = 0; COUNT_CYCLES && trial < trials_per_op; trial++)
+			{
+				randomize(cpu_0, rng);
+				cpu_0.mem[cpu_0.pc] = u8(code);
+				u64 before = cpu_0.cycles;
+				u32 expected = reference + reference_penalty(cpu_0);
+
+				cpu_0.op_table[code](cpu_0);
+				if (cpu_0.cycles - before != expected)
+				{
+					std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << std::dec << " took " << cpu_0.cycles - before
+						<< " cycles instead of " << expected << " (trial " << trial << ")\n";
+					failed++;
+					break;
+				}
+			}
+			verified++;
+		}
+	}
+
+	std::cout << "Verified " << verified << " opcodes, " << failed << " mismatches.\n";
+	return failed == 0;
+}
+
+bool verify_fused_pairs(u32 trials_per_pair)
+{
+	ram ram_ref;
+	ram ram_gen;
+	cpu cpu_ref(ram_ref);
+	cpu cpu_gen(ram_gen);
+	std::mt19937 rng(6502);
+	u32 failed = 0;
+
+	std::cout << "\nVerifying fused pairs against two op_table steps, " << trials_per_pair << " trials per pair:\n";
+
+	cpu_ref.engine = run_engine::loop;
+	cpu_gen.engine = run_engine::fused;
+	for (const fused_entry& entry : fused_pairs)
+	{
+		for (u32 trial = 0; trial < trials_per_pair; trial++)
+		{
+			randomize(cpu_ref, rng);
+			cpu_ref.mem[cpu_ref.pc] = entry.first;
+			cpu_ref.mem[u16(cpu_ref.pc + op_entries[entry.first].length)] = entry.second;
+			copy_state(cpu_ref, cpu_gen);
+			cpu_gen.flush_decoded();
+
+			cpu_ref.start(2);
+			cpu_gen.start(2);
+
+			if (const char* diff = compare_state(cpu_ref, cpu_gen))
+			{
+				std::cout << std::hex << " > pair " << u16(entry.first) << ' ' << u16(entry.second) << " differs in " << diff << " (trial " << std::dec << trial << ")\n";
+				failed++;
+				break;
+			}
+		}
+	}
+
+	std::cout << "Verified " << fused_pairs.size() << " pairs, " << failed << " mismatches.\n";
+	return failed == 0;
+}
+
+bool verify_jit_blocks(u32 programs, i32 operators)
+{
+	ram ram_ref;
+	ram ram_gen;
+	cpu cpu_ref(ram_ref);
+	cpu cpu_gen(ram_gen);
+	std::mt19937 rng(6502);
+	u32 failed = 0;
+
+	std::cout << "\nVerifying jit blocks on " << programs << " random programs, " << operators << " operators each:\n";
+
+	// random bytes as program, unknown opcodes are replaced so interpreter never traps
+	std::vector<u8> known;
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		if (cpu_ref.op_table[code] != &cpu::trap_unknown_op)
+		{
+			known.push_back(u8(code));
+		}
+	}
+
+	cpu_ref.engine = run_engine::loop;
+	cpu_gen.engine = run_engine::jit;
+	cpu_gen.jit = std::make_unique<jit_cache>();
+	cpu_gen.jit->verify = true;
+	for (u32 program = 0; program < programs; program++)
+	{
+		randomize(cpu_ref, rng);
+		for (u32 i = 0; i < MAX_RAM_BYTES; i++)
+		{
+			if (cpu_ref.op_table[cpu_ref.mem[i]] == &cpu::trap_unknown_op)
+			{
+				cpu_ref.mem[i] = known[rng() % known.size()];
+			}
+		}
+		copy_state(cpu_ref, cpu_gen);
+		cpu_gen.flush_decoded();
+		cpu_gen.jit->flush();
+
+		cpu_ref.start(operators);
+		cpu_gen.start(operators);
+
+		if (const char* diff = compare_state(cpu_ref, cpu_gen))
+		{
+			std::cout << " > program " << program << " differs in " << diff << '\n';
+			failed++;
+		}
+	}
+
+	std::cout << "Verified " << cpu_gen.jit->verified << " blocks, " << cpu_gen.jit->mismatches << " mismatches, "
+		<< failed << " programs differ.\n";
+	failed += cpu_gen.jit->mismatches;
+	return failed == 0;
+}
+
+// the same stop conditions as cpu::run_until, checked before every operator
+static run_exit run_stepping(cpu& c, const run_limits& limits)
+{
+	u64 cycles_end = c.cycles + limits.cycles;
+	for (u64 done = 0;; done++)
+	{
+		if (c.k)
+		{
+			return c.trap != trap_code::none ? run_exit::trap : run_exit::kill;
+		}
+		run_due_events(c);
+		take_interrupt(c);
+		if (done > 0 && std::find(limits.breakpoints.begin(), limits.breakpoints.end(), c.pc) != limits.breakpoints.end())
+		{
+			return run_exit::breakpoint;
+		}
+		if (done == limits.operators || (COUNT_CYCLES && limits.cycles > 0 && c.cycles >= cycles_end))
+		{
+			return run_exit::budget;
+		}
+		c.start_loop(1);
+	}
+}
+
+// device of verify_run_until: toggles its bit of the IRQ line every 'period' cycles
+struct verify_timer
+{
+	u32 bit = 1;
+	u64 period = 0;
+};
+
+static void timer_tick(cpu& c, void* device)
+{
+	verify_timer& timer = *static_cast<verify_timer*>(device);
+	c.irq ^= timer.bit;
+	schedule_event(c, c.cycles + timer.period, &timer_tick, device);
+}
+
+static void raise_nmi(cpu& c, void*)
+{
+	c.nmi = true;
+}
+
+// memory-mapped device of verify_run_until: reads give a running count, writes are hashed, so every access has to happen in order
+struct verify_device
+{
+	u32 reads = 0;
+	u32 hash = 0;
+	bus_device bus = {};
+};
+
+static u8 verify_device_read(void* context, u16 addr)
+{
+	verify_device& device = *static_cast<verify_device*>(context);
+	return u8(addr + device.reads++);
+}
+
+static void verify_device_write(void* context, u16 addr, u8 value)
+{
+	verify_device& device = *static_cast<verify_device*>(context);
+	device.hash = device.hash * 31 + addr + value;
+}
+
+// pages 0x40..0x47 go to 'device' and 0x80..0x87 are read-only, if 'mapped'
+static void map_verify_bus(cpu& c, verify_device& device, bool mapped)
+{
+	device = {};
+	device.bus = { &verify_device_read, &verify_device_write, &device };
+	c.mem.unmap(0x00, 0xFF);
+	if (mapped)
+	{
+		c.mem.map_device(0x40, 0x47, &device.bus);
+		c.mem.map_memory(0x80, 0x87, c.mem.data + 0x8000, false);
+	}
+}
+
+static const std::pair<const char*, run_engine> run_engines[] =
+{
+	{ "loop", run_engine::loop },
+	{ "threaded", run_engine::threaded },
+	{ "predecoded", run_engine::predecoded },
+	{ "fused", run_engine::fused },
+	{ "jit", run_engine::jit },
+	{ "cached", run_engine::cached }
+};
+
+// verify_run_until for one instruction set, returns mismatches
+static u32 verify_run_until_on(cpu_variant variant, u32 programs, i32 operators)
+{
+	ram ram_start;
+	ram ram_first;
+	ram ram_ref;
+	ram ram_gen;
+	cpu cpu_start(ram_start, variant);
+	cpu cpu_first(ram_first, variant);	// after the first stop
+	cpu cpu_ref(ram_ref, variant);
+	cpu cpu_gen(ram_gen, variant);
+	std::mt19937 rng(6502);
+	u32 failed = 0;
+
+	// random bytes as program, unknown opcodes are replaced so programs don't trap in their first operators
+	std::vector<u8> known;
+	std::vector<u8> unknown;
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		(cpu_start.op_table[code] != &cpu::trap_unknown_op ? known : unknown).push_back(u8(code));
+	}
+
+	cpu_gen.memoize = true;
+	for (u32 program = 0; program < programs; program++)
+	{
+		// with cycles counted, half of the programs run with a timer on the IRQ line and one NMI
+		bool devices = COUNT_CYCLES && program % 4 >= 2;
+
+		randomize(cpu_start, rng);
+		for (u32 i = 0; i < MAX_RAM_BYTES; i++)
+		{
+			while (cpu_start.op_table[cpu_start.mem[i]] == &cpu::trap_unknown_op)
+			{
+				cpu_start.mem[i] = known[rng() % known.size()];
+			}
+		}
+
+		// every fifth program runs with mapped pages, the rest on plain memory
+		bool mapped = program % 5 == 1;
+		verify_device device_ref;
+		verify_device device_gen;
+
+		// breakpoints are taken from addresses the program really runs, budgets are random
+		std::vector<u16> visited;
+		map_verify_bus(cpu_ref, device_ref, mapped);
+		copy_state(cpu_start, cpu_ref);
+		for (i32 i = 0; i < operators && !cpu_ref.k; i++)
+		{
+			visited.push_back(cpu_ref.pc);
+			cpu_ref.start_loop(1);
+		}
+		run_limits limits;
+		limits.operators = rng() % operators + 1;
+		limits.cycles = program % 2 ? rng() % (operators * MAX_OPERATOR_CYCLES) + 1 : 0;
+		for (u32 i = program % 3; i > 0; i--)
+		{
+			limits.breakpoints.push_back(visited[rng() % visited.size()]);
+		}
+		// every fifth program traps on an unknown opcode put where it runs
+		if (program % 5 == 4 && !unknown.empty())
+		{
+			cpu_start.mem[visited[rng() % visited.size()]] = unknown[rng() % unknown.size()];
+		}
+
+		verify_timer timer{ 1, rng() % 2000 + 50 };
+		u64 nmi_at = rng() % (operators * MAX_OPERATOR_CYCLES);
+		auto prepare = [&](cpu& c, verify_device& device)
+			{
+				c.reset();
+				map_verify_bus(c, device, mapped);
+				copy_state(cpu_start, c);
+				if (devices)
+				{
+					schedule_event(c, c.cycles + timer.period, &timer_tick, &timer);
+					schedule_event(c, c.cycles + nmi_at, &raise_nmi);
+				}
+			};
+
+		// stops twice, the second run resumes from where the first one stopped
+		run_exit expected[2];
+		prepare(cpu_ref, device_ref);
+		expected[0] = run_stepping(cpu_ref, limits);
+		copy_state(cpu_ref, cpu_first);
+		expected[1] = run_stepping(cpu_ref, limits);
+
+		for (const auto& [name, engine] : run_engines)
+		{
+			prepare(cpu_gen, device_gen);
+			cpu_gen.engine = engine;
+			cpu_gen.flush_decoded();
+			for (u32 run = 0; run < 2; run++)
+			{
+				run_exit exit = cpu_gen.run_until(limits);
+				const char* diff = compare_state(run == 0 ? cpu_first : cpu_ref, cpu_gen);
+				if (diff == nullptr && exit != expected[run])
+				{
+					diff = "exit reason";
+				}
+				// the device has seen both runs of the reference by the second comparison
+				if (diff == nullptr && run == 1 && (device_gen.reads != device_ref.reads || device_gen.hash != device_ref.hash))
+				{
+					diff = "device accesses";
+				}
+				if (diff != nullptr)
+				{
+					std::cout << " > " << variant_name(variant) << " program " << program << " on " << name << " differs in " << diff << " after run " << run << '\n';
+					failed++;
+					break;
+				}
+			}
+		}
+	}
+
+	return failed;
+}
+
+// verify_run_until for the operators clearing i: a masked IRQ is taken right after one, whether it starts the slice
+// or follows a NOP inside it, before the NOP after it, returns mismatches
+static u32 verify_masked_irq(cpu_variant variant)
+{
+	u32 failed = 0;
+	for (u16 at : { 0x0200, 0x0201 })
+	{
+		for (u8 code : { op::CLI, op::PLP, op::RTI })
+		{
+			for (const auto& [name, engine] : run_engines)
+			{
+				ram ram_0;
+				cpu cpu_0(ram_0, variant);
+				cpu_0.engine = engine;
+				cpu_0.pc = 0x0200;
+				cpu_0.mem[0x0200] = op::NOP;
+				cpu_0.mem[0x0201] = op::NOP;
+				cpu_0.mem[0x0202] = op::NOP;
+				cpu_0.mem[at] = code;
+				cpu_0.mem[0x0300] = op::NOP;
+				cpu_0.mem[IRQ_VECTOR + 1] = 0x03;
+				// PLP and RTI pull status with i clear, RTI returns to 0x0200
+				cpu_0.sp = 0xFC;
+				cpu_0.mem[0x01FF] = 0x02;
+				cpu_0.i = true;
+				cpu_0.irq = 1;
+
+				run_limits limits;
+				limits.operators = at - 0x0200 + 2;
+				if (cpu_0.run_until(limits) != run_exit::budget || cpu_0.pc != 0x0301 || !cpu_0.i)
+				{
+					std::cout << " > " << variant_name(variant) << " IRQ isn't taken right after opcode " << std::hex << u32(code) << " at " << at << std::dec << " on " << name << '\n';
+					failed++;
+				}
+			}
+		}
+	}
+	return failed;
+}
+
+bool verify_run_until(u32 programs, i32 operators)
+{
+	std::cout << "\nVerifying run_until against stepping on " << programs << " random programs per cpu_variant, up to " << operators << " operators each:\n";
+
+	u32 failed = verify_run_until_on(cpu_variant::nmos, programs, operators) + verify_run_until_on(cpu_variant::cmos, programs, operators);
+	failed += verify_masked_irq(cpu_variant::nmos) + verify_masked_irq(cpu_variant::cmos);
+
+	std::cout << "Verified " << programs << " programs per cpu_variant on " << std::size(run_engines) << " engines, " << failed << " mismatches.\n";
+	return failed == 0;
+}
+
+bool verify_recompiled(const std::string& path, const aot_program& program)
+{
+	ram ram_ref;
+	ram ram_gen;
+	cpu cpu_ref(ram_ref);
+	cpu cpu_gen(ram_gen);
+	compiler cmplr;
+
+	std::cout << "\nVerifying recompiled \"" << path << "\":\n";
+	if (!cmplr.compile_and_build(path, cpu_ref))
+	{
+		return false;
+	}
+	copy_state(cpu_ref, cpu_gen);
+	if (cpu_gen.pc != program.entry || !program.matches(cpu_gen.mem))
+	{
+		std::cout << " > image differs from recompiled one, recompile it again\n";
+		return false;
+	}
+
+	cpu_ref.start();
+	run_recompiled(cpu_gen, program);
+
+	const char* diff = compare_state(cpu_ref, cpu_gen);
+	if (diff != nullptr)
+	{
+		std::cout << " > recompiled program differs in " << diff << '\n';
+		return false;
+	}
+	std::cout << "Recompiled program agrees with the interpreter.\n";
+	return true;
+}
+
+bool verify_disassembler()
+{
+	const char* path = "disasm_verify.txt";
+	u32 failed = 0;
+
+	std::cout << "\nVerifying disassembler against op_entries and the assembler:\n";
+	for (cpu_variant variant : { cpu_variant::nmos, cpu_variant::cmos })
+	{
+		ram ram_0;
+		cpu cpu_0(ram_0, variant);
+		std::vector<u8> expected;
+		std::string source;
+
+		// every opcode alone, then the same bytes as one stream
+		std::vector<u8> stream;
+		std::string lines;
+		for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+		{
+			const op_entry& entry = cpu_0.entries[code];
+			const u8 bytes[3] = { u8(code), 0x34, 0x12 };
+			char line[DISASM_MAX_LINE];
+			disasm_line decoded = disassemble_line(bytes, sizeof(bytes), u16(0x0200 + stream.size()), line, variant);
+			std::string_view text(line + DISASM_TEXT_COLUMN, decoded.chars - DISASM_TEXT_COLUMN);
+			u32 length = entry.mnemonic != nullptr ? entry.length : 1;
+			std::string_view mnemonic = entry.mnemonic != nullptr ? entry.mnemonic : "???";
+			if (decoded.bytes != length || decoded.chars != strlen(line) || !text.starts_with(mnemonic))
+			{
+				std::cout << std::hex << " > " << variant_name(variant) << " opcode " << code << " disassembles as \"" << line << "\"\n" << std::dec;
+				failed++;
+				continue;
+			}
+			stream.insert(stream.end(), bytes, bytes + length);
+			lines.append(line, decoded.chars).push_back('\n');
+
+			// branch prints its target and BRK isn't written by the assembler, the rest goes back through it
+			if (entry.mnemonic != nullptr && entry.mode != op_mode::rel && code != op::BRK)
+			{
+				source.append(text).push_back('\n');
+				expected.insert(expected.end(), bytes, bytes + length);
+			}
+		}
+
+		std::string bulk(stream.size() * DISASM_MAX_LINE, 0);
+		u64 consumed = 0;
+		u64 chars = disassemble(stream.data(), stream.size(), 0x0200, bulk.data(), bulk.size(), consumed, variant);
+		bulk.resize(chars);
+		if (consumed != stream.size() || bulk != lines)
+		{
+			std::cout << " > " << variant_name(variant) << " stream disassembles differently from single lines\n";
+			failed++;
+		}
+
+		std::ofstream(path) << source;
+		compiler cmplr;
+		if (!cmplr.compile_and_build(path, cpu_0) || memcmp(ram_0.data + 0x0200, expected.data(), expected.size()) != 0)
+		{
+			std::cout << " > " << variant_name(variant) << " disassembly doesn't assemble back into the same bytes\n";
+			failed++;
+		}
+	}
+
+	// an NMOS build takes only what its op_entries define
+	for (const char* line : { "STZ $10", "LDA ($10)" })
+	{
+		ram ram_0;
+		cpu cpu_0(ram_0);
+		std::ofstream(path) << line << '\n';
+		if (compiler().compile_and_build(path, cpu_0))
+		{
+			std::cout << " > NMOS 6502 build accepts \"" << line << "\"\n";
+			failed++;
+		}
+	}
+	std::remove(path);
+
+	if (failed == 0)
+	{
+		std::cout << "Every opcode disassembles as op_entries describe it and assembles back, NMOS builds refuse 65C02 operators.\n";
+	}
+	return failed == 0;
+}
+
+bool verify_banks(const std::string& path)
+{
+	u32 failed = 0;
+
+	std::cout << "\nVerifying bank switching (\"" << path << "\") on every engine:\n";
+	for (const auto& [name, engine] : run_engines)
+	{
+		ram ram_0;
+		cpu cpu_0(ram_0);
+		compiler cmplr;
+		if (!cmplr.compile_and_build(path, cpu_0))
+		{
+			return false;
+		}
+		std::vector<u8> image(ram_0.data, ram_0.data + MAX_RAM_BYTES);
+
+		const char* diff = nullptr;
+		{
+			bank_window window(ram_0, 0x80, 0xBF, BANK_MAX_COUNT, 0xDF);
+			cpu_0.engine = engine;
+			cpu_0.reset();
+			cpu_0.start();
+
+			// every bank got its number at both ends, the program read them back through the window and the register
+			for (u32 bank = 0; bank < BANK_MAX_COUNT && diff == nullptr; bank++)
+			{
+				const u8* bytes = window.bank(bank);
+				if (bytes[bank] != bank || bytes[window.bank_bytes() - 1] != bank || ram_0[u16(0x0300 + bank)] != bank)
+				{
+					diff = "bank contents";
+				}
+			}
+			if (diff == nullptr && (ram_0[0x20] != 0 || ram_0[0x21] != BANK_MAX_COUNT - 1 || window.selected != BANK_MAX_COUNT - 1))
+			{
+				diff = "register";
+			}
+			// the window never wrote its own bytes in 'data'
+			if (diff == nullptr && !std::equal(ram_0.data + 0x8000, ram_0.data + 0xC000, image.begin() + 0x8000))
+			{
+				diff = "memory under the window";
+			}
+			window.select(BANK_MAX_COUNT + 3);
+			if (diff == nullptr && (window.selected != 3 || ram_0.read(0x8003) != 3 || ram_0.read(0xDF00) != 3))
+			{
+				diff = "bank wrapping";
+			}
+		}
+		if (diff == nullptr && !ram_0.plain())
+		{
+			diff = "pages left mapped";
+		}
+		if (diff != nullptr)
+		{
+			std::cout << " > " << name << " differs in " << diff << '\n';
+			failed++;
+		}
+	}
+
+	if (failed == 0)
+	{
+		std::cout << "Every engine sees the selected bank through the window.\n";
+	}
+	return failed == 0;
+}
+
+bool verify_shared_image(const std::string& path)
+{
+	ram ram_0;
+	cpu cpu_0(ram_0);
+	compiler cmplr;
+	u32 failed = 0;
+
+	std::cout << "\nVerifying instances sharing a ram_image of \"" << path << "\" on every engine:\n";
+	if (!cmplr.compile_and_build(path, cpu_0))
+	{
+		return false;
+	}
+	ram_image image(ram_0);
+	std::vector<u8> built(ram_0.data, ram_0.data + MAX_RAM_BYTES);
+	cpu_0.start();
+	if (!image.available())
+	{
+		std::cout << " > no shared section, instances run on private copies\n";
+	}
+
+	// every instance runs while the others are alive, each has to end as the private run did
+	std::vector<std::unique_ptr<ram>> instances;
+	for (const auto& [name, engine] : run_engines)
+	{
+		instances.push_back(std::make_unique<ram>(image));
+		cpu cpu_1(*instances.back());
+		cpu_1.engine = engine;
+		cpu_1.start();
+		if (memcmp(ram_0.data, instances.back()->data, MAX_RAM_BYTES) != 0)
+		{
+			std::cout << " > " << name << " instance differs from a private run\n";
+			failed++;
+		}
+	}
+
+	// writes stayed in the instances
+	ram fresh(image);
+	if (memcmp(fresh.data, built.data(), MAX_RAM_BYTES) != 0)
+	{
+		std::cout << " > image changed under its instances\n";
+		failed++;
+	}
+
+	if (failed == 0)
+	{
+		std::cout << "Every instance ends as a private run and leaves the image as it was.\n";
+	}
+	return failed == 0;
+}
+
+// every page that differs from 'base' is marked in 'mem'
+static bool dirty_covers(const ram& mem, const ram& base)
+{
+	for (u32 page = 0; page < RAM_PAGE_COUNT; page++)
+	{
+		if (!mem.dirty_pages[page] && memcmp(mem.data + page * RAM_PAGE_SIZE, base.data + page * RAM_PAGE_SIZE, RAM_PAGE_SIZE) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool verify_dirty_pages(const std::string& path, u32 programs, i32 operators)
+{
+	ram ram_start;
+	ram ram_gen;
+	cpu cpu_start(ram_start);
+	cpu cpu_gen(ram_gen);
+	compiler cmplr;
+	std::mt19937 rng(6502);
+	u32 failed = 0;
+
+	std::cout << "\nVerifying dirty pages on \"" << path << "\" and " << programs << " random programs on every engine:\n";
+	std::vector<u8> known;
+	for (u32 code = 0; code < OP_TABLE_SIZE; code++)
+	{
+		if (cpu_start.op_table[code] != &cpu::trap_unknown_op)
+		{
+			known.push_back(u8(code));
+		}
+	}
+
+	// the built program first, its loops run as idioms, then random bytes
+	cpu_gen.memoize = true;
+	for (u32 program = 0; program <= programs; program++)
+	{
+		if (program == 0)
+		{
+			if (!cmplr.compile_and_build(path, cpu_start))
+			{
+				return false;
+			}
+			cpu_start.reset();
+		}
+		else
+		{
+			randomize(cpu_start, rng);
+			for (u32 i = 0; i < MAX_RAM_BYTES; i++)
+			{
+				if (cpu_start.op_table[cpu_start.mem[i]] == &cpu::trap_unknown_op)
+				{
+					cpu_start.mem[i] = known[rng() % known.size()];
+				}
+			}
+		}
+
+		for (const auto& [name, engine] : run_engines)
+		{
+			cpu_gen.reset();
+			copy_state(cpu_start, cpu_gen);
+			ram_gen.clean();
+			cpu_gen.engine = engine;
+			cpu_gen.flush_decoded();
+			cpu_gen.start(program == 0 ? 0x7FFFFFFF : operators);
+
+			const char* diff = nullptr;
+			if (!dirty_covers(ram_gen, ram_start))
+			{
+				diff = "pages written but not dirty";
+			}
+			ram_gen.restore(ram_start);
+			if (diff == nullptr && memcmp(ram_gen.data, ram_start.data, MAX_RAM_BYTES) != 0)
+			{
+				diff = "memory after restore";
+			}
+			if (diff != nullptr)
+			{
+				std::cout << " > program " << program << " on " << name << " differs in " << diff << '\n';
+				failed++;
+			}
+		}
+	}
+
+	// clear zeros only dirty pages, building again after a run has to give what a fresh ram gets (a compiler builds once)
+	ram ram_fresh;
+	cpu cpu_fresh(ram_fresh);
+	compiler cmplr_fresh;
+	bool built = cmplr_fresh.compile_and_build(path, cpu_fresh);
+	for (const auto& [name, engine] : run_engines)
+	{
+		compiler cmplr_run;
+		compiler cmplr_again;
+		built = built && cmplr_run.compile_and_build(path, cpu_gen);
+		cpu_gen.engine = engine;
+		cpu_gen.reset();
+		cpu_gen.start();
+		built = built && cmplr_again.compile_and_build(path, cpu_gen);
+		if (!built || memcmp(ram_gen.data, ram_fresh.data, MAX_RAM_BYTES) != 0)
+		{
+			std::cout << " > building after a run on " << name << " leaves bytes of the run\n";
+			failed++;
+		}
+	}
+
+	// stores to a bank window and its register don't reach 'data', their pages stay clean
+	ram ram_banked;
+	cpu cpu_banked(ram_banked);
+	{
+		bank_window window(ram_banked, 0x80, 0x8F, 4, 0x90);
+		ram_banked.clean();
+		cpu_banked.write(0x8000, 0x55);
+		cpu_banked.write(0x9000, 1);
+		cpu_banked.write(0x0300, 0x55);
+		if (ram_banked.dirty_pages[0x80] || ram_banked.dirty_pages[0x90] || !ram_banked.dirty_pages[0x03])
+		{
+			std::cout << " > stores to a bank window mark its pages of data dirty\n";
+			failed++;
+		}
+	}
+
+	if (failed == 0)
+	{
+		std::cout << "Every page a program wrote is dirty, restore and clear bring memory back.\n";
+	}
+	return failed == 0;
+}
+
+// runs HYP load of 'guest_path' on 'c', returns bytes read or -1 if it set carry
+static i32 hypercall_load(cpu& c, const std::string& guest_path)
+{
+	for (size_t i = 0; i <= guest_path.size(); i++)
+	{
+		c.mem[0x0300 + i] = i < guest_path.size() ? u8(guest_path[i]) : 0;
+	}
+	set_hypercall_word(c, 0, 0x0300);
+	set_hypercall_word(c, 2, 0x0400);
+	set_hypercall_word(c, 4, 0x0100);
+	c.hypercall(u8(hypercall_service::load));
+	return c.c ? -1 : hypercall_word(c, 6);
+}
+
+bool verify_file_hypercalls()
+{
+	namespace fs = std::filesystem;
+	std::cout << "\nVerifying file hypercalls stay inside their root:\n";
+
+	std::error_code error;
+	fs::path dir = fs::temp_directory_path(error) / "verify_6502_hypercalls";
+	fs::remove_all(dir, error);
+	fs::create_directories(dir / "root", error);
+	std::ofstream(dir / "root" / "inside.bin", std::ios::binary) << "inside";
+	std::ofstream(dir / "outside.bin", std::ios::binary) << "outside";
+
+	ram ram_0;
+	cpu cpu_0(ram_0);
+	register_file_hypercalls(cpu_0, (dir / "root").string());
+
+	// by guest path, bytes the load has to read, -1 - carry
+	std::vector<std::pair<std::string, i32>> loads =
+	{
+		{ "inside.bin", 6 },
+		{ "../outside.bin", -1 },
+		{ "missing.bin", -1 }
+	};
+	fs::create_symlink("inside.bin", dir / "root" / "inner", error);
+	bool links = !error;
+	fs::create_symlink("../outside.bin", dir / "root" / "escape", error);
+	links = links && !error;
+	fs::create_directory_symlink("..", dir / "root" / "up", error);
+	links = links && !error;
+	if (links)
+	{
+		loads.insert(loads.end(), { { "inner", 6 }, { "escape", -1 }, { "up/outside.bin", -1 }, { "up/root/inside.bin", 6 } });
+	}
+	else
+	{
+		std::cout << "Can't create symbolic links here, only lexical paths are checked.\n";
+	}
+
+	u32 failed = 0;
+	for (const auto& [guest_path, expected] : loads)
+	{
+		i32 read = hypercall_load(cpu_0, guest_path);
+		if (read != expected)
+		{
+			std::cout << " > loading \"" << guest_path << "\" reads " << read << " bytes instead of " << expected << '\n';
+			failed++;
+		}
+	}
+	fs::remove_all(dir, error);
+
+	std::cout << "Verified " << loads.size() << " paths, " << failed << " mismatches.\n";
+	return failed == 0;
+}
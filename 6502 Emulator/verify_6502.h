@@ -0,0 +1,104 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include "vm_6502.h"
+
+struct aot_program;
+
+//#define VERIFY_6502
+
+constexpr u32 VERIFY_TRIALS_PER_OP = 256;
+constexpr u32 VERIFY_TRIALS_PER_PAIR = 256;
+constexpr u32 VERIFY_JIT_PROGRAMS = 64;
+constexpr i32 VERIFY_JIT_OPERATORS = 10'000;
+constexpr u32 VERIFY_RUN_PROGRAMS = 64;
+
+/// <summary>
+/// Runs every opcode of both cpu_variant tables from generated cpu::op_tables and from reference cpu::op_map
+/// (with cpu::cmos_op_map for 65C02) on the same random cpu state and random memory, compares registers, flags and whole memory,
+/// and checks that op_entries names every opcode it implements and lists every status bit it changes.
+/// Returns true if both tables agree on every opcode.
+/// </summary>
+bool verify_generated_ops(u32 trials_per_op = VERIFY_TRIALS_PER_OP);
+
+/// <summary>
+/// Runs decimal ADC and SBC from generated cpu::op_table and from reference cpu::op_map
+/// for every accumulator, operand and carry, compares registers, flags and whole memory.
+/// Then runs results and carries published for NMOS 6502 (decimal_mode.html) through both.
+/// Returns true if the tables agree with op_map everywhere and both give the published results.
+/// </summary>
+bool verify_decimal();
+
+/// <summary>
+/// Compares base cycles of every opcode of both cpu_variant tables to published timings and, with CYCLES_6502, cycles counted by op_table
+/// on random cpu state and random memory to the timings with page crossing and taken branch penalties.
+/// Returns true if every opcode agrees.
+/// </summary>
+bool verify_cycles(u32 trials_per_op = VERIFY_TRIALS_PER_OP);
+
+/// <summary>
+/// Runs every fused pair from fused_pairs as one record and as two op_table steps
+/// on the same random cpu state and random memory, compares registers, flags and whole memory.
+/// Returns true if both agree on every pair.
+/// </summary>
+bool verify_fused_pairs(u32 trials_per_pair = VERIFY_TRIALS_PER_PAIR);
+
+/// <summary>
+/// Runs random programs on random cpu state with cpu::start_loop and with the jit,
+/// every block the jit emits is checked by jit_cache::verify_block before it runs, final states are compared too.
+/// Returns true if nothing differs.
+/// </summary>
+bool verify_jit_blocks(u32 programs = VERIFY_JIT_PROGRAMS, i32 operators = VERIFY_JIT_OPERATORS);
+
+/// <summary>
+/// Runs random programs with random operator and cycle budgets and breakpoints the program reaches
+/// (and, with CYCLES_6502, a timer on the IRQ line and an NMI) through cpu::run_until on every engine and cpu_variant, twice in a row,
+/// and by checking every stop condition, event and interrupt before each operator.
+/// Some programs run with a memory-mapped device and read-only pages (see ram), the device has to see the same accesses.
+/// Returns true if exit reasons, final states and device accesses agree.
+/// </summary>
+bool verify_run_until(u32 programs = VERIFY_RUN_PROGRAMS, i32 operators = VERIFY_JIT_OPERATORS);
+
+/// <summary>
+/// Builds 'path' into two cpus, runs one with cpu::start and the other through run_recompiled with 'program',
+/// compares registers, flags and whole memory.
+/// Returns true if both agree.
+/// </summary>
+bool verify_recompiled(const std::string& path, const aot_program& program);
+
+/// <summary>
+/// Disassembles every opcode of both cpu_variant tables alone and as one stream, checks lengths and mnemonics against op_entries,
+/// then assembles the lines (branches and BRK aside) back and compares the bytes, and checks that NMOS builds refuse 65C02 operators.
+/// Returns true if all agree.
+/// </summary>
+bool verify_disassembler();
+
+/// <summary>
+/// Runs 'path' (bank.txt) with a bank_window on every engine: it writes every bank through the window and reads them back,
+/// checks the store, what the program read, the register, that memory under the window is untouched and that pages are given back.
+/// Returns true if every engine agrees.
+/// </summary>
+bool verify_banks(const std::string& path);
+
+/// <summary>
+/// Builds 'path' (input.txt) into a ram_image and runs one instance of it per engine, all alive at once,
+/// compares each with a run on private memory, then checks a new instance still starts as the image.
+/// Returns true if all agree.
+/// </summary>
+bool verify_shared_image(const std::string& path);
+
+/// <summary>
+/// Runs 'path' (idiom.txt) and random programs on every engine from a clean ram, checks that every page which changed
+/// is in ram::dirty_pages and that ram::restore brings back the start, then that a build after a run clears what the run wrote
+/// and that bank window stores leave their pages clean.
+/// Returns true if nothing is missed.
+/// </summary>
+bool verify_dirty_pages(const std::string& path, u32 programs = VERIFY_RUN_PROGRAMS, i32 operators = VERIFY_JIT_OPERATORS);
+
+/// <summary>
+/// Loads files through HYP load from a temporary root: plain and linked paths inside it have to load, '..' and symbolic links
+/// leading out of it (to a file or through a linked directory) have to set carry. Links are skipped where they can't be created.
+/// Returns true if every path is treated as expected.
+/// </summary>
+bool verify_file_hypercalls();
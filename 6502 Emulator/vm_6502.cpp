@@ -1,42 +1,239 @@
+#include <algorithm>
+
 #include "vm_6502.h"
+#include "op_policies_6502.h"
+#include "jit_6502.h"
+#include "memo_6502.h"
+#include "events_6502.h"
+#include "disasm_6502.h"
+
+#ifndef _WIN32
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const std::array<op_handler, OP_TABLE_SIZE> cpu::op_tables[CPU_VARIANT_COUNT] = { make_op_table<cpu_variant::nmos>(), make_op_table<cpu_variant::cmos>() };
+
+#ifndef _WIN32
+// anonymous file for a ram_image: memfd on Linux, a temporary file unlinked right away elsewhere or if memfd fails
+static int image_file()
+{
+#ifdef __linux__
+	int memfd = memfd_create("ram_image", 0);
+	if (memfd >= 0)
+	{
+		return memfd;
+	}
+#endif
+	char path[] = "/tmp/ram_image_XXXXXX";
+	int file = mkstemp(path);
+	if (file >= 0)
+	{
+		unlink(path);
+	}
+	return file;
+}
+#endif
+
+ram_image::ram_image(const ram& source)
+{
+#ifdef _WIN32
+	section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, MAX_RAM_BYTES, nullptr);
+	void* view = section != nullptr ? MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, MAX_RAM_BYTES) : nullptr;
+	if (view != nullptr)
+	{
+		memcpy(view, source.data, MAX_RAM_BYTES);
+		UnmapViewOfFile(view);
+	}
+	else if (section != nullptr)
+	{
+		CloseHandle(section);
+		section = nullptr;
+	}
+#else
+	section = image_file();
+	if (section >= 0 && write(section, source.data, MAX_RAM_BYTES) != MAX_RAM_BYTES)
+	{
+		close(section);
+		section = -1;
+	}
+#endif
+	if (!available())
+	{
+		copy.assign(source.data, source.data + MAX_RAM_BYTES);
+	}
+}
+
+ram_image::~ram_image()
+{
+	if (!available())
+	{
+		return;
+	}
+#ifdef _WIN32
+	CloseHandle(section);
+#else
+	close(section);
+#endif
+}
+
+bool ram_image::available() const
+{
+#ifdef _WIN32
+	return section != nullptr;
+#else
+	return section >= 0;
+#endif
+}
+
+// private copy-on-write view of 'image', nullptr if it can't be mapped
+static u8* map_image(const ram_image& image)
+{
+	if (!image.available())
+	{
+		return nullptr;
+	}
+#ifdef _WIN32
+	return (u8*)MapViewOfFile(image.section, FILE_MAP_COPY, 0, 0, MAX_RAM_BYTES);
+#else
+	void* view = mmap(nullptr, MAX_RAM_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE, image.section, 0);
+	return view != MAP_FAILED ? (u8*)view : nullptr;
+#endif
+}
 
-ram::ram()
+ram::ram() : data(new u8[MAX_RAM_BYTES])
 {
 	clear();
+	unmap(0x00, 0xFF);
+}
+
+ram::ram(const ram_image& image) : data(map_image(image)), shared(data != nullptr)
+{
+	if (!shared)
+	{
+		data = new u8[MAX_RAM_BYTES];
+		memcpy(data, image.copy.data(), MAX_RAM_BYTES);
+	}
+	unmap(0x00, 0xFF);
 }
 
 ram::~ram()
 {
-	delete data;
+	if (!shared)
+	{
+		delete[] data;
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, MAX_RAM_BYTES);
+#endif
 }
 
 void ram::clear()
 {
-	memset(data, 0, MAX_RAM_BYTES);
+	if (!zero_base)
+	{
+		memset(data, 0, MAX_RAM_BYTES);
+	}
+	else
+	{
+		for (u32 page = 0; page < RAM_PAGE_COUNT; page++)
+		{
+			if (dirty_pages[page])
+			{
+				memset(data + page * RAM_PAGE_SIZE, 0, RAM_PAGE_SIZE);
+			}
+		}
+	}
+	clean();
+	zero_base = true;
+}
+
+void ram::restore(const ram& base)
+{
+	for (u32 page = 0; page < RAM_PAGE_COUNT; page++)
+	{
+		if (dirty_pages[page])
+		{
+			memcpy(data + page * RAM_PAGE_SIZE, base.data + page * RAM_PAGE_SIZE, RAM_PAGE_SIZE);
+		}
+	}
+	clean();
+}
+
+void ram::clean()
+{
+	dirty_pages = {};
+	zero_base = false;
+}
+
+void ram::mark_dirty(u8 first, u8 last)
+{
+	for (u32 page = first; page <= last; page++)
+	{
+		dirty_pages[page] = 1;
+	}
+}
+
+u32 ram::dirty_count() const
+{
+	return u32(std::count_if(dirty_pages.begin(), dirty_pages.end(), [](u8 dirty) { return dirty != 0; }));
+}
+
+u8 ram::read_device(u16 addr) const
+{
+	const bus_device* device = devices[addr >> BIT_SIZE];
+	return device != nullptr && device->read != nullptr ? device->read(device->context, addr) : 0;
 }
 
-u8 ram::operator[](u32 idx) const
+void ram::write_device(u16 addr, u8 value)
 {
-	if (idx >= MAX_RAM_BYTES)
+	const bus_device* device = devices[addr >> BIT_SIZE];
+	if (device != nullptr && device->write != nullptr)
 	{
-		std::cerr << "Memory accessed out of bounds." << '\n';
-		system("pause");
-		return data[MAX_RAM_BYTES - 1];
+		device->write(device->context, addr, value);
 	}
+}
 
-	return data[idx];
+// page doesn't point at its own bytes in 'data' for reads or writes
+static u32 page_mapped(const ram& mem, u32 page)
+{
+	u8* own = mem.data + page * RAM_PAGE_SIZE;
+	return mem.read_pages[page] != own || mem.write_pages[page] != own;
 }
 
-u8& ram::operator[](u32 idx)
+// mapped_pages is kept by the pages that change, so remapping a range costs its pages only (see bank_window)
+void ram::map_device(u8 first, u8 last, const bus_device* device)
 {
-	if (idx >= MAX_RAM_BYTES)
+	for (u32 page = first; page <= last; page++)
 	{
-		std::cerr << "Memory accessed out of bounds." << '\n';
-		system("pause");
-		return data[MAX_RAM_BYTES - 1];
+		mapped_pages -= page_mapped(*this, page);
+		read_pages[page] = nullptr;
+		write_pages[page] = nullptr;
+		devices[page] = device;
+		mapped_pages += page_mapped(*this, page);
 	}
+}
 
-	return data[idx];
+void ram::map_memory(u8 first, u8 last, u8* memory, bool writable)
+{
+	u8* own = data + first * RAM_PAGE_SIZE;
+	for (u32 page = first; page <= last; page++, memory += RAM_PAGE_SIZE, own += RAM_PAGE_SIZE)
+	{
+		u8* writes = writable ? memory : nullptr;
+		mapped_pages += u32(memory != own || writes != own) - u32(read_pages[page] != own || write_pages[page] != own);
+		read_pages[page] = memory;
+		write_pages[page] = writes;
+		devices[page] = nullptr;
+	}
+}
+
+void ram::unmap(u8 first, u8 last)
+{
+	map_memory(first, last, data + first * RAM_PAGE_SIZE);
 }
 
 void ram::write_to(const std::string& path)
@@ -49,28 +246,46 @@ void ram::write_to(const std::string& path)
 	fout.close();
 }
 
-cpu::cpu(ram& mem_ref) : mem(mem_ref)
+cpu::cpu(ram& mem_ref, cpu_variant variant_ref) :
+	mem(mem_ref),
+	variant(variant_ref),
+	op_table(op_tables[u8(variant_ref)].data()),
+	entries(variant_ref == cpu_variant::cmos ? variant_op_entries<cpu_variant::cmos>.data() : op_entries.data())
 {
 	reset();
 }
 
+cpu::~cpu() = default;
+
 void cpu::reset()
 {
-	pc = u16(0xFFFC);
+	pc = START_UP_ADDR;
 	sp = u8(0xFF);
 
 	a = u8(0);
 	x = u8(0);
 	y = u8(0);
 
-	c = false;
-	z = false;
+	c = 0;
+	set_z(false);
 	i = false;
 	d = false;
 	b = false;
-	v = false;
-	n = false;
+	set_v(false);
+	set_n(false);
 	k = false;
+
+	cycles = 0;
+	trap = trap_code::none;
+	trap_pc = 0;
+
+	irq = 0;
+	nmi = false;
+	if (events)
+	{
+		events->heap.clear();
+	}
+	next_event = NO_EVENT;
 }
 
 u8 cpu::next_byte()
@@ -80,33 +295,198 @@ u8 cpu::next_byte()
 
 void cpu::push(u8 bt)
 {
-	mem[u16(0x0100) + (sp--)] = bt;
+	write(u16(0x0100 + sp--), bt);
 }
 
 u8 cpu::pull()
 {
-	return mem[u16(0x0100) + (++sp)];
+	return mem.read(u16(0x0100 + (++sp)));
 }
 
+#ifdef DEBUG_6502
+// prints instruction at pc before it runs
+static void trace_op(const cpu& c)
+{
+	char line[DISASM_MAX_LINE];
+	disassemble_line(c.mem.data + c.pc, MAX_RAM_BYTES - c.pc, c.pc, line, c.variant);
+	std::cout << "executing " << line << '\n';
+}
+#endif //DEBUG_6502
+
 void cpu::exe_op(u8 op)
 {
 #ifdef DEBUG_6502
-	std::cout << std::hex << "executing " << u16(op) << '\n';
+	trace_op(*this);
 #endif //DEBUG_6502
-	if (op_map.find(op) == op_map.end())
+	op_table[op](*this);
+}
+
+void cpu::trap_unknown_op(cpu& cpu_ref)
+{
+	// stops every engine the same way KIL does, the host reads the fault from trap
+	cpu_ref.k = true;
+	cpu_ref.trap = trap_code::unknown_op;
+	cpu_ref.trap_pc = cpu_ref.pc;
+}
+
+void cpu::hypercall(u8 service)
+{
+	if (hypercalls[service] == nullptr)
 	{
-		std::cerr << std::hex << "Unknown operator \'" << u16(op) << "\' at \'" << pc << "\'\n";
-		system("pause");
+		c = 1;
 		return;
 	}
-	op_map.at(op)(*this);
+	hypercalls[service](*this);
+}
+
+i32 cpu::start(i32 operators)
+{
+	// engines without records can't see breakpoints without a check per operator
+	if (!break_at.empty() && (engine == run_engine::loop || engine == run_engine::threaded || engine == run_engine::cached))
+	{
+		return start_predecoded(operators, false);
+	}
+	// compiled code loads and stores into mem.data
+	if (!mem.plain() && engine == run_engine::jit)
+	{
+		return start_predecoded(operators, false);
+	}
+
+	switch (engine)
+	{
+	case run_engine::threaded:
+		return start_threaded(operators);
+	case run_engine::predecoded:
+		return start_predecoded(operators, false);
+	case run_engine::fused:
+		return start_predecoded(operators, true);
+	case run_engine::jit:
+		return start_jit(operators);
+	case run_engine::cached:
+		return start_cached(operators);
+	default:
+		return start_loop(operators);
+	}
 }
 
-void cpu::start(i32 operators)
+i32 cpu::start_loop(i32 operators)
 {
+	// the variant's table is loaded once per run, not through this on every operator
+	const op_handler* table = op_table;
 	for (u8 op = mem[pc]; operators > 0 && !k; op = next_byte(), operators--)
 	{
-		exe_op(op);
+#ifdef DEBUG_6502
+		trace_op(*this);
+#endif //DEBUG_6502
+		table[op](*this);
+	}
+	return operators;
+}
+
+i32 cpu::start_masked(i32 operators)
+{
+	const op_handler* table = op_table;
+	for (u8 op = mem[pc]; operators > 0 && !k; op = next_byte(), operators--)
+	{
+		table[op](*this);
+		// pc is on the last byte of the operator, the next one starts after it
+		if (!i || at_breakpoint(u16(pc + 1)))
+		{
+			next_byte();
+			return operators - 1;
+		}
+	}
+	return operators;
+}
+
+run_exit cpu::run_until(const run_limits& limits)
+{
+	set_breakpoints(limits.breakpoints);
+
+	bool count_cycles = COUNT_CYCLES && limits.cycles > 0;
+	u64 cycles_end = cycles + limits.cycles;
+	u64 operators = limits.operators;
+	bool started = false;
+	for (;;)
+	{
+		if (k)
+		{
+			return trap != trap_code::none ? run_exit::trap : run_exit::kill;
+		}
+		if (cycles >= next_event)
+		{
+			run_due_events(*this);
+		}
+		if (nmi || irq != 0)
+		{
+			take_interrupt(*this);
+		}
+		// engines stop before a breakpoint but run it first thing, a slice boundary may fall right on it
+		if (started && at_breakpoint(pc))
+		{
+			return run_exit::breakpoint;
+		}
+		if (limits.stop != nullptr && limits.stop->load(std::memory_order_relaxed))
+		{
+			return run_exit::stopped;
+		}
+		if (operators == 0 || (count_cycles && cycles >= cycles_end))
+		{
+			return run_exit::budget;
+		}
+
+		// no operator takes more than MAX_OPERATOR_CYCLES, so only the last one of a slice may pass the cycle budget
+		u64 slice = std::min<u64>(operators, RUN_SLICE_OPERATORS);
+		if (count_cycles)
+		{
+			slice = std::clamp<u64>((cycles_end - cycles) / MAX_OPERATOR_CYCLES, 1, slice);
+		}
+		if (COUNT_CYCLES && next_event != NO_EVENT)
+		{
+			slice = std::clamp<u64>((next_event - cycles) / MAX_OPERATOR_CYCLES, 1, slice);
+		}
+		// IRQ waiting on i is taken right after the operator that clears it, wherever it falls in the slice
+		operators -= slice - (irq != 0 ? start_masked(i32(slice)) : start(i32(slice)));
+		started = true;
+	}
+}
+
+void cpu::set_breakpoints(const std::vector<u16>& addrs)
+{
+	if (addrs == breakpoints)
+	{
+		return;
+	}
+
+	breakpoints = addrs;
+	break_at.clear();
+	if (!addrs.empty())
+	{
+		break_at.resize(MAX_RAM_BYTES);
+		for (u16 addr : addrs)
+		{
+			break_at[addr] = true;
+		}
+	}
+	flush_decoded();
+}
+
+bool cpu::breaks_within(u16 first, u16 last) const
+{
+	if (break_at.empty())
+	{
+		return false;
+	}
+	for (u16 addr = first;; addr++)
+	{
+		if (break_at[addr])
+		{
+			return true;
+		}
+		if (addr == last)
+		{
+			return false;
+		}
 	}
 }
 
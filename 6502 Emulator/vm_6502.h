@@ -1,21 +1,26 @@
 #pragma once
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <map>
 #include <unordered_map>
 #include <functional>
+#include <array>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <Windows.h>
 
 //#define DEBUG_6502
+//#define CYCLES_6502	// count clock cycles in cpu::cycles, see op_policies_6502.h
+//#define CMOS_6502		// main runs input.txt on 65C02, see cpu_variant
 
 // http://www.6502.org/users/obelisk/6502/index.html
 // http://www.6502.org/source/
 // https://skilldrick.github.io/easy6502/
 
 // There are "set to" and "set if", which logically different, but now done as the same.
-// Decimal mode is depricated:
-//   1. CLD and SED are removed
-//   2. ADC and SBC are always in binary
+// Decimal mode: CLD and SED switch it, ADC and SBC take d into account as NMOS 6502 does, see decimal_6502.h
 
 using u8	= unsigned char;
 using u16	= unsigned short;
@@ -28,20 +33,283 @@ using i64	= long long;
 
 constexpr u32 BIT_SIZE = 8;
 constexpr u32 MAX_RAM_BYTES = 65'536;
+constexpr u32 OP_TABLE_SIZE = 256;
+constexpr u32 RAM_PAGE_SIZE = 256;
+constexpr u32 RAM_PAGE_COUNT = MAX_RAM_BYTES / RAM_PAGE_SIZE;
+constexpr u32 CACHED_SYNC_INTERVAL = 4096;	// operators between budget checks of cpu::start_cached
+constexpr u32 IDIOM_KIND_COUNT = 5;			// idiom_kind values, see idiom_6502.h
+constexpr u32 HYPERCALL_COUNT = 256;		// services HYP can call, its operand is one byte
+constexpr u8 HYPERCALL_BLOCK = 0xF0;		// default zero page parameter block of hypercalls
+constexpr u32 RUN_SLICE_OPERATORS = 4096;	// operators between stop checks of cpu::run_until
+constexpr u32 MAX_OPERATOR_CYCLES = 7;		// longest operator with every penalty (BRK, read-modify-write abs,X)
+constexpr u16 NMI_VECTOR = 0xFFFA;
+constexpr u16 RESET_VECTOR = 0xFFFC;
+constexpr u16 IRQ_VECTOR = 0xFFFE;			// shared with BRK
+constexpr u16 START_UP_ADDR = 0xFFF6;		// cpu::reset pc, compiler's start-up code sits right below the vectors
+constexpr u32 INTERRUPT_CYCLES = 7;
+constexpr u64 NO_EVENT = ~u64(0);			// cpu::next_event when nothing is scheduled
+constexpr u32 CPU_VARIANT_COUNT = 2;		// cpu_variant values
+
+// cycle counting is chosen at compile time, without it no handler touches cpu::cycles
+#ifdef CYCLES_6502
+constexpr bool COUNT_CYCLES = true;
+#else
+constexpr bool COUNT_CYCLES = false;
+#endif
+
+struct cpu;
+struct ram;
+template <typename cpu_t> struct basic_op_entry;
+struct jit_cache;
+struct memo_cache;
+struct event_scheduler;
+
+// computed goto is a GCC/Clang extension, MSVC builds fall back to the loop
+#if defined(__GNUC__) || defined(__clang__)
+#define THREADED_6502
+#endif
+
+enum struct run_engine : u8
+{
+	loop,		// one shared dispatch in cpu::start_loop
+	threaded,	// every handler jumps straight to the next one, see vm_threaded_6502.cpp
+	predecoded,	// runs from decoded records, see vm_predecoded_6502.cpp
+	fused,		// predecoded, common instruction pairs run as one record, see fusion_6502.h
+	jit,		// basic blocks compiled to x86-64, see jit_6502.h
+	cached		// registers live in host registers between sync points, see vm_cached_6502.cpp
+};
+
+// Instruction set, chosen when cpu is constructed together with its dispatch table and op_entries.
+// Engines that inline handlers per opcode (threaded, cached, memoized calls) are instantiated for both and pick one per run.
+// 65C02 only adds opcodes NMOS leaves unused, so NMOS code runs the same on both, and BRK and interrupts clear d on it.
+// Not emulated: Rockwell/WDC bit instructions (RMB, SMB, BBR, BBS - 0xFF is KIL here), WAI, STP,
+// 65C02 timing of NMOS opcodes and its decimal mode flags, both variants do these as NMOS does.
+enum struct cpu_variant : u8
+{
+	nmos,	// 6502
+	cmos	// 65C02
+};
+
+// plain function pointer, so one dispatch is one indirect call
+using op_handler = void(*)(cpu& cpu_ref);
+// same handler, but operand is already fetched
+using decoded_handler = void(*)(cpu& cpu_ref, u16 operand);
+
+// instrumentation called at sync points of cpu::start_cached, registers in cpu are current and may be changed
+using sync_hook = void(*)(cpu& cpu_ref);
+
+// host service called by HYP, arguments in a, x, y and the parameter block at cpu::hypercall_block, see hypercall_6502.h
+using hypercall_handler = void(*)(cpu& cpu_ref);
+
+// why cpu::run_until returned
+enum struct run_exit : u8
+{
+	budget,		// operator or cycle budget is used up
+	kill,		// KIL ran (cpu::k), pc is after it
+	breakpoint,	// pc is at one of run_limits::breakpoints, its instruction hasn't run
+	trap,		// a fault stopped the cpu, cpu::trap says which, pc is after the faulting operator
+	stopped		// host set run_limits::stop
+};
+
+// fault that stopped the cpu, kept in cpu::trap until reset
+enum struct trap_code : u8
+{
+	none,
+	unknown_op	// opcode without handler ran, it is at cpu::trap_pc
+};
+
+// stop conditions of cpu::run_until
+struct run_limits
+{
+	u64 operators = ~u64(0);					// operator budget
+	u64 cycles = 0;								// cycle budget, 0 - none, ignored without CYCLES_6502
+	std::vector<u16> breakpoints = {};			// target pcs, run_until stops before running them (except at the pc it starts from)
+	const std::atomic<bool>* stop = nullptr;	// host stop flag, may be set from another thread
+};
+
+// record that may run more than its own instruction: a recognized loop from its head or a memoized call
+enum struct head_kind : u8
+{
+	none,
+	idle,		// see idle_6502.h
+	idiom,		// see idiom_6502.h
+	call,		// JSR, see memo_6502.h
+	breakpoint	// stops the predecoded engine unless it is the first record of the run, see cpu::run_until
+};
+
+// addressing mode of an opcode, see op_entry::mode
+enum struct op_mode : u8
+{
+	imp,	// implied, or x, y, sp as operand
+	acc,	// accumulator
+	im,		// immediate
+	zp,		// zero page
+	zp_x,	// zero page, x
+	zp_y,	// zero page, y
+	abs,	// absolute
+	abs_x,	// absolute, x
+	abs_y,	// absolute, y
+	in,		// indirect, only JMP
+	in_zp,	// indirect zero page, 65C02
+	in_abs_x,	// indirect absolute, x, only JMP on 65C02
+	in_x,	// indirect, x
+	in_y,	// indirect, y
+	rel		// relative, only branches
+};
+
+// status bits as PHP pushes them
+namespace flag_bit
+{
+	constexpr u8 n = 0x80;
+	constexpr u8 v = 0x40;
+	constexpr u8 k = 0x20;
+	constexpr u8 b = 0x10;
+	constexpr u8 d = 0x08;
+	constexpr u8 i = 0x04;
+	constexpr u8 z = 0x02;
+	constexpr u8 c = 0x01;
+	constexpr u8 all = 0xFF;
+}
+
+// instruction decoded once by address
+struct decoded_op
+{
+	decoded_handler handler = nullptr;	// nullptr - not decoded yet
+	u16 operand = 0;					// raw operand bytes (immediate value, address or offset)
+	u8 length = 0;						// opcode + operand bytes
+	u8 operators = 1;					// 2 for fused pair
+	head_kind head = head_kind::none;
+};
 
+// memory-mapped device, see ram::map_device, callbacks get the full address and run on the thread running the cpu
+struct bus_device
+{
+	u8 (*read)(void* context, u16 addr) = nullptr;				// nullptr - reads give 0
+	void (*write)(void* context, u16 addr, u8 value) = nullptr;	// nullptr - writes are dropped
+	void* context = nullptr;
+};
+
+// Base image many instances of one program start from, the bytes of a ram in memory the OS can map copy-on-write.
+// A ram made from it maps a private view: reads share the image's physical memory, the first write to an OS page
+// (4K on x86 and x64, 16 ram pages) gives that instance its own copy of the page. An instance costs the pages it writes
+// (zero page, stack, data) and code and constant tables stay shared. Every access still goes to ram::data,
+// fetches, pointers, jit and host code included, the OS copies behind them.
+// ram::clear writes every byte and copies every page, instances are made again from the image instead.
+// Views outlive the image, it may go once the instances are made.
+struct ram_image
+{
+#ifdef _WIN32
+	HANDLE section = nullptr;	// pagefile-backed file mapping
+#else
+	int section = -1;			// memfd, or an unlinked temporary file where there is none
+#endif
+	std::vector<u8> copy = {};	// the bytes, kept only if the OS gave no section
+
+	// copies 'source' data into the image
+	explicit ram_image(const ram& source);
+
+	~ram_image();
+
+	ram_image(const ram_image&) = delete;
+	ram_image& operator = (const ram_image&) = delete;
+
+	// false if the OS gave no section, instances get a private copy of 'copy' then
+	bool available() const;
+};
+
+// Whole 64K address space, indexed by u16 so no access can leave it and none is checked.
+// Host code indexes 'data' directly. A running program reads and writes operands through the page table (read, write):
+// a memory page is a pointer, so the access is one table load and one indexed load or store,
+// a device page has no pointer and calls its bus_device. Every page points at its own bytes in 'data' until it is mapped.
+// Instruction fetches, zero page pointers, JMP (ind) targets, vectors and hypercall buffers are read from 'data',
+// so code and pointers stay in pages that aren't mapped elsewhere.
+// Jit code, idioms, skipped idle loops and memoized calls work on 'data' too, they step aside while any page is mapped (plain is false).
+// Dirty pages: every store of a running program into 'data' (write, jit code, idioms) marks its page in dirty_pages,
+// stores to devices and to memory mapped over a page (bank windows, host buffers) leave it as it is,
+// the pages that aren't marked still hold the base - zeros after clear, 'base' after restore, the bytes at the time of clean.
+// clear and restore rewrite only marked pages, snapshot and diff code can skip the rest.
+// Host code writing 'data' or operator [] directly isn't seen, it marks the pages itself or calls clean afterwards.
 struct ram
 {
-	u8* data = new u8[MAX_RAM_BYTES];
+	u8* data = nullptr;
+	bool shared = false;	// 'data' is a copy-on-write view of a ram_image, false after ram(image) - the view failed, 'data' is a private copy
+	bool zero_base = false;	// pages not in dirty_pages are zeros
+
+	std::array<u8*, RAM_PAGE_COUNT> read_pages = {};			// bytes of each page for reads, nullptr - device page
+	std::array<u8*, RAM_PAGE_COUNT> write_pages = {};			// for writes, nullptr - device page or read-only memory
+	std::array<const bus_device*, RAM_PAGE_COUNT> devices = {};	// of pages without a pointer
+	u32 mapped_pages = RAM_PAGE_COUNT;							// pages not pointing at their own bytes in 'data' for reads and writes
+	std::array<u8, RAM_PAGE_COUNT> dirty_pages = {};				// not 0 - page written since the base was set
 
+	// zeros
 	ram();
 
+	// starts as 'image', shares its pages until they are written, 'shared' tells whether it could
+	explicit ram(const ram_image& image);
+
 	~ram();
 
+	ram(const ram&) = delete;
+	ram& operator = (const ram&) = delete;
+
+	// zeros, only the dirty pages when the base is zeros already
 	void clear();
 
-	u8 operator [] (u32 idx) const;
+	// back to 'base', which this ram held when its own base was set: copies the dirty pages of 'base'.
+	// Decoded code of a cpu isn't told, flush it if the program wrote code
+	void restore(const ram& base);
+
+	// current bytes are the base, no page is dirty
+	void clean();
+
+	// host code wrote pages 'first'..'last'
+	void mark_dirty(u8 first, u8 last);
+
+	u32 dirty_count() const;
+
+	u8 operator [] (u16 addr) const { return data[addr]; }
+
+	u8& operator [] (u16 addr) { return data[addr]; }
+
+	// no page is mapped, 'data' is what the program sees
+	bool plain() const { return mapped_pages == 0; }
+
+	u8 read(u16 addr) const
+	{
+		const u8* page = read_pages[addr >> BIT_SIZE];
+		return page != nullptr ? page[addr & 0xFF] : read_device(addr);
+	}
+
+	void write(u16 addr, u8 value)
+	{
+		u8* page = write_pages[addr >> BIT_SIZE];
+		if (page == data + (addr & 0xFF00))
+		{
+			dirty_pages[addr >> BIT_SIZE] = 1;
+			page[addr & 0xFF] = value;
+		}
+		else if (page != nullptr)
+		{
+			page[addr & 0xFF] = value;
+		}
+		else
+		{
+			write_device(addr, value);
+		}
+	}
 
-	u8& operator [] (u32 idx);
+	u8 read_device(u16 addr) const;
+
+	void write_device(u16 addr, u8 value);
+
+	// pages 'first'..'last' call 'device', which must outlive the mapping
+	void map_device(u8 first, u8 last, const bus_device* device);
+
+	// pages 'first'..'last' read (and write, if 'writable') RAM_PAGE_SIZE bytes each of 'memory' (ROM image, buffer of the host)
+	void map_memory(u8 first, u8 last, u8* memory, bool writable = true);
+
+	// pages 'first'..'last' go back to their own bytes in 'data'
+	void unmap(u8 first, u8 last);
 
 	void write_to(const std::string& path);
 };
@@ -49,7 +317,13 @@ struct ram
 struct cpu
 {
 	ram& mem;	// attached ram
-	static std::unordered_map<u8, std::function<void(cpu& cpu_ref)>> op_map;	// operations ap
+	static std::unordered_map<u8, op_handler> op_map;		// reference operations map, hand written in ops_6502.cpp
+	static std::unordered_map<u8, op_handler> cmos_op_map;	// reference of opcodes 65C02 adds or changes, the rest are in op_map
+	static const std::array<op_handler, OP_TABLE_SIZE> op_tables[CPU_VARIANT_COUNT];	// dense dispatch tables by cpu_variant, generated in op_policies_6502.h
+
+	const cpu_variant variant;
+	const op_handler* const op_table;				// op_tables[variant], indexed by opcode
+	const basic_op_entry<cpu>* const entries;		// op_entries of variant, see op_policies_6502.h
 
 	u16 pc;		// program counter
 	u8 sp;		// stack pointer
@@ -57,25 +331,91 @@ struct cpu
 	u8 a;		// accumulator register
 	u8 x, y;	// x and y registers
 
-	u8 c : 1;	// carry flag
-	u8 z : 1;	// zero flag
+	// Lazy flags: handlers store the last result as a whole byte, z, n and v are derived only when read
+	// (branches, process_status for PHP/BRK, host code), so there is no bitfield read-modify-write per operator.
+	u8 c;		// carry flag, 0 or 1
+	u8 z_value;	// zero flag is set if z_value == 0
+	u8 n_value;	// negative flag is bit 7 of n_value
+	u8 v_value;	// overflow flag is bit 7 of v_value
+
 	u8 i : 1;	// interrupt disable flag
 	u8 d : 1;	// decimal mode flag
 	u8 b : 1;	// break command flag
-	u8 v : 1;	// overflow flag
-	u8 n : 1;	// negative flag
 	u8 k : 1;	// kill flag - unofficial
 
-	cpu(ram& mem_ref);
+	u64 cycles = 0;	// clock cycles since reset, counted only with CYCLES_6502
+	trap_code trap = trap_code::none;	// k was set by a fault, not by KIL
+	u16 trap_pc = 0;					// address of the faulting operator
+
+	run_engine engine = run_engine::loop;	// selected by host, results are identical for every engine
+
+	std::vector<decoded_op> decoded = {};				// by address, allocated by first predecoded run
+	std::array<u8, RAM_PAGE_COUNT> code_pages = {};		// not 0 - page holds decoded records or compiled blocks, read by jit code too
+	std::unique_ptr<jit_cache> jit;						// allocated by first jit run, see jit_6502.h
+	bool decoded_fused = false;							// records were decoded with fusion
+	bool skip_idle = true;								// predecoded engines fast-forward idle loops, call flush_decoded after changing
+	bool run_idioms = true;								// predecoded engines run copy/fill/multiply/divide loops natively, call flush_decoded after changing
+	std::array<u64, IDIOM_KIND_COUNT> idiom_runs = {};	// loops taken over by native code, by idiom_kind
+	bool memoize = false;								// predecoded engines replay calls of pure subroutines, call flush_decoded after changing
+	std::unique_ptr<memo_cache> memo;					// allocated by first memoized call, see memo_6502.h
+
+	// sync points of run_engine::cached: exit, trap, and every budget check (each 'sync_interval' operators)
+	// if 'observer' is set or a sync was requested, other engines keep registers in cpu all the time
+	sync_hook observer = nullptr;
+	u32 sync_interval = CACHED_SYNC_INTERVAL;
+	std::atomic<bool> sync_requested = false;
+
+	std::array<hypercall_handler, HYPERCALL_COUNT> hypercalls = {};	// by service number, nullptr - HYP only sets carry
+	u8 hypercall_block = HYPERCALL_BLOCK;							// zero page address of hypercall parameter block
+	std::string hypercall_root;										// host directory of file services, empty - they only set carry
+
+	u32 irq = 0;								// IRQ line, bit per device holding it, see events_6502.h
+	bool nmi = false;							// NMI edge raised by a device, cleared when taken
+	std::unique_ptr<event_scheduler> events;	// allocated by first schedule_event, see events_6502.h
+	u64 next_event = NO_EVENT;					// cycle of the earliest scheduled event
+
+	std::vector<u16> breakpoints = {};	// set by set_breakpoints
+	std::vector<u8> break_at = {};		// by address, not 0 - breakpoint, empty if there are none
+
+	cpu(ram& mem_ref, cpu_variant variant_ref = cpu_variant::nmos);
+	~cpu();
 	cpu(const cpu&) = delete;
 	cpu(cpu&&) = delete;
 	cpu& operator = (const cpu&) = delete;
 
 	void reset();
 
+	bool get_z() const { return z_value == 0; }
+	bool get_n() const { return (n_value & 0x80) != 0; }
+	bool get_v() const { return (v_value & 0x80) != 0; }
+
+	void set_z(bool value) { z_value = !value; }
+	void set_n(bool value) { n_value = value ? 0x80 : 0; }
+	void set_v(bool value) { v_value = value ? 0x80 : 0; }
+
+	// z and n of one result, nearly every operator ends with it
+	void set_nz(u8 result) { z_value = result; n_value = result; }
+
 	// fetches next byte, increments program counter
 	u8 next_byte();
 
+	// operand read of a running program, through the page table of mem
+	u8 read(u16 addr) const
+	{
+		return mem.read(addr);
+	}
+
+	// every write of a running program goes here, so decoded records see self-modifying code
+	// host writes through mem bypass it, call flush_decoded after them
+	void write(u16 addr, u8 value)
+	{
+		mem.write(addr, value);
+		if (code_pages[addr >> BIT_SIZE])
+		{
+			invalidate_page(u8(addr >> BIT_SIZE));
+		}
+	}
+
 	// automatically offsets for stack
 	void push(u8 bt);
 
@@ -84,7 +424,58 @@ struct cpu
 
 	void exe_op(u8 op);
 
-	void start(i32 operators = 0x7FFFFFFF);
+	// shared handler for every opcode that has no handler, stops the cpu with trap_code::unknown_op
+	static void trap_unknown_op(cpu& cpu_ref);
+
+	// HYP: runs registered host service, unregistered one sets carry and does nothing else
+	void hypercall(u8 service);
+
+	// engines return operators left of the budget, not 0 if they stopped earlier
+	i32 start(i32 operators = 0x7FFFFFFF);
+
+	i32 start_loop(i32 operators);
+
+	// start_loop for run_until while an IRQ waits on i, stops right after the operator that clears i and before breakpoints
+	i32 start_masked(i32 operators);
+
+	i32 start_threaded(i32 operators);
+
+	i32 start_predecoded(i32 operators, bool fuse);
+
+	// decodes instruction at 'addr' without storing it
+	decoded_op decode_single(u16 addr) const;
+
+	// decodes instruction (or fused pair) at 'addr' and marks every page it touches
+	const decoded_op& decode(u16 addr, bool fuse);
+
+	i32 start_jit(i32 operators);
+
+	i32 start_cached(i32 operators);
+
+	// Runs with the selected engine until a budget is used up, the cpu stops or a breakpoint or the host stops it.
+	// Budgets and the stop flag are checked between slices of at most RUN_SLICE_OPERATORS (shorter near the end of a budget),
+	// cycle budget is exact: it stops at the first operator boundary at or past it.
+	// Scheduled events and interrupts are handled between slices too, slices never run past the next event (see events_6502.h).
+	// Breakpoints end predecoded records and jit blocks, so engines see them only at block boundaries,
+	// loop, threaded and cached engines have no records and run on the predecoded one while breakpoints are set.
+	run_exit run_until(const run_limits& limits);
+
+	// installs breakpoints, drops decoded records and compiled blocks if they changed
+	void set_breakpoints(const std::vector<u16>& addrs);
+
+	bool at_breakpoint(u16 addr) const { return !break_at.empty() && break_at[addr]; }
+
+	// any breakpoint from 'first' to 'last', wraps around memory
+	bool breaks_within(u16 first, u16 last) const;
+
+	// asks running cached loop to write registers back at its next budget check (and call observer), safe from other threads
+	void request_sync() { sync_requested.store(true, std::memory_order_relaxed); }
+
+	// drops records and compiled blocks of the page and of instructions running into it from previous page
+	void invalidate_page(u8 page);
+
+	// drops every record and compiled block
+	void flush_decoded();
 };
 
 /// <summary>
@@ -290,9 +681,11 @@ namespace op
 
 	// status flag changes
 	constexpr u8 CLC		= 0x18; // clear carry flag
+	constexpr u8 CLD		= 0xD8; // clear decimal mode flag
 	constexpr u8 CLI		= 0x58; // clear interrupt disable flag
 	constexpr u8 CLV		= 0xB8; // clear overflow flag
 	constexpr u8 SEC		= 0x38; // set carry flag
+	constexpr u8 SED		= 0xF8; // set decimal mode flag
 	constexpr u8 SEI		= 0x78; // set interrupt disable flag
 
 	// system functions
@@ -300,4 +693,34 @@ namespace op
 	constexpr u8 RTI		= 0x40; // return from interrupt
 	constexpr u8 NOP		= 0xEA; // no operator
 	constexpr u8 KIL		= 0xFF;	// kill process - unofficial
+	constexpr u8 HYP		= 0x02;	// host hypercall - immediate service number, unofficial
+
+	// 65C02 only (cpu_variant::cmos)
+	constexpr u8 LDA_IN_ZP	= 0xB2;	// load accumulator - indirect zero page
+	constexpr u8 STA_IN_ZP	= 0x92;	// store accumulator - indirect zero page
+	constexpr u8 STZ_ZP		= 0x64;	// store zero - zero page
+	constexpr u8 STZ_ZP_X	= 0x74;	// store zero - zero page, x
+	constexpr u8 STZ_ABS	= 0x9C;	// store zero - absolute
+	constexpr u8 STZ_ABS_X	= 0x9E;	// store zero - absolute, x
+	constexpr u8 PHX		= 0xDA;	// push x register
+	constexpr u8 PHY		= 0x5A;	// push y register
+	constexpr u8 PLX		= 0xFA;	// pull x register
+	constexpr u8 PLY		= 0x7A;	// pull y register
+	constexpr u8 AND_IN_ZP	= 0x32;	// logical and - indirect zero page
+	constexpr u8 EOR_IN_ZP	= 0x52;	// logical xor - indirect zero page
+	constexpr u8 ORA_IN_ZP	= 0x12;	// logical or - indirect zero page
+	constexpr u8 BIT_IM		= 0x89;	// bit test - immediate, sets only z
+	constexpr u8 BIT_ZP_X	= 0x34;	// bit test - zero page, x
+	constexpr u8 BIT_ABS_X	= 0x3C;	// bit test - absolute, x
+	constexpr u8 TRB_ZP		= 0x14;	// test and reset bits - zero page
+	constexpr u8 TRB_ABS	= 0x1C;	// test and reset bits - absolute
+	constexpr u8 TSB_ZP		= 0x04;	// test and set bits - zero page
+	constexpr u8 TSB_ABS	= 0x0C;	// test and set bits - absolute
+	constexpr u8 ADC_IN_ZP	= 0x72;	// add with carry - indirect zero page
+	constexpr u8 SBC_IN_ZP	= 0xF2;	// subtract with carry - indirect zero page
+	constexpr u8 CMP_IN_ZP	= 0xD2;	// compare accumulator - indirect zero page
+	constexpr u8 INC_A		= 0x1A;	// increment accumulator
+	constexpr u8 DEC_A		= 0x3A;	// decrement accumulator
+	constexpr u8 JMP_IN_ABS_X	= 0x7C;	// jump - indirect absolute, x
+	constexpr u8 BRA		= 0x80;	// branch always
 }
\ No newline at end of file
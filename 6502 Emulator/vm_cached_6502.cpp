@@ -0,0 +1,179 @@
+#include <algorithm>
+
+#include "vm_6502.h"
+#include "op_policies_6502.h"
+
+// Register-cached run loop: pc, sp, a, x, y and flags are copied into local cpu_cache, which never leaves the loop,
+// so the compiler keeps them in host registers instead of reloading them from cpu around every handler.
+// Every opcode is its own switch case with handler instantiated for cpu_cache, the whole operator is inlined into the loop.
+// Registers are written back to cpu only at sync points:
+//   - exit
+//   - unknown operator (cpu::trap_unknown_op sees current registers)
+//   - hypercall (host service reads and writes registers in cpu)
+//   - budget check every cpu::sync_interval operators, if cpu::observer is set or cpu::request_sync was called
+// Stop conditions and pc stepping mirror cpu::start_loop exactly.
+
+// same members as cpu that op_policies use, registers by value
+struct cpu_cache
+{
+	cpu& owner;
+	ram& bus;	// page table for operands and the stack
+	u8* mem;
+	const u8* code_pages;
+
+	u16 pc;
+	u8 sp;
+	u8 a;
+	u8 x, y;
+	u8 c;
+	u8 z_value;
+	u8 n_value;
+	u8 v_value;
+	u8 i, d, b, k;
+	u64 cycles;
+
+	explicit cpu_cache(cpu& owner_ref) : owner(owner_ref), bus(owner_ref.mem), mem(owner_ref.mem.data), code_pages(owner_ref.code_pages.data())
+	{
+		load();
+	}
+
+	void load()
+	{
+		pc = owner.pc;
+		sp = owner.sp;
+		a = owner.a;
+		x = owner.x;
+		y = owner.y;
+		c = owner.c;
+		z_value = owner.z_value;
+		n_value = owner.n_value;
+		v_value = owner.v_value;
+		i = owner.i;
+		d = owner.d;
+		b = owner.b;
+		k = owner.k;
+		cycles = owner.cycles;
+	}
+
+	void store() const
+	{
+		owner.pc = pc;
+		owner.sp = sp;
+		owner.a = a;
+		owner.x = x;
+		owner.y = y;
+		owner.c = c;
+		owner.z_value = z_value;
+		owner.n_value = n_value;
+		owner.v_value = v_value;
+		owner.i = i;
+		owner.d = d;
+		owner.b = b;
+		owner.k = k;
+		owner.cycles = cycles;
+	}
+
+	bool get_z() const { return z_value == 0; }
+	bool get_n() const { return (n_value & 0x80) != 0; }
+	bool get_v() const { return (v_value & 0x80) != 0; }
+
+	void set_z(bool value) { z_value = !value; }
+	void set_n(bool value) { n_value = value ? 0x80 : 0; }
+	void set_v(bool value) { v_value = value ? 0x80 : 0; }
+
+	void set_nz(u8 result) { z_value = result; n_value = result; }
+
+	u8 next_byte()
+	{
+		return mem[++pc];
+	}
+
+	u8 read(u16 addr) const
+	{
+		return bus.read(addr);
+	}
+
+	void write(u16 addr, u8 value)
+	{
+		bus.write(addr, value);
+		if (code_pages[addr >> BIT_SIZE])
+		{
+			owner.invalidate_page(u8(addr >> BIT_SIZE));
+		}
+	}
+
+	void push(u8 bt)
+	{
+		write(u16(0x0100 + sp--), bt);
+	}
+
+	u8 pull()
+	{
+		return bus.read(u16(0x0100 + (++sp)));
+	}
+
+	// sync point
+	static void trap_unknown_op(cpu_cache& cache)
+	{
+		cache.store();
+		cpu::trap_unknown_op(cache.owner);
+		cache.load();
+	}
+
+	// sync point
+	void hypercall(u8 service)
+	{
+		store();
+		owner.hypercall(service);
+		load();
+	}
+};
+
+template <cpu_variant variant>
+static constexpr std::array<basic_op_entry<cpu_cache>, OP_TABLE_SIZE> cached_ops = make_op_entries<cpu_cache, variant>();
+
+#define CACHED_CASE(code)						\
+	case code:									\
+		cached_ops<variant>[code].exec(cache);	\
+		break;
+
+// a copy of the loop for every cpu_variant, start_cached picks one per run
+template <cpu_variant variant>
+static i32 run_cached(cpu& owner, i32 operators)
+{
+	cpu_cache cache(owner);
+
+	u8 op = cache.mem[cache.pc];
+	while (operators > 0 && !cache.k)
+	{
+		// budget check, nothing is synced inside a slice; clamped in u32 since operators > 0 bounds it to i32
+		i32 slice = i32(std::min(u32(operators), std::max(owner.sync_interval, 1u)));
+		operators -= slice;
+		for (; slice > 0 && !cache.k; op = cache.next_byte(), slice--)
+		{
+			switch (op)
+			{
+				OP_ALL(CACHED_CASE)
+			}
+		}
+		operators += slice;	// not run, k stopped the slice
+
+		if (owner.observer != nullptr || owner.sync_requested.load(std::memory_order_relaxed))
+		{
+			cache.store();
+			owner.sync_requested.store(false, std::memory_order_relaxed);
+			if (owner.observer != nullptr)
+			{
+				owner.observer(owner);
+			}
+			cache.load();
+		}
+	}
+	cache.store();
+	return operators;
+}
+
+i32 cpu::start_cached(i32 operators)
+{
+	return variant == cpu_variant::cmos ? run_cached<cpu_variant::cmos>(*this, operators) : run_cached<cpu_variant::nmos>(*this, operators);
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+
+#include "vm_6502.h"
+#include "op_policies_6502.h"
+#include "fusion_6502.h"
+#include "jit_6502.h"
+#include "idle_6502.h"
+#include "idiom_6502.h"
+#include "memo_6502.h"
+
+// Predecoded run loop: each address is decoded once into handler, raw operand and length,
+// then runs from the record without fetching or decoding through mem.
+// With fusion, a record may hold a pair of instructions (see fusion_6502.h) and counts as two operators.
+// Head of an idle loop is decoded alone and marked, whole passes of the loop are skipped from it (see idle_6502.h),
+// head of a copy/fill/multiply/divide loop the same way, its passes run natively (see idiom_6502.h).
+// With cpu::memoize, JSR records replay cached calls of pure subroutines (see memo_6502.h).
+// A breakpoint is decoded alone and marked, loops and pairs holding one aren't recognized, calls aren't memoized while any is set,
+// so the engine stops before it (unless it is the first record of the run) without checking pc per operator.
+// cpu::write drops records of a page as soon as a program writes into it.
+// Stop conditions and pc stepping mirror cpu::start_loop exactly.
+
+// longest record (or loop from its head) minus one, records this far back in previous page may run into next page
+constexpr u32 MAX_RECORD_TAIL_BYTES = std::max({ MAX_FUSED_BYTES, MAX_IDLE_LOOP_BYTES, MAX_IDIOM_LOOP_BYTES }) - 1;
+
+decoded_op cpu::decode_single(u16 addr) const
+{
+	const op_entry& entry = entries[mem[addr]];
+	decoded_op record;
+
+	record.handler = entry.exec_decoded;
+	record.length = entry.length;
+	if (entry.length == 2)
+	{
+		record.operand = mem[u16(addr + 1)];
+	}
+	else if (entry.length == 3)
+	{
+		record.operand = mem[u16(addr + 1)] | (mem[u16(addr + 2)] << BIT_SIZE);
+	}
+	return record;
+}
+
+const decoded_op& cpu::decode(u16 addr, bool fuse)
+{
+	decoded_op& record = decoded[addr];
+
+	record = decode_single(addr);
+	u16 last = u16(addr + record.length - 1);
+	idle_loop idle = skip_idle ? match_idle_loop(mem, addr) : idle_loop();
+	if (idle.kind != idle_kind::none && breaks_within(addr, u16(addr + idle.length - 1)))
+	{
+		idle = idle_loop();
+	}
+	idiom_loop idiom = run_idioms && idle.kind == idle_kind::none ? match_idiom(mem, addr) : idiom_loop();
+	if (idiom.kind != idiom_kind::none && breaks_within(addr, u16(addr + idiom.length - 1)))
+	{
+		idiom = idiom_loop();
+	}
+	if (at_breakpoint(addr))
+	{
+		record.head = head_kind::breakpoint;
+	}
+	else if (idle.kind != idle_kind::none)
+	{
+		record.head = head_kind::idle;
+		last = u16(addr + idle.length - 1);
+	}
+	else if (idiom.kind != idiom_kind::none)
+	{
+		record.head = head_kind::idiom;
+		last = u16(addr + idiom.length - 1);
+	}
+	else if (memoize && break_at.empty() && mem[addr] == op::JSR_ABS)
+	{
+		record.head = head_kind::call;
+	}
+	else if (fuse)
+	{
+		u16 next = u16(addr + record.length);
+		decoded_handler fused = find_fused(mem[addr], mem[next]);
+		if (fused != nullptr && !at_breakpoint(next))
+		{
+			decoded_op second = decode_single(next);
+			record.handler = fused;
+			record.operand |= second.operand << ((record.length - 1) * BIT_SIZE);
+			record.length += second.length;
+			record.operators = 2;
+			last = u16(addr + record.length - 1);
+		}
+	}
+
+	code_pages[addr >> BIT_SIZE] = true;
+	code_pages[last >> BIT_SIZE] = true;
+	return record;
+}
+void cpu::invalidate_page(u8 page)
+{
+	u16 first = u16(page << BIT_SIZE);
+
+	code_pages[page] = false;
+	if (!decoded.empty())
+	{
+		for (u32 i = 0; i < RAM_PAGE_SIZE; i++)
+		{
+			decoded[u16(first + i)].handler = nullptr;
+		}
+		for (u32 i = 1; i <= MAX_RECORD_TAIL_BYTES; i++)
+		{
+			decoded[u16(first - i)].handler = nullptr;
+		}
+	}
+	if (jit)
+	{
+		jit->invalidate_page(page);
+	}
+	if (memo)
+	{
+		memo->invalidate_page(page);
+	}
+}
+
+void cpu::flush_decoded()
+{
+	for (u32 page = 0; page < RAM_PAGE_COUNT; page++)
+	{
+		if (code_pages[page])
+		{
+			invalidate_page(u8(page));
+		}
+	}
+}
+
+i32 cpu::start_predecoded(i32 operators, bool fuse)
+{
+	if (decoded.empty())
+	{
+		decoded.resize(MAX_RAM_BYTES);
+	}
+	if (decoded_fused != fuse)
+	{
+		flush_decoded();
+		decoded_fused = fuse;
+	}
+
+	// records never move while running, only their content is dropped
+	decoded_op* records = decoded.data();
+	const i32 budget = operators;
+	for (; operators > 0 && !k; )
+	{
+		const decoded_op* record = &records[pc];
+		if (record->handler == nullptr)
+		{
+			record = &decode(pc, fuse);
+		}
+
+		if (record->head != head_kind::none)
+		{
+			i32 done = 0;
+			switch (record->head)
+			{
+			case head_kind::breakpoint:
+				if (operators != budget)
+				{
+					return operators;
+				}
+				break;
+			case head_kind::idle:
+				done = skip_idle_loop(*this, match_idle_loop(mem, pc), operators);
+				break;
+			case head_kind::idiom:
+				done = run_idiom(*this, match_idiom(mem, pc), operators);
+				break;
+			case head_kind::call:
+				done = run_memoized(*this, operators);
+				break;
+			default:
+				break;
+			}
+			if (done > 0)
+			{
+				operators -= done;
+				continue;
+			}
+		}
+
+		// fused pair doesn't fit into what is left, run its first instruction alone
+		decoded_op single;
+		if (record->operators > operators)
+		{
+			single = decode_single(pc);
+			record = &single;
+		}
+
+		// handler may invalidate its own record, so everything is read before the call
+		decoded_handler handler = record->handler;
+		u16 operand = record->operand;
+		operators -= record->operators;
+		pc += record->length - 1;
+		handler(*this, operand);
+		pc++;
+	}
+	return operators;
+}
@@ -0,0 +1,53 @@
+#include "vm_6502.h"
+#include "op_policies_6502.h"
+
+// Threaded run loop: every handler block ends with its own copy of the dispatch,
+// so host branch predictor learns "which op follows which op" instead of one shared indirect jump.
+// Stop conditions and pc stepping mirror cpu::start_loop exactly.
+// Handlers are taken from constexpr copy of op_table, so each block calls its handler directly and can inline it.
+// There is a copy of the loop for every cpu_variant, start_threaded picks one per run.
+
+#ifdef THREADED_6502
+
+template <cpu_variant variant>
+static constexpr std::array<op_handler, OP_TABLE_SIZE> threaded_ops = make_op_table<variant>();
+
+#define THREADED_LABEL(code) &&op_##code,
+#define THREADED_BLOCK(code)				\
+	op_##code:								\
+		threaded_ops<variant>[code](c);		\
+		op = c.next_byte();					\
+		if (--operators <= 0 || c.k)		\
+		{									\
+			return operators;				\
+		}									\
+		goto *labels[op];
+
+template <cpu_variant variant>
+static i32 run_threaded(cpu& c, i32 operators)
+{
+	static void* const labels[OP_TABLE_SIZE] = { OP_ALL(THREADED_LABEL) };
+
+	u8 op = c.mem[c.pc];
+	if (operators <= 0 || c.k)
+	{
+		return operators;
+	}
+	goto *labels[op];
+
+	OP_ALL(THREADED_BLOCK)
+}
+
+i32 cpu::start_threaded(i32 operators)
+{
+	return variant == cpu_variant::cmos ? run_threaded<cpu_variant::cmos>(*this, operators) : run_threaded<cpu_variant::nmos>(*this, operators);
+}
+
+#else
+
+i32 cpu::start_threaded(i32 operators)
+{
+	return start_loop(operators);
+}
+
+#endif // THREADED_6502